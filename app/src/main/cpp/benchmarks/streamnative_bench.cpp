@@ -0,0 +1,936 @@
+// Host benchmark for the streamnative core.
+//
+// Replays recorded LLM transcripts through MarkdownSession::push (block and
+// inline sessions) and splitByXml, the same way the Kotlin side feeds them,
+// and reports throughput, emitted segments and heap allocations. Only
+// measures; the behavior it times is checked by streamnative_tests (tests/).
+//
+// Usage: streamnative_bench [--min-time-ms=N] [--filter=TEXT] [transcript.md ...]
+// Without transcript arguments every *.md under benchmarks/transcripts is used.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "replay.h"
+
+#include "streamnative/ChatMarkupScanner.h"
+#include "streamnative/JsonXmlConverter.h"
+#include "streamnative/MarkdownParser.h"
+#include "streamnative/StreamOperators.h"
+
+namespace {
+
+using namespace harness;
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    double minTimeMs = 200.0;
+    std::string filter;
+    std::vector<std::string> files;
+};
+
+struct Measurement {
+    uint64_t chars = 0;
+    uint64_t calls = 0;
+    uint64_t segments = 0;
+    uint64_t allocs = 0;
+    double seconds = 0.0;
+    int passes = 0;
+};
+
+std::string formatRate(double perSecond) {
+    char buf[32];
+    if (perSecond >= 1e9) {
+        std::snprintf(buf, sizeof(buf), "%.2fG", perSecond / 1e9);
+    } else if (perSecond >= 1e6) {
+        std::snprintf(buf, sizeof(buf), "%.2fM", perSecond / 1e6);
+    } else if (perSecond >= 1e3) {
+        std::snprintf(buf, sizeof(buf), "%.2fK", perSecond / 1e3);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.0f", perSecond);
+    }
+    return buf;
+}
+
+void printHeader(const char* title) {
+    std::printf("\n== %s\n", title);
+    std::printf("%-16s %-8s %-8s %12s %10s %12s\n", "transcript", "session", "chunks", "chars/s", "segments", "allocs/call");
+}
+
+void printRow(const std::string& transcript, const char* session, const char* chunking, const Measurement& m) {
+    const double charsPerSec = m.seconds > 0.0 ? static_cast<double>(m.chars) / m.seconds : 0.0;
+    const double allocsPerCall = m.calls > 0 ? static_cast<double>(m.allocs) / static_cast<double>(m.calls) : 0.0;
+    const uint64_t segmentsPerPass = m.passes > 0 ? m.segments / static_cast<uint64_t>(m.passes) : 0;
+    std::printf(
+            "%-16s %-8s %-8s %12s %10llu %12.2f\n",
+            transcript.c_str(),
+            session,
+            chunking,
+            formatRate(charsPerSec).c_str(),
+            static_cast<unsigned long long>(segmentsPerPass),
+            allocsPerCall
+    );
+}
+
+using SessionMeasure = Measurement (*)(SessionFactory, const Transcript&, const std::vector<Chunk>&, double);
+
+Measurement measureSession(SessionFactory createSession, const Transcript& t, const std::vector<Chunk>& chunks, double minTimeMs) {
+    Measurement m;
+    const char16_t* base = t.text.data();
+    do {
+        streamnative::MarkdownSession* session = createSession();
+        uint64_t segments = 0;
+        const uint64_t allocsBefore = allocationCount();
+        const auto start = Clock::now();
+        for (const auto& chunk : chunks) {
+            segments += streamnative::markdownSessionPush(session, base + chunk.start, chunk.len).size();
+        }
+        const auto end = Clock::now();
+        m.allocs += allocationCount() - allocsBefore;
+        streamnative::destroyMarkdownSession(session);
+        m.seconds += std::chrono::duration<double>(end - start).count();
+        m.segments += segments;
+        m.calls += chunks.size();
+        m.chars += t.text.size();
+        m.passes += 1;
+    } while (m.seconds * 1000.0 < minTimeMs);
+    return m;
+}
+
+// With copyInput, the text is first copied into a fresh buffer the way
+// GetStringChars does when ART cannot pin the string.
+Measurement measureSplitByXml(const Transcript& t, double minTimeMs, bool copyInput = false) {
+    Measurement m;
+    do {
+        const uint64_t allocsBefore = allocationCount();
+        const auto start = Clock::now();
+        std::vector<streamnative::Segment> segments;
+        if (copyInput) {
+            const std::u16string copy(t.text);
+            segments = streamnative::splitByXml(copy.data(), static_cast<int>(copy.size()));
+        } else {
+            segments = streamnative::splitByXml(t.text.data(), static_cast<int>(t.text.size()));
+        }
+        const auto end = Clock::now();
+        m.allocs += allocationCount() - allocsBefore;
+        m.seconds += std::chrono::duration<double>(end - start).count();
+        m.segments += segments.size();
+        m.calls += 1;
+        m.chars += t.text.size();
+        m.passes += 1;
+    } while (m.seconds * 1000.0 < minTimeMs);
+    return m;
+}
+
+bool matchesFilter(const Options& opts, const std::string& label) {
+    return opts.filter.empty() || label.find(opts.filter) != std::string::npos;
+}
+
+// Same as measureSession, but segments go through the shared ring the Kotlin
+// side uses; the reader drains after every push like flushDelta does.
+Measurement measureSessionRing(SessionFactory createSession, const Transcript& t, const std::vector<Chunk>& chunks, double minTimeMs) {
+    constexpr int kCapacity = 256;
+    std::vector<int32_t> ring(streamnative::RING_HEADER_INTS + kCapacity * 3);
+    Measurement m;
+    const char16_t* base = t.text.data();
+    do {
+        streamnative::MarkdownSession* session = createSession();
+        streamnative::attachMarkdownSessionRing(session, ring.data(), kCapacity);
+        uint64_t segments = 0;
+        const uint64_t allocsBefore = allocationCount();
+        const auto start = Clock::now();
+        for (const auto& chunk : chunks) {
+            int published = streamnative::markdownSessionPushToRing(session, base + chunk.start, chunk.len);
+            while (published > 0) {
+                segments += static_cast<uint64_t>(published);
+                ring[streamnative::RING_READ_INDEX] += published;
+                published = streamnative::markdownSessionDrainRing(session);
+            }
+        }
+        const auto end = Clock::now();
+        m.allocs += allocationCount() - allocsBefore;
+        streamnative::destroyMarkdownSession(session);
+        m.seconds += std::chrono::duration<double>(end - start).count();
+        m.segments += segments;
+        m.calls += chunks.size();
+        m.chars += t.text.size();
+        m.passes += 1;
+    } while (m.seconds * 1000.0 < minTimeMs);
+    return m;
+}
+
+void benchSessions(const Options& opts, const std::vector<Transcript>& transcripts,
+                   const char* title, SessionMeasure measure) {
+    struct SessionKind {
+        const char* name;
+        SessionFactory create;
+    };
+    const SessionKind kinds[] = {
+            {"block", &streamnative::createMarkdownBlockSession},
+#if STREAMNATIVE_VIRTUAL_BASELINE
+            {"block-v", &streamnative::createMarkdownBlockSessionVirtual},
+#endif
+            {"inline", &streamnative::createMarkdownInlineSession},
+#if STREAMNATIVE_VIRTUAL_BASELINE
+            {"inline-v", &streamnative::createMarkdownInlineSessionVirtual},
+#endif
+            {"nested", &streamnative::createMarkdownNestedSession},
+    };
+    const ChunkMode modes[] = {ChunkMode::CHAR, ChunkMode::TOKEN, ChunkMode::MESSAGE};
+
+    printHeader(title);
+    for (const auto& t : transcripts) {
+        for (const auto& kind : kinds) {
+            for (ChunkMode mode : modes) {
+                const std::string label = t.name + "/" + kind.name + "/" + chunkModeName(mode);
+                if (!matchesFilter(opts, label)) {
+                    continue;
+                }
+                const std::vector<Chunk> chunks = makeChunks(t.text, mode);
+                const Measurement m = measure(kind.create, t, chunks, opts.minTimeMs);
+                printRow(t.name, kind.name, chunkModeName(mode), m);
+            }
+        }
+    }
+}
+
+// Re-rendering a 200KB message from its last checkpoint versus from scratch
+// (nested session, checkpoint every 16K characters).
+void benchCheckpointResume(const Options& opts, const std::vector<Transcript>& transcripts) {
+    Transcript big;
+    big.name = "200KB";
+    while (big.text.size() < 200 * 1024) {
+        for (const auto& t : transcripts) {
+            big.text += t.text;
+        }
+    }
+    big.text.resize(200 * 1024);
+    if (!matchesFilter(opts, "200KB/nested/checkpoint")) {
+        return;
+    }
+    const std::vector<Chunk> chunks = makeChunks(big.text, ChunkMode::TOKEN);
+    streamnative::MarkdownSession* session = streamnative::createMarkdownNestedSession();
+    streamnative::markdownSessionSetCheckpointInterval(session, 16 * 1024);
+    for (const auto& chunk : chunks) {
+        streamnative::markdownSessionPush(session, big.text.data() + chunk.start, chunk.len);
+    }
+    const int length = static_cast<int>(big.text.size());
+    const std::vector<uint8_t> checkpoint = *streamnative::markdownSessionCheckpointAt(session, length);
+    streamnative::destroyMarkdownSession(session);
+    const int offset = streamnative::markdownSnapshotOffset(checkpoint.data(), static_cast<int>(checkpoint.size()));
+
+    Measurement full;
+    Measurement resume;
+    do {
+        auto start = Clock::now();
+        streamnative::MarkdownSession* fresh = streamnative::createMarkdownNestedSession();
+        full.segments += streamnative::markdownSessionPush(fresh, big.text.data(), length).size();
+        streamnative::destroyMarkdownSession(fresh);
+        full.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        full.chars += static_cast<uint64_t>(length);
+        full.calls += 1;
+        full.passes += 1;
+
+        start = Clock::now();
+        streamnative::MarkdownSession* resumed = streamnative::createMarkdownNestedSession();
+        streamnative::markdownSessionRestoreState(resumed, checkpoint.data(), static_cast<int>(checkpoint.size()));
+        resume.segments += streamnative::markdownSessionPush(resumed, big.text.data() + offset, length - offset).size();
+        streamnative::destroyMarkdownSession(resumed);
+        resume.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        resume.chars += static_cast<uint64_t>(length);
+        resume.calls += 1;
+        resume.passes += 1;
+    } while (full.seconds * 1000.0 < opts.minTimeMs);
+
+    std::printf("\n== checkpoint resume (nested session, checkpoint every 16K chars)\n");
+    std::printf("%-16s %-8s %12s %12s\n", "transcript", "mode", "ms/render", "tail chars");
+    std::printf("%-16s %-8s %12.3f %12d\n", big.name.c_str(), "full", full.seconds * 1000.0 / full.passes, length);
+    std::printf("%-16s %-8s %12.3f %12d\n", big.name.c_str(), "resume", resume.seconds * 1000.0 / resume.passes, length - offset);
+}
+
+void benchSplitByXml(const Options& opts, const std::vector<Transcript>& transcripts) {
+    printHeader("splitByXml");
+    for (const auto& t : transcripts) {
+        const std::string label = t.name + "/xml/message";
+        if (!matchesFilter(opts, label)) {
+            continue;
+        }
+        const Measurement m = measureSplitByXml(t, opts.minTimeMs);
+        printRow(t.name, "xml", "message", m);
+    }
+}
+
+// Re-rendering a growing message: full parseMarkdown of the prefix after every
+// token versus IncrementalMarkdownParser::append of the token.
+Measurement measureParseGrowing(const Transcript& t, const std::vector<Chunk>& chunks, bool incremental, double minTimeMs) {
+    Measurement m;
+    const char16_t* base = t.text.data();
+    do {
+        uint64_t blocks = 0;
+        const uint64_t allocsBefore = allocationCount();
+        const auto start = Clock::now();
+        if (incremental) {
+            streamnative::IncrementalMarkdownParser parser;
+            for (const auto& chunk : chunks) {
+                parser.append(base + chunk.start, chunk.len);
+            }
+            blocks = parser.nodes().blockCount;
+        } else {
+            for (const auto& chunk : chunks) {
+                blocks = streamnative::parseMarkdown(base, chunk.start + chunk.len).blockCount;
+            }
+        }
+        const auto end = Clock::now();
+        m.allocs += allocationCount() - allocsBefore;
+        m.seconds += std::chrono::duration<double>(end - start).count();
+        m.segments += blocks;
+        m.calls += chunks.size();
+        m.chars += t.text.size();
+        m.passes += 1;
+    } while (m.seconds * 1000.0 < minTimeMs);
+    return m;
+}
+
+void benchParseGrowing(const Options& opts, const std::vector<Transcript>& transcripts) {
+    printHeader("parseMarkdown per token (segments = blocks)");
+    for (const auto& t : transcripts) {
+        const std::vector<Chunk> chunks = makeChunks(t.text, ChunkMode::TOKEN);
+        for (bool incremental : {false, true}) {
+            const char* session = incremental ? "append" : "full";
+            if (!matchesFilter(opts, t.name + "/" + session + "/token")) {
+                continue;
+            }
+            const Measurement m = measureParseGrowing(t, chunks, incremental, opts.minTimeMs);
+            printRow(t.name, session, "token", m);
+        }
+    }
+}
+
+// Whole-document parseMarkdownParallel at 1 to 8 threads on documents built
+// from the transcripts.
+void benchParseParallel(const Options& opts, const std::vector<Transcript>& transcripts) {
+    std::u16string corpus;
+    for (const auto& t : transcripts) {
+        corpus += t.text;
+        corpus += u"\n\n";
+    }
+
+    struct Size {
+        const char* name;
+        size_t chars;
+    };
+    const Size sizes[] = {{"256KB", 256 * 1024}, {"1MB", 1024 * 1024}};
+    const int threadCounts[] = {1, 2, 4, 8};
+
+    printHeader("parseMarkdownParallel (segments = blocks, session = threads)");
+    for (const auto& size : sizes) {
+        Transcript t;
+        t.name = size.name;
+        while (t.text.size() < size.chars) {
+            t.text += corpus;
+        }
+        t.text.resize(size.chars);
+        const int len = static_cast<int>(t.text.size());
+
+        for (int threads : threadCounts) {
+            const std::string threadName = std::to_string(threads);
+            if (!matchesFilter(opts, t.name + "/" + threadName + "/parallel")) {
+                continue;
+            }
+            Measurement m;
+            do {
+                const uint64_t allocsBefore = allocationCount();
+                const auto start = Clock::now();
+                const size_t blocks = streamnative::parseMarkdownParallel(t.text.data(), len, threads).blockCount;
+                const auto end = Clock::now();
+                m.allocs += allocationCount() - allocsBefore;
+                m.seconds += std::chrono::duration<double>(end - start).count();
+                m.segments += blocks;
+                m.calls += 1;
+                m.chars += static_cast<uint64_t>(len);
+                m.passes += 1;
+            } while (m.seconds * 1000.0 < opts.minTimeMs);
+            printRow(t.name, threadName.c_str(), "whole", m);
+        }
+    }
+}
+
+double measureParseNsPerChar(const std::u16string& text, double minTimeMs) {
+    double best = 0.0;
+    double total = 0.0;
+    do {
+        const auto start = Clock::now();
+        streamnative::parseMarkdown(text.data(), static_cast<int>(text.size()));
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        best = best == 0.0 ? seconds : std::min(best, seconds);
+        total += seconds;
+    } while (total * 1000.0 < minTimeMs);
+    return best * 1e9 / static_cast<double>(text.size());
+}
+
+// parseMarkdown on single lines full of inline openers that never close
+// (brackets, links missing their ')', backtick runs, ...): time per character
+// at 10KB and 100KB. Linear parsing keeps the growth near 1.
+void benchParseLongLines(const Options& opts) {
+    struct Case {
+        const char* name;
+        std::u16string unit;
+    };
+    std::vector<Case> cases = {
+            {"brackets", u"["},     {"link-paren", u"[a](b"}, {"ticks", u"`"},
+            {"tick-runs", u"``` a"}, {"stars", u"**a*"},      {"tildes", u"~~a"},
+    };
+    {
+        const char16_t alphabet[] = u"[]()*_~` ab";
+        std::u16string mix;
+        uint32_t seed = 4242;
+        while (mix.size() < 4096) {
+            seed = seed * 1103515245u + 12345u;
+            mix.push_back(alphabet[(seed >> 16) % (sizeof(alphabet) / sizeof(alphabet[0]) - 1)]);
+        }
+        cases.push_back({"random-mix", mix});
+    }
+    std::printf("\n== parseMarkdown on one long line\n");
+    std::printf("%-12s %12s %12s %8s\n", "input", "ns/char 10K", "ns/char 100K", "growth");
+    for (const auto& c : cases) {
+        if (!matchesFilter(opts, std::string(c.name) + "/longline")) {
+            continue;
+        }
+        // A leading letter keeps the line out of the block rules (fences, quotes, ...).
+        std::u16string small = u"a";
+        while (small.size() < 10 * 1024) {
+            small += c.unit;
+        }
+        std::u16string large = u"a";
+        while (large.size() < 100 * 1024) {
+            large += c.unit;
+        }
+        const double a = measureParseNsPerChar(small, opts.minTimeMs);
+        const double b = measureParseNsPerChar(large, opts.minTimeMs);
+        const double growth = a > 0.0 ? b / a : 0.0;
+        std::printf("%-12s %12.1f %12.1f %8.2f\n", c.name, a, b, growth);
+    }
+}
+
+// Splitting a growing message per token: XmlSplitSession pushes versus
+// splitByXml over the whole prefix after every token (what re-splitting the
+// message did), plus whole-message splitByXml with the tag index.
+void benchXmlSplitSession(const Options& opts, const std::vector<Transcript>& transcripts) {
+    using namespace streamnative;
+    auto pushAll = [](const std::u16string& text, const std::vector<Chunk>& chunks) {
+        std::vector<Segment> all;
+        XmlSplitSession* session = createXmlSplitSession();
+        for (const auto& chunk : chunks) {
+            const std::vector<Segment> segments = xmlSplitSessionPush(session, text.data() + chunk.start, chunk.len);
+            all.insert(all.end(), segments.begin(), segments.end());
+        }
+        const std::vector<Segment> rest = xmlSplitSessionFinish(session);
+        all.insert(all.end(), rest.begin(), rest.end());
+        destroyXmlSplitSession(session);
+        return mergeTextRuns(all);
+    };
+
+    printHeader("XmlSplitSession (growing message)");
+    for (const auto& t : transcripts) {
+        const std::vector<Chunk> chunks = makeChunks(t.text, ChunkMode::TOKEN);
+        for (bool session : {true, false}) {
+            const char* name = session ? "session" : "prefix";
+            if (!matchesFilter(opts, t.name + "/" + name + "/xml")) {
+                continue;
+            }
+            Measurement m;
+            do {
+                const uint64_t allocsBefore = allocationCount();
+                const auto start = Clock::now();
+                size_t segments = 0;
+                if (session) {
+                    segments = pushAll(t.text, chunks).size();
+                } else {
+                    for (const auto& chunk : chunks) {
+                        segments = splitByXml(t.text.data(), chunk.start + chunk.len).size();
+                    }
+                }
+                const auto end = Clock::now();
+                m.allocs += allocationCount() - allocsBefore;
+                m.seconds += std::chrono::duration<double>(end - start).count();
+                m.segments += segments;
+                m.calls += chunks.size();
+                m.chars += t.text.size();
+                m.passes += 1;
+            } while (m.seconds * 1000.0 < opts.minTimeMs);
+            printRow(t.name, name, "token", m);
+        }
+        if (!matchesFilter(opts, t.name + "/indexed/xml")) {
+            continue;
+        }
+        Measurement m;
+        do {
+            std::vector<Segment> entries;
+            const uint64_t allocsBefore = allocationCount();
+            const auto start = Clock::now();
+            const std::vector<Segment> segments = splitByXml(t.text.data(), static_cast<int>(t.text.size()), entries);
+            const auto end = Clock::now();
+            m.allocs += allocationCount() - allocsBefore;
+            m.seconds += std::chrono::duration<double>(end - start).count();
+            m.segments += segments.size();
+            m.calls += 1;
+            m.chars += t.text.size();
+            m.passes += 1;
+        } while (m.seconds * 1000.0 < opts.minTimeMs);
+        printRow(t.name, "indexed", "message", m);
+    }
+}
+
+// JSON session over tool-call style documents (text, then objects with long
+// escaped string values).
+void benchJsonSession(const Options& opts) {
+    using namespace streamnative;
+    std::u16string body;
+    for (int k = 0; k < 64; k++) {
+        body += u"line of file content with \\\"quotes\\\" and \\u00e9 escapes\\n";
+    }
+    std::u16string call = u"Writing the file now.\n{\"tool\": \"write_file\", \"params\": {\"path\": \"src/a.kt\", "
+                          u"\"overwrite\": true, \"lines\": [1, 2.5, -3e2, null], \"content\": \"";
+    call += body;
+    call += u"\"}}\n\n";
+
+    Transcript t;
+    t.name = "256KB";
+    while (t.text.size() < 256 * 1024) {
+        t.text += call;
+    }
+
+    printHeader("JSON session (tool calls with long string values)");
+    const ChunkMode modes[] = {ChunkMode::CHAR, ChunkMode::TOKEN, ChunkMode::MESSAGE};
+    for (ChunkMode mode : modes) {
+        if (!matchesFilter(opts, t.name + "/json/" + chunkModeName(mode))) {
+            continue;
+        }
+        const std::vector<Chunk> chunks = makeChunks(t.text, mode);
+        const Measurement m = measureSession(&createJsonSession, t, chunks, opts.minTimeMs);
+        printRow(t.name, "json", chunkModeName(mode), m);
+    }
+}
+
+// scanChatMarkup against the regex chain it replaces, on ~100KB documents
+// built from each transcript wrapped in thinking, status and emotion tags.
+void benchChatMarkup(const Options& opts, const std::vector<Transcript>& transcripts) {
+    using namespace streamnative;
+    const RegexStripChain chain;
+    printHeader("Chat markup stripping (100KB documents, segments = matches)");
+    for (const auto& t : transcripts) {
+        Transcript doc;
+        doc.name = t.name;
+        while (doc.text.size() < 100 * 1024) {
+            doc.text += u"<status type=\"thinking\"/>\n<thinking>\n" + t.text + u"\n</thinking>\n" + t.text +
+                        u"\n<emotion>happy</emotion>\n<status type=\"complete\"></status>\n";
+        }
+        std::vector<Segment> docMatches;
+        for (bool native : {true, false}) {
+            const char* name = native ? "scanner" : "regex";
+            if (!matchesFilter(opts, doc.name + "/" + name + "/markup")) {
+                continue;
+            }
+            Measurement m;
+            do {
+                const uint64_t allocsBefore = allocationCount();
+                const auto start = Clock::now();
+                if (native) {
+                    docMatches.clear();
+                    scanChatMarkup(doc.text.data(), static_cast<int>(doc.text.size()), CHAT_MARKUP_ALL, docMatches);
+                    m.segments += docMatches.size();
+                } else {
+                    size_t removed = 0;
+                    chain.strip(doc.text, removed);
+                    m.segments += removed;
+                }
+                const auto end = Clock::now();
+                m.allocs += allocationCount() - allocsBefore;
+                m.seconds += std::chrono::duration<double>(end - start).count();
+                m.calls += 1;
+                m.chars += doc.text.size();
+                m.passes += 1;
+            } while (m.seconds * 1000.0 < opts.minTimeMs);
+            printRow(doc.name, name, "message", m);
+        }
+    }
+}
+
+// Tool-call arguments through JsonXmlConverter: the 256KB arguments of a
+// file write under every chunking.
+void benchJsonXmlConverter(const Options& opts) {
+    Transcript t;
+    t.name = "256KB";
+    t.text = u"{\"path\": \"src/Main.kt\", \"content\": \"";
+    while (t.text.size() < 256 * 1024) {
+        t.text += u"    if (a < b && c > d) println(\\\"value: \\u00e9\\\")\\n";
+    }
+    t.text += u"\", \"overwrite\": true}";
+
+    printHeader("JsonXmlConverter (tool-call arguments, segments = events)");
+    for (ChunkMode mode : {ChunkMode::CHAR, ChunkMode::TOKEN, ChunkMode::MESSAGE}) {
+        if (!matchesFilter(opts, t.name + "/json-xml/" + chunkModeName(mode))) {
+            continue;
+        }
+        const std::vector<Chunk> chunks = makeChunks(t.text, mode);
+        Measurement m;
+        std::vector<int32_t> events;
+        do {
+            streamnative::JsonXmlConverter converter;
+            const uint64_t allocsBefore = allocationCount();
+            const auto start = Clock::now();
+            for (const auto& chunk : chunks) {
+                events.clear();
+                converter.push(t.text.data() + chunk.start, chunk.len, events);
+                m.segments += events.size() / 3;
+            }
+            const auto end = Clock::now();
+            m.allocs += allocationCount() - allocsBefore;
+            m.seconds += std::chrono::duration<double>(end - start).count();
+            m.calls += chunks.size();
+            m.chars += t.text.size();
+            m.passes += 1;
+        } while (m.seconds * 1000.0 < opts.minTimeMs);
+        printRow(t.name, "json-xml", chunkModeName(mode), m);
+    }
+}
+
+// Segment payload of token-by-token pushes as int triples (what nativePush
+// hands to Kotlin) and in the compact wire format.
+void benchCompactWire(const Options& opts, const std::vector<Transcript>& transcripts) {
+    struct SessionKind {
+        const char* name;
+        SessionFactory create;
+    };
+    const SessionKind kinds[] = {
+            {"block", &streamnative::createMarkdownBlockSession},
+            {"inline", &streamnative::createMarkdownInlineSession},
+            {"nested", &streamnative::createMarkdownNestedSession},
+            {"hnested", &createHashedNestedSession},
+    };
+
+    std::printf("\n== compact segment wire format (token chunks)\n");
+    std::printf("%-16s %-8s %10s %12s %12s %8s\n", "transcript", "session", "segments", "int bytes", "wire bytes", "ratio");
+    for (const auto& t : transcripts) {
+        const std::vector<Chunk> chunks = makeChunks(t.text, ChunkMode::TOKEN);
+        for (const auto& kind : kinds) {
+            if (!matchesFilter(opts, t.name + "/" + kind.name + "/wire")) {
+                continue;
+            }
+            streamnative::MarkdownSession* plain = kind.create();
+            streamnative::MarkdownSession* compact = kind.create();
+            size_t segmentCount = 0;
+            size_t wireBytes = 0;
+            for (const auto& chunk : chunks) {
+                segmentCount += streamnative::markdownSessionPush(plain, t.text.data() + chunk.start, chunk.len).size();
+                wireBytes += streamnative::markdownSessionPushCompact(compact, t.text.data() + chunk.start, chunk.len).size();
+            }
+            streamnative::destroyMarkdownSession(plain);
+            streamnative::destroyMarkdownSession(compact);
+
+            const size_t intBytes = segmentCount * 3 * sizeof(int32_t);
+            std::printf("%-16s %-8s %10zu %12zu %12zu %8.2f\n", t.name.c_str(), kind.name, segmentCount, intBytes,
+                        wireBytes, intBytes > 0 ? static_cast<double>(wireBytes) / static_cast<double>(intBytes) : 0.0);
+        }
+    }
+}
+
+// What block hashes cost a token-chunked push.
+void benchBlockHashes(const Options& opts, const std::vector<Transcript>& transcripts) {
+    printHeader("block hashes (segments include the hash segments)");
+    for (const auto& t : transcripts) {
+        if (!matchesFilter(opts, t.name + "/hashed/blockhash")) {
+            continue;
+        }
+        const std::vector<Chunk> tokens = makeChunks(t.text, ChunkMode::TOKEN);
+        printRow(t.name, "block", "token", measureSession(&streamnative::createMarkdownBlockSession, t, tokens, opts.minTimeMs));
+        printRow(t.name, "hashed", "token", measureSession(&createHashedBlockSession, t, tokens, opts.minTimeMs));
+    }
+}
+
+Measurement measureSessionUtf8(const std::string& bytes, const std::vector<std::pair<size_t, size_t>>& chunks,
+                               double minTimeMs) {
+    Measurement m;
+    const auto* data = reinterpret_cast<const uint8_t*>(bytes.data());
+    do {
+        streamnative::MarkdownSession* session = streamnative::createMarkdownBlockSession();
+        uint64_t segments = 0;
+        const uint64_t allocsBefore = allocationCount();
+        const auto start = Clock::now();
+        for (const auto& chunk : chunks) {
+            segments += streamnative::markdownSessionPush(session, data + chunk.first, static_cast<int>(chunk.second)).size();
+        }
+        const auto end = Clock::now();
+        m.allocs += allocationCount() - allocsBefore;
+        streamnative::destroyMarkdownSession(session);
+        m.seconds += std::chrono::duration<double>(end - start).count();
+        m.segments += segments;
+        m.calls += chunks.size();
+        m.chars += bytes.size();
+        m.passes += 1;
+    } while (m.seconds * 1000.0 < minTimeMs);
+    return m;
+}
+
+// Token-chunk throughput of UTF-8 input versus the same text as UTF-16
+// (chars/s counts bytes for UTF-8).
+void benchUtf8Input(const Options& opts, const std::vector<Transcript>& transcripts) {
+    printHeader("UTF-8 input (token chunks, block session)");
+    for (const auto& t : transcripts) {
+        if (!matchesFilter(opts, t.name + "/utf8/block")) {
+            continue;
+        }
+        const std::vector<Chunk> chunks = makeChunks(t.text, ChunkMode::TOKEN);
+        std::vector<std::pair<size_t, size_t>> byteChunks;
+        size_t at = 0;
+        for (const auto& chunk : chunks) {
+            const size_t len = encodeUtf8(t.text.substr(chunk.start, chunk.len)).size();
+            byteChunks.emplace_back(at, len);
+            at += len;
+        }
+        const std::string bytes = encodeUtf8(t.text);
+        printRow(t.name, "utf16", "token", measureSession(&streamnative::createMarkdownBlockSession, t, chunks, opts.minTimeMs));
+        printRow(t.name, "utf8", "token", measureSessionUtf8(bytes, byteChunks, opts.minTimeMs));
+    }
+}
+
+// Per-plugin counters (STREAMNATIVE_ENABLE_STATS builds only) of a nested
+// session fed token by token.
+void benchPluginStats(const Options& opts, const std::vector<Transcript>& transcripts) {
+    bool header = false;
+    for (const auto& t : transcripts) {
+        if (!matchesFilter(opts, t.name + "/nested/stats")) {
+            continue;
+        }
+        streamnative::MarkdownSession* session = streamnative::createMarkdownNestedSession();
+        for (const auto& chunk : makeChunks(t.text, ChunkMode::TOKEN)) {
+            streamnative::markdownSessionPush(session, t.text.data() + chunk.start, chunk.len);
+        }
+        streamnative::SessionStats stats;
+        const bool enabled = streamnative::markdownSessionGetStats(session, stats);
+        streamnative::destroyMarkdownSession(session);
+        if (!enabled) {
+            return;
+        }
+        if (!header) {
+            std::printf("\n== plugin stats (nested session, token chunks)\n");
+            std::printf("%-16s %5s %10s %10s %8s %8s %8s %8s %8s %8s %8s\n", "transcript", "tag", "evaluated", "bulk",
+                        "trying", "rejected", "longest", "wf ok", "wf no", "replays", "abandons");
+            header = true;
+        }
+        std::printf("%-16s pushes %llu, %.1f ns/char\n", t.name.c_str(), static_cast<unsigned long long>(stats.pushes),
+                    t.text.empty() ? 0.0 : static_cast<double>(stats.pushNanos) / static_cast<double>(t.text.size()));
+        for (const auto& p : stats.plugins) {
+            std::printf("%-16s %5d %10llu %10llu %8llu %8llu %8llu %8llu %8llu %8llu %8llu\n", "", p.tag,
+                        static_cast<unsigned long long>(p.charsEvaluated),
+                        static_cast<unsigned long long>(p.charsConsumedInBulk),
+                        static_cast<unsigned long long>(p.tryingEntries),
+                        static_cast<unsigned long long>(p.tryingRejections),
+                        static_cast<unsigned long long>(p.longestEvaluation),
+                        static_cast<unsigned long long>(p.waitforConfirmed),
+                        static_cast<unsigned long long>(p.waitforRejected),
+                        static_cast<unsigned long long>(p.pendingReplays),
+                        static_cast<unsigned long long>(p.lookaheadAbandons));
+        }
+    }
+}
+
+struct AdversarialRun {
+    double nsPerChar = 0.0;
+    int maxHeld = 0; // most pushed characters held back after a push
+};
+
+AdversarialRun measureAdversarial(SessionFactory createSession, const std::u16string& text, double minTimeMs) {
+    constexpr int kChunk = 64;
+    AdversarialRun run;
+    double best = 0.0;
+    double total = 0.0;
+    do {
+        streamnative::MarkdownSession* session = createSession();
+        int held = 0;
+        const auto start = Clock::now();
+        for (int i = 0; i < static_cast<int>(text.size()); i += kChunk) {
+            const int len = std::min(kChunk, static_cast<int>(text.size()) - i);
+            streamnative::markdownSessionPush(session, text.data() + i, len);
+            held = std::max(held, streamnative::markdownSessionPendingLength(session));
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        streamnative::destroyMarkdownSession(session);
+        best = best == 0.0 ? seconds : std::min(best, seconds);
+        total += seconds;
+        run.maxHeld = held;
+    } while (total * 1000.0 < minTimeMs);
+    run.nsPerChar = best * 1e9 / static_cast<double>(text.size());
+    return run;
+}
+
+// Worst-case inputs: one long line of openers that never close ('[', '<'
+// and letters, a backtick fence with an endless info string, ...) plus a
+// seeded random mix of delimiter characters: time per character at 64K and
+// 1M characters, and the most text a session held back. Bounded lookahead
+// keeps the growth near 1.
+void benchAdversarial(const Options& opts) {
+    struct Case {
+        const char* name;
+        std::u16string prefix;
+        std::u16string unit;
+    };
+    std::vector<Case> cases = {
+            {"brackets", u"", u"["},   {"lt-letters", u"<", u"a"}, {"fence-info", u"```", u"`"},
+            {"image", u"", u"!["},     {"link-text", u"[", u"a"},  {"plan-tag", u"<plan", u"a"},
+            {"attr", u"<tool name=\"", u"a"}, {"stars", u"", u"*"}, {"dollars", u"", u"$"},
+    };
+    {
+        // No newline anywhere, so nothing is decided by a line end.
+        const char16_t alphabet[] = u"[]()*_~`$<>!|\\/\"= ab";
+        std::u16string mix;
+        uint32_t seed = 12345;
+        while (mix.size() < 4096) {
+            seed = seed * 1103515245u + 12345u;
+            mix.push_back(alphabet[(seed >> 16) % (sizeof(alphabet) / sizeof(alphabet[0]) - 1)]);
+        }
+        cases.push_back({"random-mix", u"", mix});
+    }
+    struct SessionKind {
+        const char* name;
+        SessionFactory create;
+    };
+    const SessionKind kinds[] = {
+            {"block", &streamnative::createMarkdownBlockSession},
+            {"inline", &streamnative::createMarkdownInlineSession},
+            {"nested", &streamnative::createMarkdownNestedSession},
+    };
+    std::printf("\n== adversarial input (64-char chunks)\n");
+    std::printf("%-12s %-8s %12s %12s %8s %8s\n", "input", "session", "ns/char 64K", "ns/char 1M", "growth", "held");
+    for (const auto& c : cases) {
+        std::u16string small = c.prefix;
+        while (small.size() < 64 * 1024) {
+            small += c.unit;
+        }
+        std::u16string large = c.prefix;
+        while (large.size() < 1024 * 1024) {
+            large += c.unit;
+        }
+        for (const auto& kind : kinds) {
+            if (!matchesFilter(opts, std::string(c.name) + "/" + kind.name + "/adversarial")) {
+                continue;
+            }
+            const AdversarialRun a = measureAdversarial(kind.create, small, opts.minTimeMs);
+            const AdversarialRun b = measureAdversarial(kind.create, large, opts.minTimeMs);
+            const double growth = a.nsPerChar > 0.0 ? b.nsPerChar / a.nsPerChar : 0.0;
+            std::printf("%-12s %-8s %12.1f %12.1f %8.2f %8d\n", c.name, kind.name, a.nsPerChar, b.nsPerChar, growth,
+                        std::max(a.maxHeld, b.maxHeld));
+        }
+    }
+}
+
+// Input copy cost at the JNI boundary: whole-message splitByXml over a
+// copied buffer versus in place (GetStringCritical / direct CharBuffer).
+void benchInputCopy(const Options& opts, const std::vector<Transcript>& transcripts) {
+    std::u16string corpus;
+    for (const auto& t : transcripts) {
+        corpus += t.text;
+    }
+    if (corpus.empty()) {
+        return;
+    }
+
+    struct Size {
+        const char* name;
+        size_t chars;
+    };
+    const Size sizes[] = {{"1KB", 1024}, {"100KB", 100 * 1024}, {"1MB", 1024 * 1024}};
+
+    printHeader("input copy (splitByXml)");
+    for (const auto& size : sizes) {
+        Transcript t;
+        t.name = size.name;
+        while (t.text.size() < size.chars) {
+            t.text += corpus;
+        }
+        t.text.resize(size.chars);
+
+        for (bool copyInput : {true, false}) {
+            const char* mode = copyInput ? "copy" : "in-place";
+            if (!matchesFilter(opts, t.name + "/xml/" + mode)) {
+                continue;
+            }
+            const Measurement m = measureSplitByXml(t, opts.minTimeMs, copyInput);
+            printRow(t.name, "xml", mode, m);
+        }
+    }
+}
+
+bool parseArgs(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--min-time-ms=", 0) == 0) {
+            opts.minTimeMs = std::atof(arg.c_str() + 14);
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            opts.filter = arg.substr(9);
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            return false;
+        } else {
+            opts.files.push_back(arg);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) {
+        std::fprintf(stderr, "usage: %s [--min-time-ms=N] [--filter=TEXT] [transcript.md ...]\n", argv[0]);
+        return 2;
+    }
+    if (opts.files.empty()) {
+        opts.files = listTranscripts(STREAMNATIVE_TRANSCRIPTS);
+    }
+
+    std::vector<Transcript> transcripts;
+    for (const auto& path : opts.files) {
+        Transcript t;
+        if (!loadTranscript(path, t)) {
+            std::fprintf(stderr, "cannot read %s\n", path.c_str());
+            return 1;
+        }
+        transcripts.push_back(std::move(t));
+    }
+    if (transcripts.empty()) {
+        std::fprintf(stderr, "no transcripts found\n");
+        return 1;
+    }
+
+    benchSessions(opts, transcripts, "MarkdownSession::push", &measureSession);
+    benchSessions(opts, transcripts, "MarkdownSession::pushToRing", &measureSessionRing);
+    benchSplitByXml(opts, transcripts);
+    benchXmlSplitSession(opts, transcripts);
+    benchParseGrowing(opts, transcripts);
+    benchParseParallel(opts, transcripts);
+    benchParseLongLines(opts);
+    benchInputCopy(opts, transcripts);
+    benchJsonSession(opts);
+    benchJsonXmlConverter(opts);
+    benchChatMarkup(opts, transcripts);
+    benchCompactWire(opts, transcripts);
+    benchBlockHashes(opts, transcripts);
+    benchUtf8Input(opts, transcripts);
+    benchPluginStats(opts, transcripts);
+    benchAdversarial(opts);
+    benchCheckpointResume(opts, transcripts);
+    return 0;
+}
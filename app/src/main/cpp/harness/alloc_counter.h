@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of operator new calls in this process so far. The replacement
+// operators live in alloc_counter.cpp, apart from their callers, so the
+// compiler never inlines the malloc/free pair into code that uses
+// new/delete expressions (-Wmismatched-new-delete).
+uint64_t allocationCount();
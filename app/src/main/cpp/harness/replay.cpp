@@ -0,0 +1,413 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+
+#include "streamnative/JsonXmlConverter.h"
+#include "streamnative/MarkdownTypes.h"
+
+namespace harness {
+
+namespace {
+
+bool isWordChar(char16_t c) {
+    return (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z') || (c >= u'0' && c <= u'9') || c == u'_';
+}
+
+std::vector<Chunk> tokenChunks(const std::u16string& text) {
+    constexpr int kMaxWordPiece = 6;
+    std::vector<Chunk> chunks;
+    const int n = static_cast<int>(text.size());
+    int i = 0;
+    while (i < n) {
+        const int start = i;
+        const char16_t c = text[static_cast<size_t>(i)];
+        if (c == u' ' && i + 1 < n && isWordChar(text[static_cast<size_t>(i + 1)])) {
+            i += 1;
+        }
+        if (isWordChar(text[static_cast<size_t>(i)])) {
+            const int wordStart = i;
+            while (i < n && isWordChar(text[static_cast<size_t>(i)]) && i - wordStart < kMaxWordPiece) {
+                i += 1;
+            }
+        } else if (c == u' ') {
+            while (i < n && text[static_cast<size_t>(i)] == u' ' && i - start < 4) {
+                i += 1;
+            }
+        } else if (c >= 0xD800 && c <= 0xDBFF && i + 1 < n) {
+            i += 2;
+        } else {
+            i += 1;
+        }
+        chunks.push_back({start, i - start});
+    }
+    return chunks;
+}
+
+void appendJsonXmlEvents(const char16_t* chunk, const std::vector<int32_t>& events, std::u16string& key, std::u16string& xml) {
+    using namespace streamnative;
+    for (size_t i = 0; i + 2 < events.size(); i += 3) {
+        const int a = events[i + 1];
+        const int b = events[i + 2];
+        switch (events[i]) {
+            case JSON_XML_KEY:
+                key.append(chunk + a, static_cast<size_t>(b - a));
+                break;
+            case JSON_XML_PARAM_OPEN:
+                xml += u"\n  <param name=\"" + key + u"\">";
+                key.clear();
+                break;
+            case JSON_XML_TEXT:
+                xml.append(chunk + a, static_cast<size_t>(b - a));
+                break;
+            case JSON_XML_CHAR:
+                switch (a) {
+                    case u'&': xml += u"&amp;"; break;
+                    case u'<': xml += u"&lt;"; break;
+                    case u'>': xml += u"&gt;"; break;
+                    case u'"': xml += u"&quot;"; break;
+                    case u'\'': xml += u"&apos;"; break;
+                    default: xml += static_cast<char16_t>(a); break;
+                }
+                break;
+            case JSON_XML_PARAM_CLOSE:
+                xml += u"</param>";
+                break;
+        }
+    }
+}
+
+} // namespace
+
+const char* chunkModeName(ChunkMode mode) {
+    switch (mode) {
+        case ChunkMode::CHAR:
+            return "char";
+        case ChunkMode::TOKEN:
+            return "token";
+        case ChunkMode::MESSAGE:
+            return "message";
+    }
+    return "?";
+}
+
+std::u16string decodeUtf8(const std::string& bytes) {
+    std::u16string out;
+    out.reserve(bytes.size());
+    const auto* s = reinterpret_cast<const unsigned char*>(bytes.data());
+    const size_t n = bytes.size();
+    size_t i = 0;
+    while (i < n) {
+        uint32_t cp = 0xFFFD;
+        int extra = 0;
+        const unsigned char b = s[i];
+        if (b < 0x80) {
+            cp = b;
+        } else if ((b & 0xE0) == 0xC0) {
+            cp = b & 0x1F;
+            extra = 1;
+        } else if ((b & 0xF0) == 0xE0) {
+            cp = b & 0x0F;
+            extra = 2;
+        } else if ((b & 0xF8) == 0xF0) {
+            cp = b & 0x07;
+            extra = 3;
+        }
+        i += 1;
+        for (int k = 0; k < extra; k++) {
+            if (i >= n || (s[i] & 0xC0) != 0x80) {
+                cp = 0xFFFD;
+                break;
+            }
+            cp = (cp << 6) | (s[i] & 0x3F);
+            i += 1;
+        }
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            out.push_back(static_cast<char16_t>(0xD800 + (cp >> 10)));
+            out.push_back(static_cast<char16_t>(0xDC00 + (cp & 0x3FF)));
+        } else {
+            out.push_back(static_cast<char16_t>(cp));
+        }
+    }
+    return out;
+}
+
+std::string encodeUtf8(const std::u16string& text) {
+    std::string out;
+    out.reserve(text.size() * 3);
+    for (size_t i = 0; i < text.size(); i++) {
+        uint32_t cp = text[i];
+        if (cp >= 0xD800 && cp < 0xDC00 && i + 1 < text.size() && text[i + 1] >= 0xDC00 && text[i + 1] < 0xE000) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (text[++i] - 0xDC00);
+        }
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+    return out;
+}
+
+bool loadTranscript(const std::string& path, Transcript& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    out.text = decodeUtf8(ss.str());
+
+    const size_t slash = path.find_last_of('/');
+    std::string base = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    const size_t dot = base.find_last_of('.');
+    out.name = (dot == std::string::npos) ? base : base.substr(0, dot);
+    return true;
+}
+
+std::vector<std::string> listTranscripts(const std::string& dir) {
+    std::vector<std::string> files;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return files;
+    }
+    while (dirent* e = readdir(d)) {
+        const std::string name = e->d_name;
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, ".md") == 0) {
+            files.push_back(dir + "/" + name);
+        }
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::vector<Chunk> makeChunks(const std::u16string& text, ChunkMode mode) {
+    std::vector<Chunk> chunks;
+    const int n = static_cast<int>(text.size());
+    switch (mode) {
+        case ChunkMode::CHAR:
+            chunks.reserve(static_cast<size_t>(n));
+            for (int i = 0; i < n; i++) {
+                chunks.push_back({i, 1});
+            }
+            break;
+        case ChunkMode::TOKEN:
+            chunks = tokenChunks(text);
+            break;
+        case ChunkMode::MESSAGE:
+            chunks.push_back({0, n});
+            break;
+    }
+    return chunks;
+}
+
+streamnative::MarkdownSession* createHashedBlockSession() {
+    streamnative::MarkdownSession* session = streamnative::createMarkdownBlockSession();
+    streamnative::markdownSessionSetBlockHashes(session, true);
+    return session;
+}
+
+streamnative::MarkdownSession* createHashedNestedSession() {
+    streamnative::MarkdownSession* session = streamnative::createMarkdownNestedSession();
+    streamnative::markdownSessionSetBlockHashes(session, true);
+    return session;
+}
+
+bool sameSegments(const std::vector<streamnative::Segment>& a, const std::vector<streamnative::Segment>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const streamnative::Segment& x, const streamnative::Segment& y) {
+        return x.type == y.type && x.start == y.start && x.end == y.end;
+    });
+}
+
+bool sameNodes(const streamnative::MarkdownNodes& a, const streamnative::MarkdownNodes& b) {
+    return a.types == b.types && a.pieceStart == b.pieceStart && a.pieceEnd == b.pieceEnd &&
+           a.parentIndex == b.parentIndex && a.blockHashes == b.blockHashes && a.blockCount == b.blockCount;
+}
+
+std::vector<streamnative::Segment> mergeTextRuns(const std::vector<streamnative::Segment>& segments) {
+    std::vector<streamnative::Segment> merged;
+    for (const auto& s : segments) {
+        if (s.type == streamnative::JSON_TEXT && !merged.empty() && merged.back().type == streamnative::JSON_TEXT &&
+            merged.back().end == s.start) {
+            merged.back().end = s.end;
+        } else {
+            merged.push_back(s);
+        }
+    }
+    return merged;
+}
+
+std::vector<streamnative::Segment> mergeRuns(const std::vector<streamnative::Segment>& segments) {
+    std::vector<streamnative::Segment> merged;
+    for (const auto& s : segments) {
+        if (s.type >= 0 && !merged.empty() && merged.back().type == s.type && merged.back().end == s.start) {
+            merged.back().end = s.end;
+        } else {
+            merged.push_back(s);
+        }
+    }
+    return merged;
+}
+
+std::vector<streamnative::Segment> nestedReference(const std::u16string& text) {
+    using streamnative::Segment;
+
+    streamnative::MarkdownSession* block = streamnative::createMarkdownBlockSession();
+    const std::vector<Segment> blocks = streamnative::markdownSessionPush(block, text.data(), static_cast<int>(text.size()));
+    streamnative::destroyMarkdownSession(block);
+
+    // Groups are runs of block segments of one type up to a break or a type change.
+    std::vector<Segment> out;
+    size_t i = 0;
+    while (i < blocks.size()) {
+        if (blocks[i].type == streamnative::SEG_BREAK) {
+            i++;
+            continue;
+        }
+        const int type = blocks[i].type;
+        size_t end = i;
+        while (end < blocks.size() && blocks[end].type == type) {
+            end++;
+        }
+        out.push_back({streamnative::NEST_BLOCK_OPEN, type, blocks[i].start});
+
+        const bool container = type != streamnative::MD_CODE_BLOCK && type != streamnative::MD_XML_BLOCK &&
+                               type != streamnative::MD_PLAN_EXECUTION && type != streamnative::MD_HORIZONTAL_RULE;
+        if (!container) {
+            out.insert(out.end(), blocks.begin() + static_cast<long>(i), blocks.begin() + static_cast<long>(end));
+        } else {
+            // The group's pieces back to back; `globalStarts[k]` is where the
+            // piece starting at local offset `localStarts[k]` came from.
+            std::u16string content;
+            std::vector<int> localStarts;
+            std::vector<int> globalStarts;
+            for (size_t k = i; k < end; k++) {
+                localStarts.push_back(static_cast<int>(content.size()));
+                globalStarts.push_back(blocks[k].start);
+                content.append(text, static_cast<size_t>(blocks[k].start),
+                               static_cast<size_t>(blocks[k].end - blocks[k].start));
+            }
+            const auto toGlobal = [&](int local) {
+                const size_t k = static_cast<size_t>(
+                        std::upper_bound(localStarts.begin(), localStarts.end(), local) - localStarts.begin() - 1);
+                return std::make_pair(k, globalStarts[k] + (local - localStarts[k]));
+            };
+
+            streamnative::MarkdownSession* inl = streamnative::createMarkdownInlineSession();
+            const std::vector<Segment> runs =
+                    streamnative::markdownSessionPush(inl, content.data(), static_cast<int>(content.size()));
+            streamnative::destroyMarkdownSession(inl);
+
+            for (const Segment& run : runs) {
+                if (run.type == streamnative::SEG_BREAK) {
+                    const int pos = toGlobal(run.start).second;
+                    out.push_back({streamnative::SEG_BREAK, pos, pos});
+                    continue;
+                }
+                // Split at piece boundaries, where the global text is not contiguous.
+                int local = run.start;
+                while (local < run.end) {
+                    const auto at = toGlobal(local);
+                    const int pieceEnd = at.first + 1 < localStarts.size() ? localStarts[at.first + 1]
+                                                                           : static_cast<int>(content.size());
+                    const int take = std::min(run.end, pieceEnd) - local;
+                    out.push_back({run.type, at.second, at.second + take});
+                    local += take;
+                }
+            }
+        }
+
+        // The last group stays open, as in a session that is still streaming.
+        if (end < blocks.size()) {
+            out.push_back({streamnative::NEST_BLOCK_CLOSE, type, blocks[end].start});
+        }
+        i = end;
+    }
+    return mergeRuns(out);
+}
+
+std::vector<streamnative::Segment> pushJson(const std::u16string& text, const std::vector<Chunk>& chunks) {
+    std::vector<streamnative::Segment> all;
+    streamnative::MarkdownSession* session = streamnative::createJsonSession();
+    for (const auto& chunk : chunks) {
+        const std::vector<streamnative::Segment> segments =
+                streamnative::markdownSessionPush(session, text.data() + chunk.start, chunk.len);
+        all.insert(all.end(), segments.begin(), segments.end());
+    }
+    streamnative::destroyMarkdownSession(session);
+    return mergeTextRuns(all);
+}
+
+std::u16string convertJsonToXml(const std::u16string& json, const std::vector<Chunk>& chunks) {
+    streamnative::JsonXmlConverter converter;
+    std::vector<int32_t> events;
+    std::u16string key;
+    std::u16string xml;
+    for (const auto& chunk : chunks) {
+        events.clear();
+        converter.push(json.data() + chunk.start, chunk.len, events);
+        appendJsonXmlEvents(json.data() + chunk.start, events, key, xml);
+    }
+    events.clear();
+    converter.flush(events);
+    appendJsonXmlEvents(nullptr, events, key, xml);
+    return xml;
+}
+
+std::u16string stripMatches(const std::u16string& text, const std::vector<streamnative::Segment>& matches) {
+    std::u16string out;
+    out.reserve(text.size());
+    size_t copied = 0;
+    for (const auto& m : matches) {
+        out.append(text, copied, static_cast<size_t>(m.start) - copied);
+        copied = static_cast<size_t>(m.end);
+    }
+    out.append(text, copied, std::u16string::npos);
+    return out;
+}
+
+RegexStripChain::RegexStripChain() {
+    const wchar_t* patterns[] = {
+            LR"(<status\b[\s\S]*?</status>)",           LR"(<status\b[^>]*/>)",
+            LR"(<think(?:ing)?\b[\s\S]*?</think(?:ing)?>)", LR"(<think(?:ing)?\b[^>]*/>)",
+            LR"(<search\b[\s\S]*?</search>)",           LR"(<search\b[^>]*/>)",
+            LR"(<tool\b[\s\S]*?</tool>)",               LR"(<tool\b[^>]*/>)",
+            LR"(<tool_result\b[\s\S]*?</tool_result>)", LR"(<tool_result\b[^>]*/>)",
+            LR"(<emotion\b[\s\S]*?</emotion>)",
+    };
+    for (const wchar_t* pattern : patterns) {
+        regexes_.emplace_back(pattern, std::regex::ECMAScript | std::regex::icase);
+    }
+}
+
+std::u16string RegexStripChain::strip(const std::u16string& text, size_t& matches) const {
+    std::wstring s(text.begin(), text.end());
+    for (const auto& re : regexes_) {
+        std::wstring kept;
+        auto copied = s.cbegin();
+        for (std::wsregex_iterator it(s.cbegin(), s.cend(), re), end; it != end; ++it) {
+            kept.append(copied, (*it)[0].first);
+            copied = (*it)[0].second;
+            matches++;
+        }
+        kept.append(copied, s.cend());
+        s = std::move(kept);
+    }
+    return std::u16string(s.begin(), s.end());
+}
+
+} // namespace harness
@@ -0,0 +1,96 @@
+#pragma once
+
+// Shared by the host benchmarks and tests: recorded transcripts, the ways the
+// Kotlin side chunks them, and reference implementations to compare against.
+
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "streamnative/MarkdownParser.h"
+#include "streamnative/StreamOperators.h"
+
+namespace harness {
+
+struct Transcript {
+    std::string name;
+    std::u16string text;
+};
+
+struct Chunk {
+    int start;
+    int len;
+};
+
+enum class ChunkMode {
+    CHAR,
+    TOKEN,
+    MESSAGE,
+};
+
+const char* chunkModeName(ChunkMode mode);
+
+// Lenient UTF-8 -> UTF-16 decoding; invalid sequences become U+FFFD.
+std::u16string decodeUtf8(const std::string& bytes);
+std::string encodeUtf8(const std::u16string& text);
+
+// Reads a UTF-8 file; the name is the file name without its extension.
+bool loadTranscript(const std::string& path, Transcript& out);
+
+// Every *.md in `dir`, sorted.
+std::vector<std::string> listTranscripts(const std::string& dir);
+
+// Token chunks approximate how a BPE tokenizer slices model output: short
+// ASCII word pieces (with their leading space), single punctuation marks, one
+// token per CJK character and per newline.
+std::vector<Chunk> makeChunks(const std::u16string& text, ChunkMode mode);
+
+using SessionFactory = streamnative::MarkdownSession* (*)();
+
+// Block and nested sessions with block hashes on.
+streamnative::MarkdownSession* createHashedBlockSession();
+streamnative::MarkdownSession* createHashedNestedSession();
+
+bool sameSegments(const std::vector<streamnative::Segment>& a, const std::vector<streamnative::Segment>& b);
+bool sameNodes(const streamnative::MarkdownNodes& a, const streamnative::MarkdownNodes& b);
+
+// Text runs are flushed at every push; merging adjacent ones gives segments
+// that no longer depend on the chunking.
+std::vector<streamnative::Segment> mergeTextRuns(const std::vector<streamnative::Segment>& segments);
+
+// Adjacent runs of one type (markers excluded) merged, so that segments of
+// sessions that flush runs at every push no longer depend on the chunking.
+std::vector<streamnative::Segment> mergeRuns(const std::vector<streamnative::Segment>& segments);
+
+// What a nested session reports for `text`, built the way the Kotlin side
+// nests sessions: a block session over the whole text, then a fresh inline
+// session per inline-container block group. Runs are merged.
+std::vector<streamnative::Segment> nestedReference(const std::u16string& text);
+
+// Segments of a JSON session fed `chunks` of `text`, text runs merged.
+std::vector<streamnative::Segment> pushJson(const std::u16string& text, const std::vector<Chunk>& chunks);
+
+// Tool-call arguments through JsonXmlConverter, rendered the way
+// StreamingJsonXmlConverter.kt does.
+std::u16string convertJsonToXml(const std::u16string& json, const std::vector<Chunk>& chunks);
+
+// What util/ChatMarkupRegex.kt's strip patterns do today: one regex
+// replace per pattern, in the order of ChatArea.cleanXmlTags. std::wregex
+// stands in for java.util.regex (ECMAScript, case-insensitive; `[\s\S]`
+// spans lines as DOT_MATCHES_ALL does).
+class RegexStripChain {
+public:
+    RegexStripChain();
+
+    // Also counts the matches removed.
+    std::u16string strip(const std::u16string& text, size_t& matches) const;
+
+private:
+    std::vector<std::wregex> regexes_;
+};
+
+// `text` without the ranges of `matches` (sorted, non-overlapping).
+std::u16string stripMatches(const std::u16string& text, const std::vector<streamnative::Segment>& matches);
+
+} // namespace harness
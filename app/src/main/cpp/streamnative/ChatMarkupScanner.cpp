@@ -0,0 +1,140 @@
+#include "ChatMarkupScanner.h"
+
+#include "StringExtensions.h"
+
+namespace streamnative {
+
+namespace {
+
+// A tag name and the patterns it opens. think and thinking share a group:
+// either opener is closed by either closer.
+struct TagName {
+    const char16_t* name; // lower case
+    int len;
+    int group;
+};
+
+constexpr int kGroupCount = 6;
+constexpr int kThinkGroup = 1;
+
+// Pattern ids of each group; emotion has no self-closing form.
+constexpr int kBlockId[kGroupCount] = {
+        CHAT_MARKUP_STATUS, CHAT_MARKUP_THINK, CHAT_MARKUP_SEARCH,
+        CHAT_MARKUP_TOOL, CHAT_MARKUP_TOOL_RESULT, CHAT_MARKUP_EMOTION,
+};
+constexpr int kSelfId[kGroupCount] = {
+        CHAT_MARKUP_STATUS_SELF, CHAT_MARKUP_THINK_SELF, CHAT_MARKUP_SEARCH_SELF,
+        CHAT_MARKUP_TOOL_SELF, CHAT_MARKUP_TOOL_RESULT_SELF, -1,
+};
+
+constexpr TagName kNames[] = {
+        {u"status", 6, 0},
+        {u"think", 5, kThinkGroup},
+        {u"thinking", 8, kThinkGroup},
+        {u"search", 6, 2},
+        {u"tool", 4, 3},
+        {u"tool_result", 11, 4},
+        {u"emotion", 7, 5},
+};
+
+inline char16_t foldAscii(char16_t c) {
+    return c >= u'A' && c <= u'Z' ? static_cast<char16_t>(c + (u'a' - u'A')) : c;
+}
+
+inline bool isWordChar(char16_t c) {
+    return (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z') || (c >= u'0' && c <= u'9') || c == u'_' ||
+           c >= 0x80;
+}
+
+inline bool matchesFolded(const char16_t* chars, int at, int len, const char16_t* name, int nameLen) {
+    if (len - at < nameLen) {
+        return false;
+    }
+    for (int k = 0; k < nameLen; k++) {
+        if (foldAscii(chars[at + k]) != name[k]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Group of the tag name at `at` followed by a word boundary, or -1; sets
+// `nameEnd` past the name.
+int matchTagName(const char16_t* chars, int at, int len, int& nameEnd) {
+    for (const TagName& tag : kNames) {
+        if (matchesFolded(chars, at, len, tag.name, tag.len) &&
+            (at + tag.len == len || !isWordChar(chars[at + tag.len]))) {
+            nameEnd = at + tag.len;
+            return tag.group;
+        }
+    }
+    return -1;
+}
+
+// End of the closer `</name>` of `group` starting at `at`, or -1.
+int closerEnd(const char16_t* chars, int at, int len, int group) {
+    if (at + 1 >= len || chars[at + 1] != u'/') {
+        return -1;
+    }
+    for (const TagName& tag : kNames) {
+        if (tag.group != group) {
+            continue;
+        }
+        const int gt = at + 2 + tag.len;
+        if (gt < len && chars[gt] == u'>' && matchesFolded(chars, at + 2, len, tag.name, tag.len)) {
+            return gt + 1;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+void scanChatMarkup(const char16_t* chars, int len, uint32_t mask, std::vector<Segment>& out) {
+    // Closer searches of one group never rescan: a found closer ends a match
+    // the scan jumps past, and a failed search from `from` fails from any
+    // later position too. The first '>' is kept for the self-closing forms.
+    int missingFrom[kGroupCount];
+    for (int& from : missingFrom) {
+        from = len + 1;
+    }
+    int nextGt = -1;
+
+    int i = indexOfChar(chars, 0, len, u'<');
+    while (i < len) {
+        int nameEnd = 0;
+        const int group = matchTagName(chars, i + 1, len, nameEnd);
+        int matchEnd = -1;
+        int matchId = -1;
+        if (group >= 0 && (mask & (1u << kBlockId[group])) != 0 && nameEnd < missingFrom[group]) {
+            for (int at = indexOfChar(chars, nameEnd, len, u'<'); at < len; at = indexOfChar(chars, at + 1, len, u'<')) {
+                const int end = closerEnd(chars, at, len, group);
+                if (end >= 0) {
+                    matchEnd = end;
+                    matchId = kBlockId[group];
+                    break;
+                }
+            }
+            if (matchEnd < 0) {
+                missingFrom[group] = nameEnd;
+            }
+        }
+        if (matchEnd < 0 && group >= 0 && kSelfId[group] >= 0 && (mask & (1u << kSelfId[group])) != 0) {
+            if (nextGt < nameEnd) {
+                nextGt = indexOfChar(chars, nameEnd, len, u'>');
+            }
+            if (nextGt < len && nextGt > nameEnd && chars[nextGt - 1] == u'/') {
+                matchEnd = nextGt + 1;
+                matchId = kSelfId[group];
+            }
+        }
+        if (matchEnd >= 0) {
+            out.push_back({matchId, i, matchEnd});
+            i = indexOfChar(chars, matchEnd, len, u'<');
+        } else {
+            i = indexOfChar(chars, i + 1, len, u'<');
+        }
+    }
+}
+
+} // namespace streamnative
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "StreamGroup.h"
+
+namespace streamnative {
+
+// Patterns of scanChatMarkup, one per strip regex of util/ChatMarkupRegex.kt.
+// Names match ASCII case-insensitively and must end at a non-word character.
+constexpr int CHAT_MARKUP_STATUS = 0;             // <status ...>...</status>
+constexpr int CHAT_MARKUP_STATUS_SELF = 1;        // <status .../>
+constexpr int CHAT_MARKUP_THINK = 2;              // <think(ing) ...>...</think(ing)>
+constexpr int CHAT_MARKUP_THINK_SELF = 3;         // <think(ing) .../>
+constexpr int CHAT_MARKUP_SEARCH = 4;             // <search ...>...</search>
+constexpr int CHAT_MARKUP_SEARCH_SELF = 5;        // <search .../>
+constexpr int CHAT_MARKUP_TOOL = 6;               // <tool ...>...</tool>
+constexpr int CHAT_MARKUP_TOOL_SELF = 7;          // <tool .../>
+constexpr int CHAT_MARKUP_TOOL_RESULT = 8;        // <tool_result ...>...</tool_result>
+constexpr int CHAT_MARKUP_TOOL_RESULT_SELF = 9;   // <tool_result .../>
+constexpr int CHAT_MARKUP_EMOTION = 10;           // <emotion ...>...</emotion>
+constexpr int CHAT_MARKUP_PATTERN_COUNT = 11;
+
+constexpr uint32_t CHAT_MARKUP_ALL = (1u << CHAT_MARKUP_PATTERN_COUNT) - 1;
+
+// Finds the patterns in `mask` (bit 1 << id per pattern) in one left-to-right
+// pass and appends each match as {id, start, end}. Matches are the leftmost
+// ones and do not overlap: a match hides any other starting inside it, and at
+// one position the block form wins over the self-closing one. Removing the
+// ranges gives what the sequential `.replace(pattern, "")` chain over the
+// same patterns gives unless tags interleave oddly: in the chain, removing a
+// match that cuts through another pattern's tag, or that splices one
+// together, changes what the later patterns find.
+// Characters from U+0080 up count as word characters, as letters do for the
+// `\b` of Android's regex engine. The pass is linear in `len`.
+void scanChatMarkup(const char16_t* chars, int len, uint32_t mask, std::vector<Segment>& out);
+
+} // namespace streamnative
@@ -0,0 +1,283 @@
+#include "JsonXmlConverter.h"
+
+namespace streamnative {
+
+namespace {
+
+// Kotlin's Char.isWhitespace.
+inline bool isWhitespace(char16_t c) {
+    if (c <= u' ') {
+        return c == u' ' || (c >= u'\t' && c <= u'\r') || (c >= 0x1c && c <= 0x1f);
+    }
+    return c == 0x85 || c == 0xa0 || c == 0x1680 || (c >= 0x2000 && c <= 0x200a) || c == 0x2028 ||
+           c == 0x2029 || c == 0x202f || c == 0x205f || c == 0x3000;
+}
+
+// Characters escapeXml rewrites.
+inline bool isXmlSpecial(char16_t c) {
+    return c == u'&' || c == u'<' || c == u'>' || c == u'"' || c == u'\'';
+}
+
+inline int hexValue(char16_t c) {
+    if (c >= u'0' && c <= u'9') {
+        return c - u'0';
+    }
+    if (c >= u'a' && c <= u'f') {
+        return c - u'a' + 10;
+    }
+    if (c >= u'A' && c <= u'F') {
+        return c - u'A' + 10;
+    }
+    return -1;
+}
+
+inline char16_t unescape(char16_t c) {
+    switch (c) {
+        case u'n':
+            return u'\n';
+        case u'r':
+            return u'\r';
+        case u't':
+            return u'\t';
+        case u'b':
+            return u'\b';
+        case u'f':
+            return u'\f';
+        default:
+            return c; // '"', '\\', '/' and unknown escapes stand for themselves
+    }
+}
+
+// Merges consecutive key or text characters of one push into a single range.
+class EventWriter {
+public:
+    explicit EventWriter(std::vector<int32_t>& out) : out_(out) {}
+
+    void range(int type, int start, int end) {
+        if (runStart_ >= 0 && (runType_ != type || runEnd_ != start)) {
+            flush();
+        }
+        if (runStart_ < 0) {
+            runType_ = type;
+            runStart_ = start;
+        }
+        runEnd_ = end;
+    }
+
+    void valueChar(char16_t c, int index) {
+        if (isXmlSpecial(c)) {
+            event(JSON_XML_CHAR, c);
+        } else {
+            range(JSON_XML_TEXT, index, index + 1);
+        }
+    }
+
+    void event(int type, int a) {
+        flush();
+        out_.push_back(type);
+        out_.push_back(a);
+        out_.push_back(0);
+    }
+
+    void flush() {
+        if (runStart_ >= 0) {
+            out_.push_back(runType_);
+            out_.push_back(runStart_);
+            out_.push_back(runEnd_);
+        }
+        runStart_ = -1;
+    }
+
+private:
+    std::vector<int32_t>& out_;
+    int runType_ = JSON_XML_TEXT;
+    int runStart_ = -1;
+    int runEnd_ = -1;
+};
+
+} // namespace
+
+void JsonXmlConverter::reset() {
+    state_ = State::WAIT_BRACE;
+    unicodeCount_ = 0;
+    unicodeValue_ = 0;
+    primitiveDepth_ = 0;
+    primitiveInString_ = false;
+    primitiveEscape_ = false;
+    readingComplexValue_ = false;
+}
+
+void JsonXmlConverter::push(const char16_t* chars, int len, std::vector<int32_t>& out) {
+    EventWriter writer(out);
+    int i = 0;
+    while (i < len) {
+        if (state_ == State::READ_STRING) {
+            // Bulk path for string bodies: everything up to a quote, a
+            // backslash or a character XML escapes is copied verbatim.
+            int end = i;
+            while (end < len && chars[end] != u'"' && chars[end] != u'\\' && !isXmlSpecial(chars[end])) {
+                end++;
+            }
+            if (end > i) {
+                writer.range(JSON_XML_TEXT, i, end);
+                i = end;
+                continue;
+            }
+        }
+
+        const char16_t c = chars[i];
+        switch (state_) {
+            case State::WAIT_BRACE:
+                if (c == u'{') {
+                    state_ = State::WAIT_KEY_QUOTE;
+                }
+                break;
+            case State::WAIT_KEY_QUOTE:
+                if (c == u'"') {
+                    state_ = State::READ_KEY;
+                }
+                break;
+            case State::READ_KEY:
+                if (c == u'"') {
+                    writer.event(JSON_XML_PARAM_OPEN, 0);
+                    state_ = State::WAIT_COLON;
+                } else if (c != u'\\') {
+                    writer.range(JSON_XML_KEY, i, i + 1);
+                }
+                break;
+            case State::WAIT_COLON:
+                if (c == u':') {
+                    state_ = State::WAIT_VALUE;
+                }
+                break;
+            case State::WAIT_VALUE:
+                if (isWhitespace(c)) {
+                    break;
+                }
+                if (c == u'"') {
+                    state_ = State::READ_STRING;
+                    break;
+                }
+                state_ = State::READ_PRIMITIVE;
+                readingComplexValue_ = c == u'[' || c == u'{';
+                primitiveDepth_ = readingComplexValue_ ? 1 : 0;
+                primitiveInString_ = false;
+                primitiveEscape_ = false;
+                writer.valueChar(c, i);
+                break;
+            case State::READ_STRING:
+                if (c == u'"') {
+                    state_ = State::WAIT_COMMA;
+                    writer.event(JSON_XML_PARAM_CLOSE, 0);
+                } else if (c == u'\\') {
+                    state_ = State::ESCAPE;
+                } else {
+                    writer.valueChar(c, i);
+                }
+                break;
+            case State::ESCAPE:
+                if (c == u'u') {
+                    state_ = State::UNICODE_ESCAPE;
+                    unicodeCount_ = 0;
+                    unicodeValue_ = 0;
+                } else {
+                    writer.event(JSON_XML_CHAR, unescape(c));
+                    state_ = State::READ_STRING;
+                }
+                break;
+            case State::UNICODE_ESCAPE: {
+                const int digit = hexValue(c);
+                unicodeValue_ = (digit < 0 || unicodeValue_ < 0) ? -1 : unicodeValue_ * 16 + digit;
+                if (++unicodeCount_ == 4) {
+                    // Malformed sequences are dropped, as in the Kotlin class.
+                    if (unicodeValue_ >= 0) {
+                        writer.event(JSON_XML_CHAR, unicodeValue_);
+                    }
+                    unicodeCount_ = 0;
+                    unicodeValue_ = 0;
+                    state_ = State::READ_STRING;
+                }
+                break;
+            }
+            case State::READ_PRIMITIVE:
+                if (readingComplexValue_) {
+                    writer.valueChar(c, i);
+                    if (primitiveInString_) {
+                        if (primitiveEscape_) {
+                            primitiveEscape_ = false;
+                        } else if (c == u'\\') {
+                            primitiveEscape_ = true;
+                        } else if (c == u'"') {
+                            primitiveInString_ = false;
+                        }
+                    } else if (c == u'"') {
+                        primitiveInString_ = true;
+                    } else if (c == u'[' || c == u'{') {
+                        primitiveDepth_++;
+                    } else if ((c == u']' || c == u'}') && --primitiveDepth_ == 0) {
+                        writer.event(JSON_XML_PARAM_CLOSE, 0);
+                        readingComplexValue_ = false;
+                        state_ = State::WAIT_COMMA;
+                    }
+                } else if (c == u',' || c == u'}' || isWhitespace(c)) {
+                    writer.event(JSON_XML_PARAM_CLOSE, 0);
+                    state_ = c == u',' ? State::WAIT_KEY_QUOTE : c == u'}' ? State::WAIT_BRACE : State::WAIT_COMMA;
+                } else {
+                    writer.valueChar(c, i);
+                }
+                break;
+            case State::WAIT_COMMA:
+                if (c == u',') {
+                    state_ = State::WAIT_KEY_QUOTE;
+                } else if (c == u'}') {
+                    state_ = State::WAIT_BRACE;
+                }
+                break;
+        }
+        i++;
+    }
+    writer.flush();
+}
+
+void JsonXmlConverter::flush(std::vector<int32_t>& out) {
+    if (state_ != State::READ_PRIMITIVE) {
+        return;
+    }
+    EventWriter writer(out);
+    writer.event(JSON_XML_PARAM_CLOSE, 0);
+    readingComplexValue_ = false;
+    primitiveDepth_ = 0;
+    primitiveInString_ = false;
+    primitiveEscape_ = false;
+    state_ = State::WAIT_COMMA;
+}
+
+void JsonXmlConverter::saveState(int32_t* slots) const {
+    slots[0] = static_cast<int32_t>(state_);
+    slots[1] = unicodeCount_;
+    slots[2] = unicodeValue_;
+    slots[3] = primitiveDepth_;
+    slots[4] = primitiveInString_ ? 1 : 0;
+    slots[5] = primitiveEscape_ ? 1 : 0;
+    slots[6] = readingComplexValue_ ? 1 : 0;
+}
+
+bool JsonXmlConverter::restoreState(const int32_t* slots) {
+    const bool valid = slots[0] >= 0 && slots[0] <= static_cast<int32_t>(State::WAIT_COMMA) &&
+                       slots[1] >= 0 && slots[1] < 4 && slots[2] >= -1 && slots[2] <= 0xfff &&
+                       slots[3] >= 0 && (slots[4] | slots[5] | slots[6]) >= 0 && (slots[4] | slots[5] | slots[6]) <= 1;
+    if (!valid) {
+        reset();
+        return false;
+    }
+    state_ = static_cast<State>(slots[0]);
+    unicodeCount_ = slots[1];
+    unicodeValue_ = slots[2];
+    primitiveDepth_ = slots[3];
+    primitiveInString_ = slots[4] != 0;
+    primitiveEscape_ = slots[5] != 0;
+    readingComplexValue_ = slots[6] != 0;
+    return true;
+}
+
+} // namespace streamnative
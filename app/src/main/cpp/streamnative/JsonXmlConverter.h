@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace streamnative {
+
+// Events of JsonXmlConverter, as (type, a, b) int triples. Ranges index the
+// chunk passed to the push that produced them.
+constexpr int JSON_XML_KEY = 0;          // [a, b) is part of the current key
+constexpr int JSON_XML_PARAM_OPEN = 1;   // key complete: <param name="key">
+constexpr int JSON_XML_TEXT = 2;         // [a, b) is value text with nothing to escape
+constexpr int JSON_XML_CHAR = 3;         // value character a (unescaped, or one XML escapes)
+constexpr int JSON_XML_PARAM_CLOSE = 4;  // </param>
+
+// Push-based port of util/StreamingJsonXmlConverter.kt: turns streamed
+// tool-call `arguments` JSON into <param name="..."> events. Values are
+// reported as ranges of the input wherever possible, so the caller only
+// slices the chunk it pushed. Unlike the Kotlin class, bare and nested
+// values are reported as they arrive instead of once complete.
+class JsonXmlConverter {
+public:
+    // Int slots the whole converter state fits in (see saveState).
+    static constexpr int kStateInts = 7;
+
+    JsonXmlConverter() { reset(); }
+
+    void reset();
+
+    // Appends the events for `chars` to `out`.
+    void push(const char16_t* chars, int len, std::vector<int32_t>& out);
+
+    // Closes a bare or nested value still being read, as the end of the
+    // arguments does.
+    void flush(std::vector<int32_t>& out);
+
+    // The state between pushes, so callers can keep it instead of a native
+    // handle. restoreState returns false (and resets) on slots saveState
+    // cannot have written.
+    void saveState(int32_t* slots) const;
+    bool restoreState(const int32_t* slots);
+
+private:
+    enum class State {
+        WAIT_BRACE,
+        WAIT_KEY_QUOTE,
+        READ_KEY,
+        WAIT_COLON,
+        WAIT_VALUE,
+        READ_STRING,
+        READ_PRIMITIVE,
+        ESCAPE,
+        UNICODE_ESCAPE,
+        WAIT_COMMA,
+    };
+
+    State state_;
+    int unicodeCount_;
+    int unicodeValue_; // -1 once a non-hex digit was seen
+    int primitiveDepth_;
+    bool primitiveInString_;
+    bool primitiveEscape_;
+    bool readingComplexValue_;
+};
+
+} // namespace streamnative
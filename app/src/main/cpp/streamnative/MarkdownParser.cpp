@@ -0,0 +1,712 @@
+#include "MarkdownParser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "MarkdownTypes.h"
+#include "StringExtensions.h"
+
+namespace streamnative {
+
+namespace {
+
+inline bool isStartOfLine(const char16_t* chars, int i) {
+    return i == 0 || chars[i - 1] == u'\n';
+}
+
+inline int findLineEnd(const char16_t* chars, int len, int start) {
+    return indexOfChar(chars, start, len, u'\n');
+}
+
+inline bool startsWithAscii(const char16_t* chars, int len, int i, const char* lit) {
+    int k = 0;
+    while (lit[k] != 0) {
+        if (i + k >= len) return false;
+        if (chars[i + k] != static_cast<char16_t>(lit[k])) return false;
+        k++;
+    }
+    return true;
+}
+
+inline bool isDigit(char16_t c) {
+    return c >= u'0' && c <= u'9';
+}
+
+static int countRun(const char16_t* chars, int len, int i, char16_t ch) {
+    int j = i;
+    while (j < len && chars[j] == ch) {
+        j++;
+    }
+    return j - i;
+}
+
+// Where a delimiter's closer was last looked for. parseInline asks for the
+// first `pat` at or after some position on the same line, and its positions
+// only move forward, so a hit answers every later query up to the hit and a
+// miss answers the rest of the line: each character is scanned at most once
+// per delimiter kind, however many openers on the line never close.
+struct CloserScan {
+    int from = 0;
+    int found = -1;
+    int lineLimit = -1; // newline or end that stopped a miss; -1 before the first scan
+};
+
+// First i >= from with chars[i, i + patLen) == pat before the next newline, or -1.
+static int findCloser(const char16_t* chars, int from, int end, const char16_t* pat, int patLen,
+                      CloserScan& scan) {
+    if (scan.lineLimit >= 0 && from >= scan.from) {
+        if (scan.found >= 0 ? from <= scan.found : from <= scan.lineLimit) {
+            return scan.found;
+        }
+    }
+    int i = from;
+    for (; i < end && chars[i] != u'\n'; i++) {
+        if (chars[i] != pat[0] || i + patLen > end) continue;
+        if (patLen == 1 || chars[i + 1] == pat[1]) break;
+    }
+    scan.from = from;
+    scan.found = (i < end && chars[i] != u'\n') ? i : -1;
+    scan.lineLimit = i;
+    return scan.found;
+}
+
+// Backtick runs of one line, for closing inline code. A closer for an opener
+// of n ticks is the first later run of at least n ticks (its first n), so the
+// line's runs are listed once and a miss is settled by the longest run left.
+struct TickRun {
+    int start;
+    int end;
+};
+
+struct TickRuns {
+    int from = 0;
+    int lineLimit = -1;
+    std::vector<TickRun> runs;
+    std::vector<int> longestFrom; // longest run in runs[k, size)
+    size_t next = 0;
+};
+
+static int findTickCloser(const char16_t* chars, int from, int end, int tickCount, TickRuns& ticks) {
+    if (ticks.lineLimit < 0 || from < ticks.from || from > ticks.lineLimit) {
+        ticks.runs.clear();
+        int i = from;
+        while (i < end && chars[i] != u'\n') {
+            if (chars[i] == u'`') {
+                const int run = countRun(chars, end, i, u'`');
+                ticks.runs.push_back({i, i + run});
+                i += run;
+            } else {
+                i++;
+            }
+        }
+        ticks.longestFrom.resize(ticks.runs.size());
+        int longest = 0;
+        for (size_t k = ticks.runs.size(); k-- > 0;) {
+            longest = std::max(longest, ticks.runs[k].end - ticks.runs[k].start);
+            ticks.longestFrom[k] = longest;
+        }
+        ticks.from = from;
+        ticks.lineLimit = i;
+        ticks.next = 0;
+    }
+    while (ticks.next < ticks.runs.size() && ticks.runs[ticks.next].start < from) {
+        ticks.next++;
+    }
+    if (ticks.next == ticks.runs.size() || ticks.longestFrom[ticks.next] < tickCount) {
+        return -1;
+    }
+    size_t k = ticks.next;
+    while (ticks.runs[k].end - ticks.runs[k].start < tickCount) {
+        k++;
+    }
+    return ticks.runs[k].start;
+}
+
+static void addPlainInline(MarkdownNodes& out, int32_t parent, int start, int end) {
+    if (start >= end) return;
+    out.add(MD_PLAIN_TEXT, start, end, parent);
+}
+
+// Appends the inline nodes of chars[start, end) under block row `parent`;
+// `ticks` is scratch space kept across calls so its lists are reused.
+// Each opener takes the first closer after it on its line; everything in
+// between is its content and is not parsed further.
+static void parseInline(const char16_t* chars, int start, int end, MarkdownNodes& out, int32_t parent,
+                        TickRuns& ticks) {
+    CloserScan bracketClose;
+    CloserScan parenClose;
+    CloserScan tildeClose;
+    CloserScan underscoreClose;
+    CloserScan boldClose;
+    CloserScan starClose;
+    ticks.lineLimit = -1;
+    int tickRunEnd = -1; // end of the backtick run last counted
+
+    int i = start;
+    int plainStart = start;
+
+    while (i < end) {
+        const char16_t c = chars[i];
+
+        // Link: [text](url) (keep delimiters)
+        if (c == u'[') {
+            const int closeBracket = findCloser(chars, i + 1, end, u"]", 1, bracketClose);
+            if (closeBracket != -1 && closeBracket + 1 < end && chars[closeBracket + 1] == u'(') {
+                const int closeParen = findCloser(chars, closeBracket + 2, end, u")", 1, parenClose);
+                if (closeParen != -1) {
+                    addPlainInline(out, parent, plainStart, i);
+                    out.add(MD_LINK, i, closeParen + 1, parent);
+                    i = closeParen + 1;
+                    plainStart = i;
+                    continue;
+                }
+            }
+        }
+
+        // Inline code: `code` or ``code`` (strip ticks)
+        if (c == u'`') {
+            // Inside a run that did not close, the rest of it is the next opener.
+            if (i >= tickRunEnd) {
+                tickRunEnd = i + countRun(chars, end, i, u'`');
+            }
+            const int tickCount = tickRunEnd - i;
+            const int close = findTickCloser(chars, tickRunEnd, end, tickCount, ticks);
+            if (close != -1) {
+                addPlainInline(out, parent, plainStart, i);
+                out.add(MD_INLINE_CODE, i + tickCount, close, parent);
+                i = close + tickCount;
+                plainStart = i;
+                continue;
+            }
+        }
+
+        // Strikethrough: ~~text~~ (strip delimiters)
+        if (c == u'~' && i + 1 < end && chars[i + 1] == u'~') {
+            const int close = findCloser(chars, i + 2, end, u"~~", 2, tildeClose);
+            if (close != -1) {
+                addPlainInline(out, parent, plainStart, i);
+                out.add(MD_STRIKETHROUGH, i + 2, close, parent);
+                i = close + 2;
+                plainStart = i;
+                continue;
+            }
+        }
+
+        // Underline: __text__ (keep delimiters)
+        if (c == u'_' && i + 1 < end && chars[i + 1] == u'_') {
+            const int close = findCloser(chars, i + 2, end, u"__", 2, underscoreClose);
+            if (close != -1) {
+                addPlainInline(out, parent, plainStart, i);
+                out.add(MD_UNDERLINE, i, close + 2, parent);
+                i = close + 2;
+                plainStart = i;
+                continue;
+            }
+        }
+
+        // Bold: **text** (strip delimiters)
+        if (c == u'*' && i + 1 < end && chars[i + 1] == u'*') {
+            const int close = findCloser(chars, i + 2, end, u"**", 2, boldClose);
+            if (close != -1) {
+                addPlainInline(out, parent, plainStart, i);
+                out.add(MD_BOLD, i + 2, close, parent);
+                i = close + 2;
+                plainStart = i;
+                continue;
+            }
+        }
+
+        // Italic: *text* (strip delimiters) - avoid **
+        if (c == u'*' && !(i + 1 < end && chars[i + 1] == u'*')) {
+            const int close = findCloser(chars, i + 1, end, u"*", 1, starClose);
+            if (close != -1) {
+                addPlainInline(out, parent, plainStart, i);
+                out.add(MD_ITALIC, i + 1, close, parent);
+                i = close + 1;
+                plainStart = i;
+                continue;
+            }
+        }
+
+        i++;
+    }
+
+    addPlainInline(out, parent, plainStart, end);
+}
+
+static bool isHorizontalRuleLine(const char16_t* chars, int lineStart, int lineEnd) {
+    int count = 0;
+    char16_t marker = 0;
+    for (int i = lineStart; i < lineEnd; i++) {
+        const char16_t c = chars[i];
+        if (c == u' ' || c == u'\t' || c == u'\r') continue;
+        if (marker == 0) {
+            if (c != u'-' && c != u'*' && c != u'_') return false;
+            marker = c;
+            count = 1;
+        } else {
+            if (c != marker) return false;
+            count++;
+        }
+    }
+    return marker != 0 && count >= 3;
+}
+
+// End (exclusive) of the first "</plan>" at or after `from`, or -1.
+int findPlanEnd(const char16_t* chars, int len, int from) {
+    for (int j = from; j + 6 < len; j++) {
+        if (chars[j] == u'<' && startsWithAscii(chars, len, j, "</plan>")) {
+            return j + 7;
+        }
+    }
+    return -1;
+}
+
+// End of the fenced code block opened by `tickCount` backticks at line start
+// `i`: just past the closing fence line, or len if it is never closed.
+// `closed` is set once the closing fence line has its '\n'.
+int findFenceEnd(const char16_t* chars, int len, int i, int tickCount, bool& closed) {
+    closed = false;
+    const int lineEnd = findLineEnd(chars, len, i);
+    int search = (lineEnd < len) ? (lineEnd + 1) : len;
+    while (search < len) {
+        const int ls = search;
+        const int le = findLineEnd(chars, len, ls);
+        int p = ls;
+        while (p < le && chars[p] == u' ') p++;
+        if (p + tickCount <= le) {
+            bool ok = true;
+            for (int k = 0; k < tickCount; k++) {
+                if (chars[p + k] != u'`') {
+                    ok = false;
+                    break;
+                }
+            }
+            if (ok) {
+                closed = le < len;
+                return (le < len) ? (le + 1) : le;
+            }
+        }
+        search = (le < len) ? (le + 1) : len;
+    }
+    return len;
+}
+
+inline bool isHeaderLine(const char16_t* chars, int len, int i) {
+    const int count = countRun(chars, len, i, u'#');
+    return count >= 1 && count <= 6 && i + count < len && chars[i + count] == u' ';
+}
+
+inline bool isQuoteLine(const char16_t* chars, int len, int i) {
+    return chars[i] == u'>' && i + 1 < len && chars[i + 1] == u' ';
+}
+
+// Source range of a parsed block, its row, and whether text appended after
+// the parsed input can still change it.
+struct BlockExtent {
+    int start;
+    int end;
+    bool closed;
+    size_t row;
+};
+
+// Parses chars[from, len) as parseMarkdown would after reaching `from` with no
+// pending plain text, appending to `nodes` (and `extents`). Returns the
+// first `<plan` that found no `</plan>`, or -1: later input can turn it into a
+// plan block that swallows everything after it.
+int parseBlocksFrom(const char16_t* chars, int len, int from, MarkdownNodes& nodes,
+                    std::vector<BlockExtent>* extents) {
+    int i = from;
+    int plainStart = from;
+    int firstOpenPlan = -1;
+    TickRuns ticks;
+
+    // Called once per block, when its piece range is final.
+    auto addExtent = [&](int32_t row, int start, int end, bool closed) {
+        const int pieceStart = nodes.pieceStart[row];
+        nodes.blockHashes.push_back(hashContent(chars + pieceStart, nodes.pieceEnd[row] - pieceStart));
+        if (extents != nullptr) {
+            extents->push_back({start, end, closed, static_cast<size_t>(row)});
+        }
+    };
+
+    auto flushPlainAsBlock = [&](int endExclusive) {
+        if (plainStart >= endExclusive) {
+            plainStart = endExclusive;
+            return;
+        }
+        const int32_t row = nodes.add(MD_PLAIN_TEXT, plainStart, endExclusive, -1);
+        parseInline(chars, plainStart, endExclusive, nodes, row, ticks);
+        // Plain text ends where the next block starts; at the end of input it may still grow.
+        addExtent(row, plainStart, endExclusive, endExclusive < len);
+        plainStart = endExclusive;
+    };
+
+    while (i < len) {
+        const bool atSol = isStartOfLine(chars, i);
+
+        // <plan...>...</plan>
+        if (chars[i] == u'<' && startsWithAscii(chars, len, i, "<plan")) {
+            const int endTag = findPlanEnd(chars, len, i + 5);
+            if (endTag != -1) {
+                flushPlainAsBlock(i);
+                addExtent(nodes.add(MD_PLAN_EXECUTION, i, endTag, -1), i, endTag, true);
+                i = endTag;
+                plainStart = i;
+                continue;
+            }
+            if (firstOpenPlan < 0) {
+                firstOpenPlan = i;
+            }
+        }
+
+        // Fenced code block ```...
+        if (atSol && chars[i] == u'`') {
+            const int tickCount = countRun(chars, len, i, u'`');
+            if (tickCount >= 3) {
+                bool closed = false;
+                const int endPos = findFenceEnd(chars, len, i, tickCount, closed);
+
+                flushPlainAsBlock(i);
+                addExtent(nodes.add(MD_CODE_BLOCK, i, endPos, -1), i, endPos, closed);
+                i = endPos;
+                plainStart = i;
+                continue;
+            }
+        }
+
+        // Header #.. (1-6)
+        if (atSol && chars[i] == u'#') {
+            if (isHeaderLine(chars, len, i)) {
+                const int le = findLineEnd(chars, len, i);
+                flushPlainAsBlock(i);
+                const int next = (le < len) ? (le + 1) : le;
+                const int32_t row = nodes.add(MD_HEADER, i, next, -1);
+                parseInline(chars, i, le, nodes, row, ticks);
+                addExtent(row, i, next, le < len);
+                i = next;
+                plainStart = i;
+                continue;
+            }
+        }
+
+        // Block quote lines starting with "> " (strip marker)
+        if (atSol && isQuoteLine(chars, len, i)) {
+            flushPlainAsBlock(i);
+
+            const int32_t row = nodes.add(MD_BLOCK_QUOTE, i, i, -1);
+            const size_t firstInline = static_cast<size_t>(row) + 1;
+
+            int cur = i;
+            bool closed = false;
+            while (cur < len) {
+                const int le = findLineEnd(chars, len, cur);
+                const int contentStart = std::min(cur + 2, le);
+                // Each line's inline nodes replace the previous line's.
+                nodes.truncate(firstInline, nodes.blockCount);
+                if (contentStart < le) {
+                    parseInline(chars, contentStart, le, nodes, row, ticks);
+                }
+
+                // Merge as plain text inline nodes per line to preserve content
+                // Represent each line as inline nodes to keep delimiter stripping.
+                // We keep it simple: re-parse inline per line and append.
+                if (nodes.size() == firstInline) {
+                    nodes.add(MD_PLAIN_TEXT, contentStart, le, row);
+                }
+
+                if (le < len) {
+                    nodes.add(MD_PLAIN_TEXT, le, le + 1, row);
+                }
+
+                if (le >= len) {
+                    cur = len;
+                    break;
+                }
+
+                const int next = le + 1;
+                if (next < len && isQuoteLine(chars, len, next)) {
+                    cur = next;
+                    continue;
+                }
+
+                // The run is over only once the next line visibly does not start with "> ".
+                closed = next + 1 < len || (next < len && chars[next] != u'>');
+                cur = next;
+                break;
+            }
+
+            nodes.pieceEnd[row] = cur;
+            addExtent(row, i, cur, closed);
+            i = cur;
+            plainStart = i;
+            continue;
+        }
+
+        // Horizontal rule line
+        if (atSol) {
+            const int le = findLineEnd(chars, len, i);
+            if (isHorizontalRuleLine(chars, i, le)) {
+                flushPlainAsBlock(i);
+                const int next = (le < len) ? (le + 1) : le;
+                addExtent(nodes.add(MD_HORIZONTAL_RULE, i, le, -1), i, next, le < len);
+                i = next;
+                plainStart = i;
+                continue;
+            }
+        }
+
+        i++;
+    }
+
+    flushPlainAsBlock(len);
+
+    return firstOpenPlan;
+}
+
+// Below this parseMarkdownParallel parses serially; thread start-up would
+// cost more than it saves.
+constexpr int kParallelMinChars = 64 * 1024;
+constexpr int kParallelMinChunk = 16 * 1024;
+// More chunks than threads, so one slow chunk does not hold up the rest.
+constexpr int kChunksPerThread = 4;
+
+// Line starts right after blank lines that parseBlocksFrom reaches at a line
+// start, i.e. outside fenced code and <plan> spans, at least `minChunk`
+// apart. Follows parseBlocksFrom's block skeleton without building blocks:
+// fences, plans, headers, quote runs and rules are skipped the same way, and
+// the rest is only searched for "<plan". Parsing from such a point gives the
+// serial blocks, except that plain text across it is cut in two.
+std::vector<int> findSplitPoints(const char16_t* chars, int len, int minChunk) {
+    std::vector<int> splits;
+    int lastSplit = 0;
+
+    // Plans are visited in order, so one forward search answers all of them.
+    int planSearchFrom = -1;
+    int planEnd = -1;
+    auto planEndFrom = [&](int from) {
+        if (planSearchFrom < 0 || from < planSearchFrom || (planEnd != -1 && planEnd - 7 < from)) {
+            planEnd = findPlanEnd(chars, len, from);
+            planSearchFrom = from;
+        }
+        return planEnd;
+    };
+
+    int i = 0;
+    while (i < len) {
+        // i is a line start.
+        const char16_t c = chars[i];
+        if (c == u'\n') {
+            i++;
+            if (i < len && i - lastSplit >= minChunk) {
+                splits.push_back(i);
+                lastSplit = i;
+            }
+            continue;
+        }
+        if (c == u'`') {
+            const int tickCount = countRun(chars, len, i, u'`');
+            if (tickCount >= 3) {
+                bool closed = false;
+                i = findFenceEnd(chars, len, i, tickCount, closed);
+                continue;
+            }
+        }
+        const int le = findLineEnd(chars, len, i);
+        const int next = (le < len) ? (le + 1) : le;
+        if ((c == u'#' && isHeaderLine(chars, len, i)) || isHorizontalRuleLine(chars, i, le)) {
+            i = next;
+            continue;
+        }
+        if (isQuoteLine(chars, len, i)) {
+            i = next;
+            while (i < len && isQuoteLine(chars, len, i)) {
+                i = std::min(findLineEnd(chars, len, i) + 1, len);
+            }
+            continue;
+        }
+
+        // Plain line: only a closed plan can carry it past its '\n'.
+        int p = i;
+        for (;;) {
+            p = indexOfAnyChar(chars, p, len, u'<', u'\n');
+            if (p >= len || chars[p] == u'\n') {
+                break;
+            }
+            if (startsWithAscii(chars, len, p, "<plan")) {
+                const int end = planEndFrom(p + 5);
+                if (end != -1) {
+                    p = end;
+                    continue;
+                }
+            }
+            p++;
+        }
+        i = (p < len) ? (p + 1) : len;
+    }
+    return splits;
+}
+
+// Appends one chunk's rows. Chunks start after a blank line, and plain
+// text never ends at a line start on its own, so a chunk that begins with
+// plain text continues the plain block the previous chunk ended with.
+// Inline nodes never span a '\n', so only the plain runs at the seam merge.
+void appendChunkNodes(MarkdownNodes& nodes, const MarkdownNodes& chunk, const char16_t* chars) {
+    const size_t count = chunk.size();
+    size_t k = 0;
+    size_t blocks = chunk.blockCount;
+    if (nodes.size() > 0 && count > 0) {
+        const int32_t last = static_cast<int32_t>(nodes.size() - 1);
+        const int32_t lastBlock = nodes.parentIndex[last] < 0 ? last : nodes.parentIndex[last];
+        if (nodes.types[lastBlock] == MD_PLAIN_TEXT && chunk.types[0] == MD_PLAIN_TEXT) {
+            nodes.pieceEnd[lastBlock] = chunk.pieceEnd[0];
+            const int mergedStart = nodes.pieceStart[lastBlock];
+            nodes.blockHashes.back() = hashContent(chars + mergedStart, chunk.pieceEnd[0] - mergedStart);
+            k = 1;
+            blocks--;
+            if (last != lastBlock && k < count && chunk.parentIndex[k] == 0 && nodes.types[last] == MD_PLAIN_TEXT &&
+                chunk.types[k] == MD_PLAIN_TEXT && nodes.pieceEnd[last] == chunk.pieceStart[k]) {
+                nodes.pieceEnd[last] = chunk.pieceEnd[k];
+                k++;
+            }
+            for (; k < count && chunk.parentIndex[k] == 0; k++) {
+                nodes.add(chunk.types[k], chunk.pieceStart[k], chunk.pieceEnd[k], lastBlock);
+            }
+        }
+    }
+
+    // The rest keeps its shape; parent rows move by where it lands.
+    const int32_t shift = static_cast<int32_t>(nodes.size()) - static_cast<int32_t>(k);
+    nodes.types.insert(nodes.types.end(), chunk.types.begin() + k, chunk.types.end());
+    nodes.pieceStart.insert(nodes.pieceStart.end(), chunk.pieceStart.begin() + k, chunk.pieceStart.end());
+    nodes.pieceEnd.insert(nodes.pieceEnd.end(), chunk.pieceEnd.begin() + k, chunk.pieceEnd.end());
+    nodes.blockHashes.insert(nodes.blockHashes.end(), chunk.blockHashes.end() - static_cast<std::ptrdiff_t>(blocks),
+                             chunk.blockHashes.end());
+    for (; k < count; k++) {
+        const int32_t parent = chunk.parentIndex[k];
+        nodes.parentIndex.push_back(parent < 0 ? -1 : parent + shift);
+    }
+    nodes.blockCount += blocks;
+}
+
+} // namespace
+
+MarkdownNodes parseMarkdown(const char16_t* chars, int len) {
+    MarkdownNodes nodes;
+    nodes.reserve(64);
+    parseBlocksFrom(chars, len, 0, nodes, nullptr);
+    return nodes;
+}
+
+MarkdownNodes parseMarkdownParallel(const char16_t* chars, int len, int threads) {
+    if (threads <= 1 || len < kParallelMinChars) {
+        return parseMarkdown(chars, len);
+    }
+    const int minChunk = std::max(kParallelMinChunk, len / (threads * kChunksPerThread));
+    std::vector<int> bounds = findSplitPoints(chars, len, minChunk);
+    if (bounds.empty()) {
+        return parseMarkdown(chars, len);
+    }
+    bounds.insert(bounds.begin(), 0);
+    bounds.push_back(len);
+
+    // Chunk k covers [bounds[k], bounds[k + 1]); offsets stay global because
+    // every chunk is parsed in place.
+    const size_t chunkCount = bounds.size() - 1;
+    std::vector<MarkdownNodes> parts(chunkCount);
+    std::atomic<size_t> nextChunk{0};
+    auto work = [&]() {
+        for (size_t k = nextChunk.fetch_add(1); k < chunkCount; k = nextChunk.fetch_add(1)) {
+            parts[k].reserve(64);
+            parseBlocksFrom(chars, bounds[k + 1], bounds[k], parts[k], nullptr);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const size_t helpers = std::min(static_cast<size_t>(threads), chunkCount) - 1;
+    workers.reserve(helpers);
+    for (size_t t = 0; t < helpers; t++) {
+        try {
+            workers.emplace_back(work);
+        } catch (const std::system_error&) {
+            // Out of threads: the ones running (and this one) take the rest.
+            break;
+        }
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    MarkdownNodes nodes;
+    size_t total = 0;
+    for (const auto& part : parts) {
+        total += part.size();
+    }
+    nodes.reserve(total);
+    for (const auto& part : parts) {
+        appendChunkNodes(nodes, part, chars);
+    }
+    return nodes;
+}
+
+void flattenMarkdownNodes(const MarkdownNodes& nodes, size_t fromRow, std::vector<int32_t>& out) {
+    const size_t count = nodes.size() - fromRow;
+    const int32_t shift = static_cast<int32_t>(fromRow);
+    size_t blocks = 0;
+    for (size_t r = fromRow; r < nodes.size(); r++) {
+        blocks += nodes.parentIndex[r] < 0 ? 1 : 0;
+    }
+    out.reserve(out.size() + 1 + count * 4 + blocks * 2);
+    out.push_back(static_cast<int32_t>(count));
+    out.insert(out.end(), nodes.types.begin() + fromRow, nodes.types.end());
+    out.insert(out.end(), nodes.pieceStart.begin() + fromRow, nodes.pieceStart.end());
+    out.insert(out.end(), nodes.pieceEnd.begin() + fromRow, nodes.pieceEnd.end());
+    for (size_t r = fromRow; r < nodes.size(); r++) {
+        const int32_t parent = nodes.parentIndex[r];
+        out.push_back(parent < 0 ? -1 : parent - shift);
+    }
+    for (size_t b = nodes.blockHashes.size() - blocks; b < nodes.blockHashes.size(); b++) {
+        const uint64_t hash = nodes.blockHashes[b];
+        out.push_back(static_cast<int32_t>(static_cast<uint32_t>(hash)));
+        out.push_back(static_cast<int32_t>(static_cast<uint32_t>(hash >> 32)));
+    }
+}
+
+int IncrementalMarkdownParser::append(const char16_t* chars, int len) {
+    const int kept = static_cast<int>(stableCount_);
+    keptRows_ = stableRows_;
+    if (chars != nullptr && len > 0) {
+        text_.append(chars, static_cast<size_t>(len));
+    }
+
+    nodes_.truncate(stableRows_, stableCount_);
+    std::vector<BlockExtent> extents;
+    const int total = static_cast<int>(text_.size());
+    const int firstOpenPlan = parseBlocksFrom(text_.data(), total, stableEnd_, nodes_, &extents);
+
+    // Keep every block up to the first one that later input could still
+    // change. Plain text in front of an open block stays open too: if that
+    // block is revoked (an unfinished rule line) the text merges into it.
+    size_t open = 0;
+    while (open < extents.size() && extents[open].closed &&
+           (firstOpenPlan < 0 || extents[open].end <= firstOpenPlan)) {
+        open++;
+    }
+    if (open < extents.size() && open > 0 && nodes_.types[extents[open - 1].row] == MD_PLAIN_TEXT) {
+        open--;
+    }
+
+    if (open > 0) {
+        stableEnd_ = (open < extents.size()) ? extents[open].start : extents[open - 1].end;
+        stableRows_ = (open < extents.size()) ? extents[open].row : nodes_.size();
+        stableCount_ += open;
+    }
+    return kept;
+}
+
+} // namespace streamnative
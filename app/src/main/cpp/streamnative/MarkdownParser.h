@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace streamnative {
+
+// A parsed message as parallel columns, one row per node in document
+// order: each block followed by its inline nodes. parentIndex is -1 for a
+// block and the block's row for an inline node. [pieceStart, pieceEnd)
+// indexes the parsed chars: a node's text (delimiters stripped where its
+// type says so), or for a block with inline nodes its whole source range.
+// The parser appends rows to the columns, so a message costs a few column
+// reallocations rather than one or more allocations per node.
+// blockHashes holds, per block in order, hashContent() of its [pieceStart,
+// pieceEnd): a renderer can key highlighted code or rendered LaTeX by it and
+// skip blocks whose source did not change.
+struct MarkdownNodes {
+    std::vector<int32_t> types;
+    std::vector<int32_t> pieceStart;
+    std::vector<int32_t> pieceEnd;
+    std::vector<int32_t> parentIndex;
+    std::vector<uint64_t> blockHashes;
+    size_t blockCount = 0;
+
+    size_t size() const { return types.size(); }
+
+    void reserve(size_t rows) {
+        types.reserve(rows);
+        pieceStart.reserve(rows);
+        pieceEnd.reserve(rows);
+        parentIndex.reserve(rows);
+    }
+
+    // Returns the new row.
+    int32_t add(int type, int start, int end, int32_t parent) {
+        types.push_back(type);
+        pieceStart.push_back(start);
+        pieceEnd.push_back(end);
+        parentIndex.push_back(parent);
+        if (parent < 0) {
+            blockCount++;
+        }
+        return static_cast<int32_t>(types.size() - 1);
+    }
+
+    // Drops rows [rows, size()); `blocks` is the number of blocks left.
+    void truncate(size_t rows, size_t blocks) {
+        types.resize(rows);
+        pieceStart.resize(rows);
+        pieceEnd.resize(rows);
+        parentIndex.resize(rows);
+        // A block gets its hash once its extent is final, so the last one may have none yet.
+        if (blockHashes.size() > blocks) {
+            blockHashes.resize(blocks);
+        }
+        blockCount = blocks;
+    }
+};
+
+// Parses a whole message into blocks (plan, fenced code, header, quote, rule,
+// plain) with inline nodes. Offsets index into `chars`.
+MarkdownNodes parseMarkdown(const char16_t* chars, int len);
+
+// Same result as parseMarkdown. Large inputs are cut at blank lines outside
+// fenced code and <plan> spans and the pieces parsed on up to `threads`
+// threads (the caller's included); small ones are parsed serially.
+MarkdownNodes parseMarkdownParallel(const char16_t* chars, int len, int threads);
+
+// Appends rows [fromRow, size()) in the NativeMarkdownParser wire format:
+// [count, types[count], pieceStart[count], pieceEnd[count], parentIndex[count],
+//  (low, high) 32-bit halves of each of those rows' block hashes],
+// with parent rows counted from `fromRow`. `fromRow` must be a block's row.
+void flattenMarkdownNodes(const MarkdownNodes& nodes, size_t fromRow, std::vector<int32_t>& out);
+
+// Append-only parser for a message that grows while it is rendered. Blocks
+// that can no longer change are kept; each append reparses only from the
+// first block that is still open (unclosed fence, quote run, trailing plain
+// text, ...). nodes() always equals parseMarkdown(text()).
+class IncrementalMarkdownParser {
+public:
+    // Appends `chars` and returns how many leading blocks are unchanged from
+    // the previous call; the rows from keptRows() on are new or rebuilt.
+    int append(const char16_t* chars, int len);
+
+    const std::u16string& text() const { return text_; }
+    const MarkdownNodes& nodes() const { return nodes_; }
+
+    // Rows of the blocks the last append() reported unchanged.
+    size_t keptRows() const { return keptRows_; }
+
+private:
+    std::u16string text_;
+    MarkdownNodes nodes_;
+    size_t stableCount_ = 0; // the first stableCount_ blocks are final
+    size_t stableRows_ = 0;  // and take this many rows
+    size_t keptRows_ = 0;
+    int stableEnd_ = 0;      // where the next parse resumes
+};
+
+} // namespace streamnative
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace streamnative {
+
+// Must match com.ai.assistance.operit.util.markdown.MarkdownProcessorType ordinals.
+constexpr int MD_HEADER = 0;
+constexpr int MD_BLOCK_QUOTE = 1;
+constexpr int MD_CODE_BLOCK = 2;
+constexpr int MD_ORDERED_LIST = 3;
+constexpr int MD_UNORDERED_LIST = 4;
+constexpr int MD_HORIZONTAL_RULE = 5;
+constexpr int MD_BLOCK_LATEX = 6;
+constexpr int MD_TABLE = 7;
+constexpr int MD_XML_BLOCK = 8;
+constexpr int MD_PLAN_EXECUTION = 9;
+constexpr int MD_BOLD = 10;
+constexpr int MD_ITALIC = 11;
+constexpr int MD_INLINE_CODE = 12;
+constexpr int MD_LINK = 13;
+constexpr int MD_IMAGE = 14;
+constexpr int MD_STRIKETHROUGH = 15;
+constexpr int MD_UNDERLINE = 16;
+constexpr int MD_INLINE_LATEX = 17;
+constexpr int MD_PLAIN_TEXT = 18;
+
+} // namespace streamnative
@@ -1,16 +1,30 @@
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "StreamSnapshot.h"
+
 namespace streamnative {
 
 class KmpMatcher {
 public:
     void reset() { j_ = 0; }
 
-    void setPattern(std::u16string p) {
-        pattern_ = std::move(p);
+    // True while a prefix of the pattern has been matched; characters other
+    // than the pattern's first one cannot complete a match otherwise.
+    bool inProgress() const { return j_ > 0; }
+
+    char16_t firstChar() const { return pattern_.empty() ? u'\0' : pattern_[0]; }
+
+    // Reuses the pattern and prefix-table storage, so rebinding to patterns
+    // of similar length does not allocate.
+    void setPattern(const std::u16string& p) {
+        pattern_.assign(p);
         pi_.assign(pattern_.size(), 0);
         for (size_t i = 1; i < pattern_.size(); i++) {
             int k = pi_[i - 1];
@@ -25,6 +39,14 @@ public:
         j_ = 0;
     }
 
+    // Only the match position is saved; the pattern is rebuilt by its owner.
+    void saveState(SnapshotWriter& out) const { out.writeInt(j_); }
+
+    bool restoreState(SnapshotReader& in) {
+        j_ = in.readInt(0, pattern_.empty() ? 0 : static_cast<int>(pattern_.size()) - 1);
+        return in.ok();
+    }
+
     bool process(char16_t c) {
         if (pattern_.empty()) {
             return false;
@@ -48,4 +70,146 @@ private:
     int j_ = 0;
 };
 
+// Aho-Corasick automaton over the delimiters of up to OwnerCount owners (the
+// plugins of a session). advance() consumes one character; live(state) holds
+// every owner with a delimiter that the text read so far is in the middle of
+// or has just completed. Whatever the previous state, live(advance(s, c))
+// contains the owners of every delimiter starting with c, so callers may drop
+// back to kRoot whenever they skip characters.
+template <size_t OwnerCount>
+class MultiPatternMatcher {
+public:
+    using Owners = std::bitset<OwnerCount>;
+    static constexpr int kRoot = 0;
+
+    MultiPatternMatcher() { nodes_.emplace_back(); }
+
+    void addPattern(const std::u16string& pattern, size_t owner) {
+        int node = kRoot;
+        for (char16_t c : pattern) {
+            int next = child(node, c);
+            if (next < 0) {
+                next = static_cast<int>(nodes_.size());
+                nodes_.emplace_back();
+                if (c < kAscii) {
+                    nodes_[static_cast<size_t>(node)].ascii[c] = next;
+                } else {
+                    nodes_[static_cast<size_t>(node)].wide.emplace_back(c, next);
+                }
+            }
+            node = next;
+            nodes_[static_cast<size_t>(node)].live.set(owner);
+        }
+    }
+
+    // For owners that cannot list their delimiters: live in every state, and
+    // every character counts as a delimiter start.
+    void addWildcardOwner(size_t owner) {
+        wildcard_.set(owner);
+    }
+
+    // Resolves failure links into a full ASCII transition table and folds the
+    // live owners of each state's proper suffixes into it. Call once, after
+    // the last addPattern.
+    void build() {
+        std::vector<int> order;
+        order.reserve(nodes_.size());
+        Node& root = nodes_[kRoot];
+        root.live |= wildcard_;
+        for (int& next : root.ascii) {
+            if (next < 0) {
+                next = kRoot;
+            } else {
+                nodes_[static_cast<size_t>(next)].fail = kRoot;
+                order.push_back(next);
+            }
+        }
+        for (const auto& edge : root.wide) {
+            nodes_[static_cast<size_t>(edge.second)].fail = kRoot;
+            order.push_back(edge.second);
+        }
+        // Breadth-first, so a node's failure target is complete before the node.
+        for (size_t k = 0; k < order.size(); k++) {
+            const int node = order[k];
+            Node& n = nodes_[static_cast<size_t>(node)];
+            const Node& fail = nodes_[static_cast<size_t>(n.fail)];
+            n.live |= fail.live;
+            for (size_t c = 0; c < kAscii; c++) {
+                const int next = n.ascii[c];
+                if (next < 0) {
+                    n.ascii[c] = fail.ascii[c];
+                } else {
+                    nodes_[static_cast<size_t>(next)].fail = fail.ascii[c];
+                    order.push_back(next);
+                }
+            }
+            for (const auto& edge : n.wide) {
+                nodes_[static_cast<size_t>(edge.second)].fail = advance(n.fail, edge.first);
+                order.push_back(edge.second);
+            }
+        }
+        hasWildcard_ = wildcard_.any();
+    }
+
+    int advance(int state, char16_t c) const {
+        if (c < kAscii) {
+            return nodes_[static_cast<size_t>(state)].ascii[c];
+        }
+        for (;;) {
+            const int next = child(state, c);
+            if (next >= 0) {
+                return next;
+            }
+            if (state == kRoot) {
+                return kRoot;
+            }
+            state = nodes_[static_cast<size_t>(state)].fail;
+        }
+    }
+
+    const Owners& live(int state) const { return nodes_[static_cast<size_t>(state)].live; }
+
+    int stateCount() const { return static_cast<int>(nodes_.size()); }
+
+    // True if some delimiter starts with c (always, with a wildcard owner).
+    bool startsPattern(char16_t c) const {
+        if (hasWildcard_) {
+            return true;
+        }
+        if (c < kAscii) {
+            return nodes_[kRoot].ascii[c] != kRoot;
+        }
+        return child(kRoot, c) >= 0;
+    }
+
+private:
+    static constexpr size_t kAscii = 128;
+
+    struct Node {
+        Node() { ascii.fill(-1); }
+
+        std::array<int32_t, kAscii> ascii;
+        std::vector<std::pair<char16_t, int>> wide;
+        int fail = kRoot;
+        Owners live;
+    };
+
+    int child(int node, char16_t c) const {
+        const Node& n = nodes_[static_cast<size_t>(node)];
+        if (c < kAscii) {
+            return n.ascii[c];
+        }
+        for (const auto& edge : n.wide) {
+            if (edge.first == c) {
+                return edge.second;
+            }
+        }
+        return -1;
+    }
+
+    std::vector<Node> nodes_;
+    Owners wildcard_;
+    bool hasWildcard_ = false;
+};
+
 } // namespace streamnative
@@ -0,0 +1,96 @@
+#include "StreamNativeCApi.h"
+
+#include <new>
+#include <vector>
+
+#include "StreamOperators.h"
+
+static_assert(sizeof(streamnative::Segment) == 3 * sizeof(int32_t), "segments are handed out as int32 triples");
+static_assert(sizeof(char16_t) == sizeof(uint16_t), "decoded text is handed out as uint16_t");
+
+struct StreamNativeSession {
+    streamnative::MarkdownSession* session = nullptr;
+    std::vector<streamnative::Segment> segments;
+};
+
+namespace {
+
+StreamNativeSession* createMarkdownSession(int32_t kind) {
+    streamnative::MarkdownSession* session = nullptr;
+    switch (kind) {
+        case STREAMNATIVE_SESSION_BLOCK:
+            session = streamnative::createMarkdownBlockSession();
+            break;
+        case STREAMNATIVE_SESSION_INLINE:
+            session = streamnative::createMarkdownInlineSession();
+            break;
+        case STREAMNATIVE_SESSION_NESTED:
+            session = streamnative::createMarkdownNestedSession();
+            break;
+        default:
+            return nullptr;
+    }
+    auto* handle = new (std::nothrow) StreamNativeSession();
+    if (handle == nullptr) {
+        streamnative::destroyMarkdownSession(session);
+        return nullptr;
+    }
+    handle->session = session;
+    handle->segments.reserve(64);
+    return handle;
+}
+
+void destroySession(StreamNativeSession* handle) {
+    if (handle == nullptr) {
+        return;
+    }
+    streamnative::destroyMarkdownSession(handle->session);
+    delete handle;
+}
+
+int32_t pushUtf8(StreamNativeSession* handle, const uint8_t* bytes, int32_t len, const uint16_t** text,
+                 int32_t* textLen, const int32_t** segments) {
+    if (handle == nullptr || (bytes == nullptr && len > 0) || len < 0 || text == nullptr || textLen == nullptr ||
+        segments == nullptr) {
+        return -1;
+    }
+    handle->segments.clear();
+    int units = 0;
+    const char16_t* decoded = nullptr;
+    if (len > 0) {
+        streamnative::markdownSessionPushInto(handle->session, bytes, len, handle->segments);
+        decoded = streamnative::markdownSessionDecodedText(handle->session, units);
+    }
+    *text = reinterpret_cast<const uint16_t*>(decoded);
+    *textLen = units;
+    *segments = reinterpret_cast<const int32_t*>(handle->segments.data());
+    return static_cast<int32_t>(handle->segments.size());
+}
+
+int32_t flushUtf8(StreamNativeSession* handle, const uint16_t** text, int32_t* textLen, const int32_t** segments) {
+    if (handle == nullptr || text == nullptr || textLen == nullptr || segments == nullptr) {
+        return -1;
+    }
+    handle->segments.clear();
+    streamnative::markdownSessionFlushUtf8Into(handle->session, handle->segments);
+    int units = 0;
+    const char16_t* decoded = streamnative::markdownSessionDecodedText(handle->session, units);
+    *text = units > 0 ? reinterpret_cast<const uint16_t*>(decoded) : nullptr;
+    *textLen = units;
+    *segments = reinterpret_cast<const int32_t*>(handle->segments.data());
+    return static_cast<int32_t>(handle->segments.size());
+}
+
+const StreamNativeCApi kApi = {
+        STREAMNATIVE_C_API_VERSION,
+        &createMarkdownSession,
+        &destroySession,
+        &pushUtf8,
+        &flushUtf8,
+};
+
+} // namespace
+
+extern "C" __attribute__((visibility("default"))) const StreamNativeCApi* streamnative_get_c_api(int32_t version) {
+    return version >= 1 && version <= STREAMNATIVE_C_API_VERSION ? &kApi : nullptr;
+}
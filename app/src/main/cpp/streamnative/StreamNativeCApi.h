@@ -0,0 +1,56 @@
+#pragma once
+
+// Plain C entry points of libstreamnative.so for other native libraries in
+// the app (the llama generation loop), which load it with dlopen and resolve
+// streamnative_get_c_api. Bump STREAMNATIVE_C_API_VERSION when the table
+// changes; callers pass the version they were built against.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAMNATIVE_C_API_VERSION 2
+
+// Session kinds for createMarkdownSession.
+#define STREAMNATIVE_SESSION_BLOCK 0
+#define STREAMNATIVE_SESSION_INLINE 1
+#define STREAMNATIVE_SESSION_NESTED 2
+
+typedef struct StreamNativeSession StreamNativeSession;
+
+typedef struct StreamNativeCApi {
+    int32_t version;
+
+    // NULL for an unknown kind.
+    StreamNativeSession* (*createMarkdownSession)(int32_t kind);
+
+    void (*destroySession)(StreamNativeSession* session);
+
+    // Pushes UTF-8 bytes; a multi-byte sequence may be split across pushes.
+    // Sets `text` to the UTF-16 units the bytes decoded to and `segments` to
+    // (type, start, end) triples, offsets in UTF-16 units of the whole
+    // stream. Both stay valid until the next call on the session. Returns
+    // the number of segments, or -1 on bad arguments.
+    int32_t (*pushUtf8)(StreamNativeSession* session, const uint8_t* bytes, int32_t len, const uint16_t** text,
+                        int32_t* textLen, const int32_t** segments);
+
+    // Ends the input: each byte of a sequence the last push cut off decodes
+    // to U+FFFD and is pushed; without it those bytes are never reported.
+    // Outputs and return value as for pushUtf8 (no text if nothing was
+    // pending). Since version 2.
+    int32_t (*flushUtf8)(StreamNativeSession* session, const uint16_t** text, int32_t* textLen,
+                         const int32_t** segments);
+} StreamNativeCApi;
+
+// The table for `version`, or NULL if this library cannot serve it. Later
+// versions only append members, so one table serves every version up to
+// STREAMNATIVE_C_API_VERSION.
+const StreamNativeCApi* streamnative_get_c_api(int32_t version);
+
+typedef const StreamNativeCApi* (*StreamNativeGetCApiFn)(int32_t version);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,47 +1,29 @@
 #include "StreamOperators.h"
 
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>
 #include <cstdint>
-#include <deque>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
 
+#include "MarkdownTypes.h"
+#include "plugins/StreamJsonPlugin.h"
 #include "plugins/StreamPlanExecutionPlugin.h"
 #include "plugins/StreamMarkdownPlugin.h"
 #include "plugins/StreamXmlPlugin.h"
+#include "StreamKmpGraph.h"
+#include "StreamSnapshot.h"
+#include "StringExtensions.h"
 
 namespace streamnative {
 
 namespace {
 
-// Must match com.ai.assistance.operit.util.markdown.MarkdownProcessorType ordinals.
-constexpr int MD_HEADER = 0;
-constexpr int MD_BLOCK_QUOTE = 1;
-constexpr int MD_CODE_BLOCK = 2;
-constexpr int MD_ORDERED_LIST = 3;
-constexpr int MD_UNORDERED_LIST = 4;
-constexpr int MD_HORIZONTAL_RULE = 5;
-constexpr int MD_BLOCK_LATEX = 6;
-constexpr int MD_TABLE = 7;
-constexpr int MD_XML_BLOCK = 8;
-constexpr int MD_PLAN_EXECUTION = 9;
-constexpr int MD_BOLD = 10;
-constexpr int MD_ITALIC = 11;
-constexpr int MD_INLINE_CODE = 12;
-constexpr int MD_LINK = 13;
-constexpr int MD_IMAGE = 14;
-constexpr int MD_STRIKETHROUGH = 15;
-constexpr int MD_UNDERLINE = 16;
-constexpr int MD_INLINE_LATEX = 17;
-constexpr int MD_PLAIN_TEXT = 18;
-
-// Segment type used only as a boundary marker between groups.
-// Kotlin side must treat this as "close current group" and not map it to MarkdownProcessorType.
-constexpr int SEG_BREAK = -1;
-
-struct PluginEntry {
-    std::unique_ptr<StreamPlugin> plugin;
-    int tag;
-};
-
 inline void emitIndex(std::vector<Segment>& out, int tag, int index, int& runTag, int& runStart, int& runEnd) {
     if (runStart >= 0 && (runTag != tag || runEnd != index)) {
         out.push_back({runTag, runStart, runEnd});
@@ -57,6 +39,22 @@ inline void emitIndex(std::vector<Segment>& out, int tag, int index, int& runTag
     }
 }
 
+inline void emitRange(std::vector<Segment>& out, int tag, int start, int end, int& runTag, int& runStart, int& runEnd) {
+    if (start >= end) {
+        return;
+    }
+    if (runStart >= 0 && (runTag != tag || runEnd != start)) {
+        out.push_back({runTag, runStart, runEnd});
+        runStart = -1;
+        runEnd = -1;
+    }
+    if (runStart < 0) {
+        runTag = tag;
+        runStart = start;
+    }
+    runEnd = end;
+}
+
 inline void flushRun(std::vector<Segment>& out, int& runTag, int& runStart, int& runEnd) {
     if (runStart >= 0) {
         out.push_back({runTag, runStart, runEnd});
@@ -70,21 +68,235 @@ inline void emitBreak(std::vector<Segment>& out, int pos, int& runTag, int& runS
     out.push_back({SEG_BREAK, pos, pos});
 }
 
-} // namespace
+#if STREAMNATIVE_VIRTUAL_BASELINE
+// Forwards every call through StreamPlugin's vtable. Running a plugin set
+// through PluginPipeline<VirtualPlugin...> gives the dynamically dispatched
+// baseline the benchmark compares against.
+class VirtualPlugin {
+public:
+    explicit VirtualPlugin(std::unique_ptr<StreamPlugin> plugin) : plugin_(std::move(plugin)) {}
+
+    PluginState state() const { return plugin_->state(); }
+    bool processChar(char16_t c, bool atStartOfLine) { return plugin_->processChar(c, atStartOfLine); }
+    bool initPlugin() { return plugin_->initPlugin(); }
+    void reset() { plugin_->reset(); }
+    void saveState(SnapshotWriter& out) const { plugin_->saveState(out); }
+    bool restoreState(SnapshotReader& in) { return plugin_->restoreState(in); }
+    int maxLookahead() const { return plugin_->maxLookahead(); }
+    bool appendDelimiters(std::vector<std::u16string>& out) const { return plugin_->appendDelimiters(out); }
+    void skipInertRun(const char16_t* chars, int len) { plugin_->skipInertRun(chars, len); }
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+        return plugin_->consumeUntilCandidate(chars, len, atStartOfLine, shouldEmit);
+    }
 
-class MarkdownSession {
+private:
+    std::unique_ptr<StreamPlugin> plugin_;
+};
+#endif
+
+// The plugin-set specific half of a session: evaluation buffer, WAITFOR and
+// the bulk paths. One virtual call per push; everything per character is
+// resolved at compile time by PluginPipeline.
+class SegmentPipeline {
 public:
-    explicit MarkdownSession(std::vector<PluginEntry> plugins)
-            : plugins_(std::move(plugins)) {
-        for (auto& e : plugins_) {
-            e.plugin->initPlugin();
+    virtual ~SegmentPipeline() = default;
+
+    // Appends the segments for `chars` to `out`; runs are only merged within
+    // this call, so earlier contents of `out` are left untouched.
+    virtual void push(const char16_t* chars, int len, std::vector<Segment>& out) = 0;
+
+    // Back to the state of a freshly created pipeline.
+    virtual void reset() = 0;
+
+    // Lowest global index that has not been emitted (or dropped) yet.
+    virtual int firstUnresolvedIndex() const = 0;
+
+    // Caps attempts of plugins with line lookahead at `chars` characters
+    // (INT32_MAX / 4 for no cap); set before the first push.
+    virtual void setAttemptLimit(int chars) { (void)chars; }
+
+    // Characters pushed since creation or the last reset.
+    virtual int pushedLength() const = 0;
+
+    // Checkpoint of the pipeline and its plugins, taken between pushes (so no
+    // character is waiting to be reprocessed). restoreState only accepts
+    // the state of a pipeline over the same plugin set and returns false on
+    // malformed input, leaving the pipeline to be reset.
+    virtual void saveState(SnapshotWriter& out) const = 0;
+    virtual bool restoreState(SnapshotReader& in) = 0;
+
+#if STREAMNATIVE_STATS
+    // Appends the counters of each plugin, in evaluation order.
+    virtual void appendStats(std::vector<PluginStats>& out) const { (void)out; }
+#endif
+};
+
+// Session loop over a std::tuple of concrete plugin types. Plugins are
+// evaluated in tuple order (which decides ties) and called without virtual
+// dispatch; `tags` gives the segment type of each.
+template <typename PluginTuple>
+class PluginPipeline;
+
+template <typename... Plugins>
+class PluginPipeline<std::tuple<Plugins...>> final : public SegmentPipeline {
+    static constexpr size_t kPluginCount = sizeof...(Plugins);
+    static_assert(kPluginCount > 0, "a pipeline needs at least one plugin");
+
+    // Which plugins asked to emit a buffered character, one bit per plugin.
+    using EmitMask = std::bitset<kPluginCount>;
+    static_assert(kPluginCount < 32, "checkpoints store emit masks as 32-bit words");
+
+public:
+    using Tags = std::array<int, kPluginCount>;
+
+    explicit PluginPipeline(const Tags& tags, Plugins... plugins)
+            : plugins_(std::move(plugins)...), tags_(tags) {
+        int declared = 1;
+        std::vector<std::u16string> patterns;
+        forEachPlugin([&](auto& plugin, size_t pi) {
+            plugin.initPlugin();
+            patterns.clear();
+            if (plugin.appendDelimiters(patterns)) {
+                for (const auto& pattern : patterns) {
+                    delimiters_.addPattern(pattern, pi);
+                }
+            } else {
+                delimiters_.addWildcardOwner(pi);
+            }
+            declared_[pi] = std::max(plugin.maxLookahead(), 1);
+            declared = std::max(declared, std::min(declared_[pi], kLineLookahead));
+        });
+        delimiters_.build();
+        setAttemptLimit(DEFAULT_ATTEMPT_LIMIT);
+#if STREAMNATIVE_STATS
+        for (size_t pi = 0; pi < kPluginCount; pi++) {
+            stats_[pi].tag = tags_[pi];
         }
+#endif
+        // Overlapping attempts of different plugins can outgrow this; the
+        // buffer then grows once and keeps its capacity.
+        evaluationEmitMask_.reserve(static_cast<size_t>(declared));
+        attemptStart_.fill(0);
     }
 
-    std::vector<Segment> push(const jchar* chars, int len) {
-        std::vector<Segment> out;
-        out.reserve(64);
+    void setAttemptLimit(int chars) override {
+        int lookahead = 1;
+        for (size_t pi = 0; pi < kPluginCount; pi++) {
+            lookahead_[pi] = declared_[pi] < kLineLookahead ? declared_[pi] : chars;
+            lookahead = std::max(lookahead, lookahead_[pi]);
+        }
+        // Attempts of different plugins can overlap and keep the buffer
+        // open past any single lookahead; this bounds it as a whole.
+        bufferLimit_ = 2 * lookahead;
+    }
+
+    void reset() override {
+        forEachPlugin([](auto& plugin, size_t) { plugin.initPlugin(); });
+        globalOffset_ = 0;
+        atStartOfLine_ = true;
+        activeTag_ = MD_PLAIN_TEXT;
+        activeIndex_ = -1;
+        evalStartGlobal_ = -1;
+        evaluationEmitMask_.clear();
+        delimiterState_ = Delimiters::kRoot;
+        waitforActive_ = false;
+        waitforAtStartOfLine_ = false;
+        hasPendingChar_ = false;
+        idleClean_ = true;
+        attemptStart_.fill(0);
+    }
+
+    int firstUnresolvedIndex() const override {
+        int first = globalOffset_;
+        if (evalStartGlobal_ >= 0 && evalStartGlobal_ < first) {
+            first = evalStartGlobal_;
+        }
+        if (waitforActive_ && waitforPending_.globalIndex < first) {
+            first = waitforPending_.globalIndex;
+        }
+        return first;
+    }
+
+    int pushedLength() const override { return globalOffset_; }
+
+    void saveState(SnapshotWriter& out) const override {
+        // The plugin set's signature, checked on restore.
+        out.writeUInt(static_cast<uint32_t>(kPluginCount));
+        for (int tag : tags_) {
+            out.writeInt(tag);
+        }
+
+        out.writeInt(globalOffset_);
+        out.writeBool(atStartOfLine_);
+        out.writeInt(activeIndex_);
+        out.writeInt(evalStartGlobal_);
+        out.writeUInt(static_cast<uint32_t>(evaluationEmitMask_.size()));
+        for (const EmitMask& mask : evaluationEmitMask_) {
+            out.writeUInt(static_cast<uint32_t>(mask.to_ulong()));
+        }
+        out.writeInt(delimiterState_);
+        out.writeBool(waitforActive_);
+        out.writeBool(waitforAtStartOfLine_);
+        out.writeInt(waitforPending_.globalIndex);
+        out.writeBool(waitforPending_.shouldEmit);
+        out.writeBool(idleClean_);
+        for (int start : attemptStart_) {
+            out.writeInt(start);
+        }
+
+        std::apply([&](const auto&... plugin) { (plugin.saveState(out), ...); }, plugins_);
+    }
+
+    bool restoreState(SnapshotReader& in) override {
+        if (in.readUInt() != kPluginCount) {
+            return false;
+        }
+        for (int tag : tags_) {
+            if (in.readInt() != tag) {
+                return false;
+            }
+        }
 
+        // Buffered positions must lie in what was pushed; the nested session
+        // maps them back into its history.
+        globalOffset_ = in.readInt(0, INT32_MAX);
+        atStartOfLine_ = in.readBool();
+        activeIndex_ = in.readInt(-1, static_cast<int>(kPluginCount) - 1);
+        activeTag_ = activeIndex_ >= 0 ? tags_[static_cast<size_t>(activeIndex_)] : MD_PLAIN_TEXT;
+        evalStartGlobal_ = in.readInt(-1, globalOffset_);
+        evaluationEmitMask_.clear();
+        const uint32_t buffered = in.readUInt();
+        if (buffered > static_cast<uint32_t>(globalOffset_ - std::max(evalStartGlobal_, 0)) ||
+            (evalStartGlobal_ < 0 && buffered != 0)) {
+            return false;
+        }
+        for (uint32_t k = 0; k < buffered && in.ok(); k++) {
+            const uint32_t bits = in.readUInt();
+            if ((bits >> kPluginCount) != 0) {
+                in.fail();
+            }
+            evaluationEmitMask_.emplace_back(bits);
+        }
+        delimiterState_ = in.readInt(0, delimiters_.stateCount() - 1);
+        waitforActive_ = in.readBool();
+        waitforAtStartOfLine_ = in.readBool();
+        waitforPending_.globalIndex = in.readInt(0, std::max(globalOffset_ - 1, 0));
+        waitforPending_.shouldEmit = in.readBool();
+        idleClean_ = in.readBool();
+        for (int& start : attemptStart_) {
+            start = in.readInt(0, static_cast<int>(buffered));
+        }
+
+        return in.ok() && std::apply([&](auto&... plugin) { return (plugin.restoreState(in) && ...); }, plugins_);
+    }
+
+#if STREAMNATIVE_STATS
+    void appendStats(std::vector<PluginStats>& out) const override {
+        out.insert(out.end(), stats_.begin(), stats_.end());
+    }
+#endif
+
+    void push(const char16_t* chars, int len, std::vector<Segment>& out) override {
         int runTag = 0;
         int runStart = -1;
         int runEnd = -1;
@@ -94,20 +306,33 @@ public:
             if (forcedGlobalIndex < 0) {
                 globalOffset_ += 1;
             }
+            idleClean_ = false;
 
             // WAITFOR handling deferred across pushes
             if (waitforActive_) {
                 // Feed next char into active plugin to decide.
-                const bool nextShouldEmit = activePlugin_->processChar(c, waitforAtStartOfLine_);
-
-                if (activePlugin_->state() == PluginState::PROCESSING) {
-                    // Confirmed: emit pending char(s) and current char.
-                    for (const auto& pending : waitforPending_) {
-                        if (pending.shouldEmit) {
-                            emitIndex(out, activeTag_, pending.globalIndex, runTag, runStart, runEnd);
-                        }
+                bool nextShouldEmit = false;
+                PluginState nextState = PluginState::IDLE;
+                withActivePlugin([&](auto& plugin) {
+                    nextShouldEmit = plugin.processChar(c, waitforAtStartOfLine_);
+                    nextState = plugin.state();
+                });
+#if STREAMNATIVE_STATS
+                PluginStats& stats = stats_[static_cast<size_t>(activeIndex_)];
+                stats.charsEvaluated++;
+                if (nextState == PluginState::PROCESSING) {
+                    stats.waitforConfirmed++;
+                } else {
+                    stats.waitforRejected++;
+                    pendingOwner_ = activeIndex_;
+                }
+#endif
+
+                if (nextState == PluginState::PROCESSING) {
+                    // Confirmed: emit pending char and current char.
+                    if (waitforPending_.shouldEmit) {
+                        emitIndex(out, activeTag_, waitforPending_.globalIndex, runTag, runStart, runEnd);
                     }
-                    waitforPending_.clear();
                     waitforActive_ = false;
                     if (nextShouldEmit) {
                         emitIndex(out, activeTag_, globalIndex, runTag, runStart, runEnd);
@@ -117,46 +342,49 @@ public:
                 }
 
                 // Rejected: return only previously-emitted chars as plain, current char must be reprocessed as idle.
-                for (const auto& pending : waitforPending_) {
-                    if (pending.shouldEmit) {
-                        emitIndex(out, MD_PLAIN_TEXT, pending.globalIndex, runTag, runStart, runEnd);
-                    }
+                if (waitforPending_.shouldEmit) {
+                    emitIndex(out, MD_PLAIN_TEXT, waitforPending_.globalIndex, runTag, runStart, runEnd);
                 }
-                waitforPending_.clear();
                 waitforActive_ = false;
 
                 // Close plugin
                 emitBreak(out, globalIndex, runTag, runStart, runEnd);
-                activePlugin_ = nullptr;
                 activeTag_ = MD_PLAIN_TEXT;
                 activeIndex_ = -1;
 
                 // Reset all plugins after a failed waitfor
-                for (auto& e : plugins_) {
-                    e.plugin->reset();
-                }
+                forEachPlugin([](auto& plugin, size_t) { plugin.reset(); });
 
                 // Reprocess current char as idle (do NOT advance global offset again)
-                pendingChars_.push_front({c, globalIndex});
+                pendingChar_ = {c, globalIndex};
+                hasPendingChar_ = true;
                 return;
             }
 
-            if (activePlugin_ != nullptr) {
-                const bool shouldEmit = activePlugin_->processChar(c, atStartOfLine);
-                if (activePlugin_->state() == PluginState::WAITFOR) {
-                    // Defer emission decision until next char arrives.
+            if (activeIndex_ >= 0) {
+                bool shouldEmit = false;
+                PluginState state = PluginState::IDLE;
+                withActivePlugin([&](auto& plugin) {
+                    shouldEmit = plugin.processChar(c, atStartOfLine);
+                    state = plugin.state();
+                });
+#if STREAMNATIVE_STATS
+                stats_[static_cast<size_t>(activeIndex_)].charsEvaluated++;
+#endif
+                if (state == PluginState::WAITFOR) {
+                    // Defer emission decision until next char arrives; it
+                    // always settles the WAITFOR, so one pending char is enough.
                     waitforActive_ = true;
                     waitforAtStartOfLine_ = (c == u'\n');
-                    waitforPending_.push_back({globalIndex, shouldEmit});
+                    waitforPending_ = {globalIndex, shouldEmit};
                     return;
                 }
                 if (shouldEmit) {
                     emitIndex(out, activeTag_, globalIndex, runTag, runStart, runEnd);
                 }
-                if (activePlugin_->state() != PluginState::PROCESSING) {
+                if (state != PluginState::PROCESSING) {
                     // Close active group
                     emitBreak(out, globalIndex + 1, runTag, runStart, runEnd);
-                    activePlugin_ = nullptr;
                     activeTag_ = MD_PLAIN_TEXT;
                     activeIndex_ = -1;
                 }
@@ -166,93 +394,153 @@ public:
             // Evaluation mode
             if (evalStartGlobal_ < 0) {
                 evalStartGlobal_ = globalIndex;
+                delimiterState_ = Delimiters::kRoot;
             }
 
-            evaluationBuffer_.push_back(c);
-            uint32_t emitMask = 0;
+            // One automaton step decides which idle plugins can react at all;
+            // the others see the character as inert text.
+            delimiterState_ = delimiters_.advance(delimiterState_, c);
+            const typename Delimiters::Owners& live = delimiters_.live(delimiterState_);
+            const bool notifyAll = atStartOfLine || c == u'\n';
+
+            EmitMask emitMask;
 
+            // A plugin's state only changes in its own processChar, so the
+            // first PROCESSING plugin can be picked in the same pass.
             int successful = -1;
-            for (int pi = 0; pi < static_cast<int>(plugins_.size()); pi++) {
-                const bool se = plugins_[pi].plugin->processChar(c, atStartOfLine);
-                if (se) {
-                    emitMask |= (1u << static_cast<uint32_t>(pi));
+            bool anyTrying = false;
+            forEachPlugin([&](auto& plugin, size_t pi) {
+                if (!notifyAll && !live.test(pi) && plugin.state() == PluginState::IDLE) {
+                    plugin.skipInertRun(&c, 1);
+                    emitMask.set(pi);
+                    return;
                 }
-            }
-            evaluationEmitMask_.push_back(emitMask);
-
-            for (int pi = 0; pi < static_cast<int>(plugins_.size()); pi++) {
-                if (plugins_[pi].plugin->state() == PluginState::PROCESSING) {
-                    successful = pi;
-                    break;
+#if STREAMNATIVE_STATS
+                const PluginState before = plugin.state();
+#endif
+                const bool wasTrying = plugin.state() == PluginState::TRYING;
+                if (plugin.processChar(c, atStartOfLine)) {
+                    emitMask.set(pi);
                 }
-            }
+                PluginState state = plugin.state();
+#if STREAMNATIVE_STATS
+                countEvaluation(pi, before, state, evaluationEmitMask_.size() + 1);
+#endif
+                if (state == PluginState::TRYING) {
+                    // Past its lookahead the attempt is given up on rather
+                    // than kept buffering.
+                    const int at = static_cast<int>(evaluationEmitMask_.size());
+                    if (!wasTrying) {
+                        attemptStart_[pi] = at;
+                    }
+                    if (at - attemptStart_[pi] + 1 >= lookahead_[pi]) {
+                        plugin.reset();
+                        state = plugin.state();
+#if STREAMNATIVE_STATS
+                        stats_[pi].lookaheadAbandons++;
+#endif
+                    }
+                }
+                if (state == PluginState::PROCESSING) {
+                    if (successful < 0) {
+                        successful = static_cast<int>(pi);
+                    }
+                } else if (state == PluginState::TRYING) {
+                    anyTrying = true;
+                }
+            });
+            evaluationEmitMask_.push_back(emitMask);
 
             if (successful != -1) {
                 // Flush buffered as plugin group
                 activeIndex_ = successful;
-                activePlugin_ = plugins_[successful].plugin.get();
-                activeTag_ = plugins_[successful].tag;
+                activeTag_ = tags_[static_cast<size_t>(successful)];
 
                 // Ensure a new group boundary even if previous group had the same tag.
                 flushRun(out, runTag, runStart, runEnd);
 
-                for (int bi = 0; bi < static_cast<int>(evaluationBuffer_.size()); bi++) {
-                    const uint32_t mask = evaluationEmitMask_[static_cast<size_t>(bi)];
-                    if ((mask & (1u << static_cast<uint32_t>(successful))) != 0u) {
+                for (int bi = 0; bi < static_cast<int>(evaluationEmitMask_.size()); bi++) {
+                    if (evaluationEmitMask_[static_cast<size_t>(bi)].test(static_cast<size_t>(successful))) {
                         emitIndex(out, activeTag_, evalStartGlobal_ + bi, runTag, runStart, runEnd);
                     }
                 }
 
-                evaluationBuffer_.clear();
                 evaluationEmitMask_.clear();
                 evalStartGlobal_ = -1;
 
                 // Reset other plugins
-                for (int pi = 0; pi < static_cast<int>(plugins_.size()); pi++) {
-                    if (pi != successful) {
-                        plugins_[pi].plugin->reset();
+                forEachPlugin([&](auto& plugin, size_t pi) {
+                    if (static_cast<int>(pi) != successful) {
+                        plugin.reset();
                     }
-                }
+                });
 
                 return;
             }
 
             // If no plugin is trying, flush buffer as plain text
-            bool anyTrying = false;
-            for (auto& e : plugins_) {
-                if (e.plugin->state() == PluginState::TRYING) {
-                    anyTrying = true;
-                    break;
-                }
-            }
-
-            if (!anyTrying) {
-                for (int bi = 0; bi < static_cast<int>(evaluationBuffer_.size()); bi++) {
-                    emitIndex(out, MD_PLAIN_TEXT, evalStartGlobal_ + bi, runTag, runStart, runEnd);
-                }
-                evaluationBuffer_.clear();
+            if (!anyTrying || evaluationEmitMask_.size() >= static_cast<size_t>(bufferLimit_)) {
+                emitRange(out, MD_PLAIN_TEXT, evalStartGlobal_,
+                          evalStartGlobal_ + static_cast<int>(evaluationEmitMask_.size()), runTag, runStart, runEnd);
                 evaluationEmitMask_.clear();
                 evalStartGlobal_ = -1;
-                for (auto& e : plugins_) {
-                    e.plugin->reset();
-                }
+                forEachPlugin([](auto& plugin, size_t) { plugin.reset(); });
+                idleClean_ = true;
             }
         };
 
         bool atStartOfLine = atStartOfLine_;
 
         int i = 0;
-        while (i < len || !pendingChars_.empty()) {
+        while (i < len || hasPendingChar_) {
+            if (idleClean_ && !atStartOfLine && !hasPendingChar_) {
+                // Every plugin is idle: emit the run no plugin reacts to in one go.
+                int runLimit = i;
+                while (runLimit < len && chars[runLimit] != u'\n' && !delimiters_.startsPattern(chars[runLimit])) {
+                    runLimit++;
+                }
+                if (runLimit > i) {
+                    forEachPlugin([&](auto& plugin, size_t) { plugin.skipInertRun(chars + i, runLimit - i); });
+                    emitRange(out, MD_PLAIN_TEXT, globalOffset_, globalOffset_ + (runLimit - i), runTag, runStart, runEnd);
+                    globalOffset_ += runLimit - i;
+                    i = runLimit;
+                    continue;
+                }
+            }
+
+            if (activeIndex_ >= 0 && !waitforActive_ && !hasPendingChar_) {
+                // The active block cannot close inside this run: emit it in one go.
+                bool shouldEmit = true;
+                int consumed = 0;
+                withActivePlugin([&](auto& plugin) {
+                    consumed = plugin.consumeUntilCandidate(chars + i, len - i, atStartOfLine, shouldEmit);
+                });
+                if (consumed > 0) {
+#if STREAMNATIVE_STATS
+                    stats_[static_cast<size_t>(activeIndex_)].charsConsumedInBulk += static_cast<uint64_t>(consumed);
+#endif
+                    if (shouldEmit) {
+                        emitRange(out, activeTag_, globalOffset_, globalOffset_ + consumed, runTag, runStart, runEnd);
+                    }
+                    globalOffset_ += consumed;
+                    i += consumed;
+                    atStartOfLine = (chars[i - 1] == u'\n');
+                    continue;
+                }
+            }
+
             char16_t c;
             int forcedIndex = -1;
 
-            if (!pendingChars_.empty()) {
-                PendingChar pc = pendingChars_.front();
-                pendingChars_.pop_front();
-                c = pc.c;
-                forcedIndex = pc.globalIndex;
+            if (hasPendingChar_) {
+                hasPendingChar_ = false;
+#if STREAMNATIVE_STATS
+                stats_[static_cast<size_t>(pendingOwner_)].pendingReplays++;
+#endif
+                c = pendingChar_.c;
+                forcedIndex = pendingChar_.globalIndex;
             } else {
-                c = static_cast<char16_t>(chars[i]);
+                c = chars[i];
                 i += 1;
             }
 
@@ -264,8 +552,6 @@ public:
         atStartOfLine_ = atStartOfLine;
 
         flushRun(out, runTag, runStart, runEnd);
-
-        return out;
     }
 
 private:
@@ -279,142 +565,1313 @@ private:
         int globalIndex;
     };
 
-    std::vector<PluginEntry> plugins_;
+    // Calls f(plugin, index) for every plugin, unrolled in tuple order.
+    template <typename F>
+    void forEachPlugin(F&& f) {
+        forEachPluginImpl(f, std::index_sequence_for<Plugins...>{});
+    }
+
+    template <typename F, size_t... I>
+    void forEachPluginImpl(F& f, std::index_sequence<I...>) {
+        (f(std::get<I>(plugins_), I), ...);
+    }
+
+    // Calls f(plugin) on the active plugin with its concrete type.
+    template <typename F>
+    void withActivePlugin(F&& f) {
+        withActivePluginImpl(f, std::index_sequence_for<Plugins...>{});
+    }
+
+    template <typename F, size_t... I>
+    void withActivePluginImpl(F& f, std::index_sequence<I...>) {
+        (void)((activeIndex_ == static_cast<int>(I) && (f(std::get<I>(plugins_)), true)) || ...);
+    }
+
+#if STREAMNATIVE_STATS
+    // One evaluation-mode processChar of plugin `pi`, with `buffered`
+    // characters in the evaluation buffer including this one.
+    void countEvaluation(size_t pi, PluginState before, PluginState after, size_t buffered) {
+        PluginStats& stats = stats_[pi];
+        stats.charsEvaluated++;
+        if (before == PluginState::IDLE && after == PluginState::TRYING) {
+            stats.tryingEntries++;
+        }
+        if (before == PluginState::TRYING && after != PluginState::TRYING) {
+            if (after == PluginState::IDLE) {
+                stats.tryingRejections++;
+            }
+            stats.longestEvaluation = std::max<uint64_t>(stats.longestEvaluation, buffered);
+        }
+    }
+#endif
+
+    using Delimiters = MultiPatternMatcher<kPluginCount>;
+
+    std::tuple<Plugins...> plugins_;
+    Tags tags_;
+
+    // Opening delimiters of all plugins; the state only advances in
+    // evaluation mode and restarts at the root with every attempt.
+    Delimiters delimiters_;
+    int delimiterState_ = Delimiters::kRoot;
 
     int globalOffset_ = 0;
     bool atStartOfLine_ = true;
 
     // Active plugin
-    StreamPlugin* activePlugin_ = nullptr;
     int activeTag_ = MD_PLAIN_TEXT;
     int activeIndex_ = -1;
 
-    // Evaluation buffer
+    // Evaluation buffer: one emit mask per character since evalStartGlobal_.
+    // Only ever cleared as a whole, so it keeps its capacity across attempts.
     int evalStartGlobal_ = -1;
-    std::vector<char16_t> evaluationBuffer_;
-    std::vector<uint32_t> evaluationEmitMask_;
+    std::vector<EmitMask> evaluationEmitMask_;
 
     // WAITFOR support
     bool waitforActive_ = false;
     bool waitforAtStartOfLine_ = false;
-    std::vector<WaitforPending> waitforPending_;
-    std::deque<PendingChar> pendingChars_;
+    WaitforPending waitforPending_{};
+
+    // Character to reprocess as idle after a rejected WAITFOR.
+    bool hasPendingChar_ = false;
+    PendingChar pendingChar_{};
+
+    // True while every plugin is IDLE and reset with nothing buffered.
+    bool idleClean_ = true;
+
+    // Bounded lookahead: each plugin's declared maxLookahead(), the length
+    // its attempts are abandoned at (the declared one, or the session's
+    // attempt limit for line lookahead), the buffer index its current attempt
+    // started at, and the cap on the buffer.
+    std::array<int, kPluginCount> declared_{};
+    std::array<int, kPluginCount> lookahead_{};
+    std::array<int, kPluginCount> attemptStart_{};
+    int bufferLimit_ = 2;
+
+#if STREAMNATIVE_STATS
+    std::array<PluginStats, kPluginCount> stats_{};
+    int pendingOwner_ = 0; // plugin whose rejected WAITFOR left pendingChar_
+#endif
+};
+
+// Order must match NestedMarkdownProcessor.getBlockPlugins()
+using BlockPlugins = std::tuple<
+        StreamPlanExecutionPlugin,
+        StreamMarkdownHeaderPlugin,
+        StreamMarkdownFencedCodeBlockPlugin,
+        StreamMarkdownBlockQuotePlugin,
+        StreamMarkdownOrderedListPlugin,
+        StreamMarkdownUnorderedListPlugin,
+        StreamMarkdownHorizontalRulePlugin,
+        StreamMarkdownBlockLaTeXPlugin,
+        StreamMarkdownBlockBracketLaTeXPlugin,
+        StreamMarkdownTablePlugin,
+        StreamMarkdownImagePlugin,
+        StreamXmlPlugin>;
+using BlockPipeline = PluginPipeline<BlockPlugins>;
+
+constexpr BlockPipeline::Tags kBlockTags = {
+        MD_PLAN_EXECUTION, MD_HEADER, MD_CODE_BLOCK, MD_BLOCK_QUOTE,
+        MD_ORDERED_LIST, MD_UNORDERED_LIST, MD_HORIZONTAL_RULE, MD_BLOCK_LATEX,
+        MD_BLOCK_LATEX, MD_TABLE, MD_IMAGE, MD_XML_BLOCK,
+};
+
+// Order must match NestedMarkdownProcessor.getInlinePlugins()
+using InlinePlugins = std::tuple<
+        StreamMarkdownBoldPlugin,
+        StreamMarkdownItalicPlugin,
+        StreamMarkdownInlineCodePlugin,
+        StreamMarkdownLinkPlugin,
+        StreamMarkdownStrikethroughPlugin,
+        StreamMarkdownUnderlinePlugin,
+        StreamMarkdownInlineLaTeXPlugin,
+        StreamMarkdownInlineParenLaTeXPlugin>;
+using InlinePipeline = PluginPipeline<InlinePlugins>;
+
+// The two production sets are compiled here in full.
+template class PluginPipeline<BlockPlugins>;
+template class PluginPipeline<InlinePlugins>;
+
+constexpr InlinePipeline::Tags kInlineTags = {
+        MD_BOLD, MD_ITALIC, MD_INLINE_CODE, MD_LINK,
+        MD_STRIKETHROUGH, MD_UNDERLINE, MD_INLINE_LATEX, MD_INLINE_LATEX,
+};
+
+std::unique_ptr<SegmentPipeline> makeBlockPipeline() {
+    return std::make_unique<BlockPipeline>(
+            kBlockTags,
+            StreamPlanExecutionPlugin(true),
+            StreamMarkdownHeaderPlugin(true),
+            StreamMarkdownFencedCodeBlockPlugin(true),
+            StreamMarkdownBlockQuotePlugin(false),
+            StreamMarkdownOrderedListPlugin(true),
+            StreamMarkdownUnorderedListPlugin(false),
+            StreamMarkdownHorizontalRulePlugin(true),
+            StreamMarkdownBlockLaTeXPlugin(false),
+            StreamMarkdownBlockBracketLaTeXPlugin(false),
+            StreamMarkdownTablePlugin(true),
+            StreamMarkdownImagePlugin(true),
+            StreamXmlPlugin(true));
+}
+
+std::unique_ptr<SegmentPipeline> makeInlinePipeline() {
+    return std::make_unique<InlinePipeline>(
+            kInlineTags,
+            StreamMarkdownBoldPlugin(false),
+            StreamMarkdownItalicPlugin(false),
+            StreamMarkdownInlineCodePlugin(false),
+            StreamMarkdownLinkPlugin(),
+            StreamMarkdownStrikethroughPlugin(false),
+            StreamMarkdownUnderlinePlugin(true),
+            StreamMarkdownInlineLaTeXPlugin(false),
+            StreamMarkdownInlineParenLaTeXPlugin(false));
+}
+
+#if STREAMNATIVE_VIRTUAL_BASELINE
+template <typename T, size_t>
+using Repeat = T;
+
+template <size_t... I>
+std::unique_ptr<SegmentPipeline> makeVirtualPipeline(const std::array<int, sizeof...(I)>& tags,
+                                                     std::array<std::unique_ptr<StreamPlugin>, sizeof...(I)> plugins,
+                                                     std::index_sequence<I...>) {
+    return std::make_unique<PluginPipeline<std::tuple<Repeat<VirtualPlugin, I>...>>>(
+            tags, VirtualPlugin(std::move(plugins[I]))...);
+}
+
+std::unique_ptr<SegmentPipeline> makeVirtualBlockPipeline() {
+    return makeVirtualPipeline(
+            kBlockTags,
+            {std::make_unique<StreamPlanExecutionPlugin>(true),
+             std::make_unique<StreamMarkdownHeaderPlugin>(true),
+             std::make_unique<StreamMarkdownFencedCodeBlockPlugin>(true),
+             std::make_unique<StreamMarkdownBlockQuotePlugin>(false),
+             std::make_unique<StreamMarkdownOrderedListPlugin>(true),
+             std::make_unique<StreamMarkdownUnorderedListPlugin>(false),
+             std::make_unique<StreamMarkdownHorizontalRulePlugin>(true),
+             std::make_unique<StreamMarkdownBlockLaTeXPlugin>(false),
+             std::make_unique<StreamMarkdownBlockBracketLaTeXPlugin>(false),
+             std::make_unique<StreamMarkdownTablePlugin>(true),
+             std::make_unique<StreamMarkdownImagePlugin>(true),
+             std::make_unique<StreamXmlPlugin>(true)},
+            std::make_index_sequence<kBlockTags.size()>{});
+}
+
+std::unique_ptr<SegmentPipeline> makeVirtualInlinePipeline() {
+    return makeVirtualPipeline(
+            kInlineTags,
+            {std::make_unique<StreamMarkdownBoldPlugin>(false),
+             std::make_unique<StreamMarkdownItalicPlugin>(false),
+             std::make_unique<StreamMarkdownInlineCodePlugin>(false),
+             std::make_unique<StreamMarkdownLinkPlugin>(),
+             std::make_unique<StreamMarkdownStrikethroughPlugin>(false),
+             std::make_unique<StreamMarkdownUnderlinePlugin>(true),
+             std::make_unique<StreamMarkdownInlineLaTeXPlugin>(false),
+             std::make_unique<StreamMarkdownInlineParenLaTeXPlugin>(false)},
+            std::make_index_sequence<kInlineTags.size()>{});
+}
+#endif
+
+// Text around JSON values plus the structure StreamJsonPlugin reports inside
+// them. The plugin commits on the opening character, so nothing is ever held
+// back for evaluation: text runs go out at the end of each push, keys and
+// values as soon as they are finished.
+class JsonPipeline final : public SegmentPipeline {
+public:
+    void push(const char16_t* chars, int len, std::vector<Segment>& out) override {
+        int runTag = JSON_TEXT;
+        int runStart = -1;
+        int runEnd = -1;
+
+        int i = 0;
+        while (i < len) {
+            if (plugin_.state() == PluginState::IDLE) {
+                const int next = indexOfAnyChar(chars, i, len, u'{', u'[');
+                emitRange(out, JSON_TEXT, globalOffset_ + i, globalOffset_ + next, runTag, runStart, runEnd);
+                if (next == len) {
+                    break;
+                }
+                flushRun(out, runTag, runStart, runEnd);
+                i = next;
+                valueStart_ = globalOffset_ + i;
+            }
+
+            bool shouldEmit = true;
+            const int n = plugin_.consumeUntilCandidate(chars + i, len - i, false, shouldEmit);
+            if (n > 0) {
+                i += n;
+                continue;
+            }
+
+            plugin_.processChar(chars[i], false);
+            const int events = plugin_.lastEvents();
+            if (events != 0) {
+                emitStructure(events, globalOffset_ + i, out);
+            }
+            i++;
+        }
+        flushRun(out, runTag, runStart, runEnd);
+        globalOffset_ += len;
+    }
+
+    void reset() override {
+        plugin_.reset();
+        globalOffset_ = 0;
+        valueStart_ = 0;
+    }
+
+    int firstUnresolvedIndex() const override {
+        const int pending = plugin_.pendingTokenStart();
+        return pending >= 0 ? valueStart_ + pending : globalOffset_;
+    }
+
+    int pushedLength() const override { return globalOffset_; }
+
+    void saveState(SnapshotWriter& out) const override {
+        // Plugin pipelines start with their (non-zero) plugin count.
+        out.writeUInt(0);
+        out.writeInt(globalOffset_);
+        out.writeInt(valueStart_);
+        plugin_.saveState(out);
+    }
+
+    bool restoreState(SnapshotReader& in) override {
+        if (in.readUInt() != 0) {
+            return false;
+        }
+        globalOffset_ = in.readInt(0, INT32_MAX);
+        valueStart_ = in.readInt(0, globalOffset_);
+        if (!in.ok() || !plugin_.restoreState(in)) {
+            return false;
+        }
+        return plugin_.state() == PluginState::IDLE || valueStart_ + plugin_.position() == globalOffset_;
+    }
+
+private:
+    void emitStructure(int events, int pos, std::vector<Segment>& out) {
+        if ((events & (BaseJsonPlugin::kKey | BaseJsonPlugin::kValue)) != 0) {
+            out.push_back({(events & BaseJsonPlugin::kKey) != 0 ? JSON_KEY : JSON_VALUE,
+                           valueStart_ + plugin_.tokenStart(), valueStart_ + plugin_.tokenEnd()});
+        }
+        if ((events & BaseJsonPlugin::kObjectStart) != 0) {
+            out.push_back({JSON_OBJECT_START, pos, pos + 1});
+        } else if ((events & BaseJsonPlugin::kObjectEnd) != 0) {
+            out.push_back({JSON_OBJECT_END, pos, pos + 1});
+        } else if ((events & BaseJsonPlugin::kArrayStart) != 0) {
+            out.push_back({JSON_ARRAY_START, pos, pos + 1});
+        } else if ((events & BaseJsonPlugin::kArrayEnd) != 0) {
+            out.push_back({JSON_ARRAY_END, pos, pos + 1});
+        }
+    }
+
+    StreamJsonPlugin plugin_;
+    int globalOffset_ = 0;
+    int valueStart_ = 0;
+};
+
+} // namespace
+
+class MarkdownSession {
+public:
+    explicit MarkdownSession(std::unique_ptr<SegmentPipeline> pipeline)
+            : pipeline_(std::move(pipeline)) {}
+
+    std::vector<Segment> push(const char16_t* chars, int len) {
+        std::vector<Segment> out;
+        out.reserve(64);
+        pushInto(chars, len, out);
+        return out;
+    }
+
+    void attachRing(int32_t* ring, int capacity) {
+        ring_ = ring;
+        ringMask_ = static_cast<uint32_t>(capacity - 1);
+        ring_[RING_CAPACITY] = capacity;
+        __atomic_store_n(&ring_[RING_WRITE_INDEX], 0, __ATOMIC_RELEASE);
+        __atomic_store_n(&ring_[RING_READ_INDEX], 0, __ATOMIC_RELEASE);
+        ringBacklog_.clear();
+        ringBacklogHead_ = 0;
+    }
+
+    const std::vector<uint8_t>& pushCompact(const char16_t* chars, int len) {
+        wireScratch_.clear();
+        wireBytes_.clear();
+        if (len > 0) {
+            pushInto(chars, len, wireScratch_);
+        }
+        encodeSegmentsCompact(wireScratch_.data(), wireScratch_.size(), wireCursor_, wireBytes_);
+        return wireBytes_;
+    }
+
+    const std::vector<uint8_t>& compactBytes() const { return wireBytes_; }
+
+    // Decodes a UTF-8 chunk into decodedText(), holding back a sequence cut
+    // off at its end until the next chunk. Returns the units decoded.
+    int decodeUtf8(const uint8_t* bytes, int len) {
+        // A UTF-8 byte never yields more than one UTF-16 unit.
+        const size_t room = static_cast<size_t>(len + utf8CarryLen_);
+        if (decoded_.size() < room) {
+            decoded_.resize(room);
+        }
+        int units = 0;
+        int from = 0;
+        if (utf8CarryLen_ > 0) {
+            // Three more bytes always complete (or break) the carried sequence.
+            const int take = std::min(len, 3);
+            std::memcpy(utf8Carry_ + utf8CarryLen_, bytes, static_cast<size_t>(take));
+            const int used = utf8ToUtf16(utf8Carry_, utf8CarryLen_ + take, decoded_.data(), units);
+            if (used < utf8CarryLen_) {
+                const int rest = utf8CarryLen_ + take - used;
+                std::memmove(utf8Carry_, utf8Carry_ + used, static_cast<size_t>(rest));
+                utf8CarryLen_ = rest;
+                decodedLen_ = units;
+                return units;
+            }
+            from = used - utf8CarryLen_;
+            utf8CarryLen_ = 0;
+        }
+        int written = 0;
+        const int used = utf8ToUtf16(bytes + from, len - from, decoded_.data() + units, written);
+        utf8CarryLen_ = len - from - used;
+        std::memcpy(utf8Carry_, bytes + from + used, static_cast<size_t>(utf8CarryLen_));
+        decodedLen_ = units + written;
+        return decodedLen_;
+    }
+
+    void pushUtf8Into(const uint8_t* bytes, int len, std::vector<Segment>& out) {
+        const int units = decodeUtf8(bytes, len);
+        if (units > 0) {
+            pushInto(decoded_.data(), units, out);
+        }
+    }
+
+    // Ends UTF-8 input: each byte of a sequence the last chunk cut off
+    // becomes U+FFFD, as if a byte that cannot continue it had followed.
+    void flushUtf8Into(std::vector<Segment>& out) {
+        if (decoded_.size() < static_cast<size_t>(utf8CarryLen_)) {
+            decoded_.resize(static_cast<size_t>(utf8CarryLen_));
+        }
+        std::fill(decoded_.begin(), decoded_.begin() + utf8CarryLen_, u'\uFFFD');
+        decodedLen_ = utf8CarryLen_;
+        utf8CarryLen_ = 0;
+        if (decodedLen_ > 0) {
+            pushInto(decoded_.data(), decodedLen_, out);
+        }
+    }
+
+    int pendingLength() const {
+        int first = pipeline_->firstUnresolvedIndex();
+        if (inline_ != nullptr && inlineFed_ > 0) {
+            const int local = inline_->firstUnresolvedIndex();
+            if (local < inlineFed_) {
+                first = std::min(first, toGlobal(local));
+            }
+        }
+        return pipeline_->pushedLength() - first;
+    }
+
+#if STREAMNATIVE_STATS
+    void stats(SessionStats& out) const {
+        out.pushes = pushes_;
+        out.pushNanos = pushNanos_;
+        out.plugins.clear();
+        pipeline_->appendStats(out.plugins);
+        if (inline_ != nullptr) {
+            inline_->appendStats(out.plugins);
+        }
+    }
+#endif
+
+    const char16_t* decodedText() const { return decoded_.data(); }
+    int decodedLength() const { return decodedLen_; }
+
+    int pushToRing(const char16_t* chars, int len) {
+        pushInto(chars, len, ringBacklog_);
+        return drainRing();
+    }
+
+    int drainRing() {
+        if (ring_ == nullptr || ringBacklogHead_ == ringBacklog_.size()) {
+            return 0;
+        }
+        // Only this session writes the write index; the reader owns the read index.
+        const uint32_t write = static_cast<uint32_t>(ring_[RING_WRITE_INDEX]);
+        const uint32_t read = static_cast<uint32_t>(__atomic_load_n(&ring_[RING_READ_INDEX], __ATOMIC_ACQUIRE));
+        const uint32_t room = (ringMask_ + 1) - (write - read);
+        const size_t pending = ringBacklog_.size() - ringBacklogHead_;
+        const uint32_t count = pending < room ? static_cast<uint32_t>(pending) : room;
+
+        int32_t* triples = ring_ + RING_HEADER_INTS;
+        for (uint32_t k = 0; k < count; k++) {
+            const Segment& s = ringBacklog_[ringBacklogHead_ + k];
+            int32_t* slot = triples + static_cast<size_t>((write + k) & ringMask_) * 3;
+            slot[0] = s.type;
+            slot[1] = s.start;
+            slot[2] = s.end;
+        }
+        __atomic_store_n(&ring_[RING_WRITE_INDEX], static_cast<int32_t>(write + count), __ATOMIC_RELEASE);
+
+        ringBacklogHead_ += count;
+        if (ringBacklogHead_ == ringBacklog_.size()) {
+            ringBacklog_.clear();
+            ringBacklogHead_ = 0;
+        }
+        return static_cast<int>(count);
+    }
+
+    // Turns this (block) session into a nested one that expands inline-container
+    // blocks through `inlinePipeline`.
+    void nestInline(std::unique_ptr<SegmentPipeline> inlinePipeline) {
+        inline_ = std::move(inlinePipeline);
+    }
+
+    bool setAttemptLimit(int chars) {
+        if (pipeline_->pushedLength() > 0 || chars < 0) {
+            return false;
+        }
+        const int limit = chars > 0 ? chars : INT32_MAX / 4;
+        pipeline_->setAttemptLimit(limit);
+        if (inline_ != nullptr) {
+            inline_->setAttemptLimit(limit);
+        }
+        return true;
+    }
+
+    bool setBlockHashes(bool enabled) {
+        if (pipeline_->pushedLength() > 0) {
+            return false;
+        }
+        blockHashes_ = enabled;
+        return true;
+    }
+
+    void saveState(std::vector<uint8_t>& bytes) const {
+        SnapshotWriter out(bytes);
+        out.writeUInt(kSnapshotMagic);
+        out.writeInt(pipeline_->pushedLength());
+        out.writeBool(inline_ != nullptr);
+        out.writeBool(blockHashes_);
+        pipeline_->saveState(out);
+        if (inline_ != nullptr) {
+            inline_->saveState(out);
+        }
+        if (tracksHistory()) {
+            out.writeInt(historyBase_);
+            out.writeString(history_);
+        }
+        if (inline_ != nullptr) {
+            out.writeInt(nestedBlockType_);
+            out.writeUInt(static_cast<uint32_t>(inlinePieces_.size()));
+            for (const InlinePiece& piece : inlinePieces_) {
+                out.writeInt(piece.localStart);
+                out.writeInt(piece.globalStart);
+                out.writeInt(piece.length);
+            }
+            out.writeInt(inlineFed_);
+        }
+        if (blockHashes_) {
+            out.writeInt(hashedType_);
+            writeUInt64(out, hasher_.acc);
+            writeUInt64(out, hasher_.length);
+            out.writeUInt(static_cast<uint32_t>(hasher_.tailUnits));
+            for (int k = 0; k < hasher_.tailUnits; k++) {
+                out.writeChar(hasher_.tail[k]);
+            }
+        }
+    }
+
+    bool restoreState(const uint8_t* data, size_t len) {
+        SnapshotReader in(data, len);
+        if (!restoreStream(in) || !in.ok() || !in.atEnd()) {
+            resetStream();
+            return false;
+        }
+        nextCheckpoint_ = pipeline_->pushedLength() + checkpointInterval_;
+        return true;
+    }
+
+    // Reads the input offset a snapshot was taken at.
+    static bool readHeader(SnapshotReader& in, int& offset) {
+        if (in.readUInt() != kSnapshotMagic) {
+            return false;
+        }
+        offset = in.readInt(0, INT32_MAX);
+        return in.ok();
+    }
+
+    void setCheckpointInterval(int chars) {
+        checkpointInterval_ = chars;
+        nextCheckpoint_ = pipeline_->pushedLength() + chars;
+        if (chars <= 0) {
+            checkpoints_.clear();
+            checkpoints_.shrink_to_fit();
+        }
+    }
+
+    const std::vector<uint8_t>* checkpointAt(int offset) const {
+        const std::vector<uint8_t>* best = nullptr;
+        for (const Checkpoint& checkpoint : checkpoints_) {
+            if (checkpoint.offset > offset) {
+                break;
+            }
+            best = &checkpoint.bytes;
+        }
+        return best;
+    }
+
+private:
+    // Format tag and version of saveState's output ("MDS" + version 3).
+    static constexpr uint32_t kSnapshotMagic = 0x4d445303;
+
+    struct Checkpoint {
+        int offset;
+        std::vector<uint8_t> bytes;
+    };
+
+    void pushInto(const char16_t* chars, int len, std::vector<Segment>& out) {
+#if STREAMNATIVE_STATS
+        const auto pushStart = std::chrono::steady_clock::now();
+#endif
+        if (tracksHistory()) {
+            pushTracked(chars, len, out);
+        } else {
+            pipeline_->push(chars, len, out);
+        }
+#if STREAMNATIVE_STATS
+        pushNanos_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - pushStart).count());
+        pushes_++;
+#endif
+        const int pushed = pipeline_->pushedLength();
+        if (checkpointInterval_ > 0 && pushed >= nextCheckpoint_) {
+            checkpoints_.push_back({pushed, {}});
+            saveState(checkpoints_.back().bytes);
+            nextCheckpoint_ = pushed + checkpointInterval_;
+        }
+    }
+
+    // Restores into a reset session; any snapshot it accepts leaves the
+    // history, the inline pieces and both pipelines consistent.
+    bool restoreStream(SnapshotReader& in) {
+        resetStream();
+        int offset = 0;
+        if (!readHeader(in, offset) || in.readBool() != (inline_ != nullptr) || in.readBool() != blockHashes_ ||
+            !pipeline_->restoreState(in) || pipeline_->pushedLength() != offset) {
+            return false;
+        }
+        if (inline_ != nullptr && !inline_->restoreState(in)) {
+            return false;
+        }
+        if (tracksHistory()) {
+            historyBase_ = in.readInt(0, pipeline_->firstUnresolvedIndex());
+            if (!in.readString(history_) || historyBase_ + static_cast<int>(history_.size()) != offset) {
+                return false;
+            }
+        }
+        if (inline_ != nullptr) {
+            nestedBlockType_ = in.readInt();
+            const uint32_t pieces = in.readUInt();
+            for (uint32_t k = 0; k < pieces && in.ok(); k++) {
+                InlinePiece piece{};
+                piece.localStart = in.readInt(inlineFed_, inlineFed_);
+                piece.globalStart = in.readInt(0, offset);
+                piece.length = in.readInt(0, offset - piece.globalStart);
+                inlinePieces_.push_back(piece);
+                inlineFed_ += piece.length;
+            }
+            if (in.readInt() != inlineFed_ || inline_->pushedLength() != inlineFed_) {
+                return false;
+            }
+        }
+        if (blockHashes_) {
+            hashedType_ = in.readInt();
+            hasher_.acc = readUInt64(in);
+            hasher_.length = readUInt64(in);
+            hasher_.tailUnits = static_cast<int>(in.readUInt());
+            if (hasher_.tailUnits > 3) {
+                return false;
+            }
+            for (int k = 0; k < hasher_.tailUnits; k++) {
+                hasher_.tail[k] = in.readChar();
+            }
+        }
+        return true;
+    }
+
+    static void writeUInt64(SnapshotWriter& out, uint64_t v) {
+        out.writeUInt(static_cast<uint32_t>(v));
+        out.writeUInt(static_cast<uint32_t>(v >> 32));
+    }
+
+    static uint64_t readUInt64(SnapshotReader& in) {
+        const uint64_t low = in.readUInt();
+        return low | (static_cast<uint64_t>(in.readUInt()) << 32);
+    }
+
+    // Parse state back to that of a fresh session; the ring, its backlog and
+    // the recorded checkpoints are kept.
+    void resetStream() {
+        pipeline_->reset();
+        wireCursor_ = 0;
+        utf8CarryLen_ = 0;
+        history_.clear();
+        historyBase_ = 0;
+        hashedType_ = NO_BLOCK;
+        hasher_.reset();
+        if (inline_ != nullptr) {
+            inline_->reset();
+            nestedBlockType_ = NO_BLOCK;
+            inlinePieces_.clear();
+            inlineFed_ = 0;
+        }
+    }
+
+    // Same rule as the Kotlin renderer: code, XML, plan and rule blocks keep
+    // their raw content, everything else (block LaTeX included) is split into
+    // inline groups.
+    static bool isInlineContainer(int blockType) {
+        return blockType != MD_CODE_BLOCK && blockType != MD_XML_BLOCK &&
+               blockType != MD_PLAN_EXECUTION && blockType != MD_HORIZONTAL_RULE;
+    }
+
+    // Nested sessions and block hashes need the text block segments refer
+    // to, which may have arrived in earlier pushes.
+    bool tracksHistory() const { return inline_ != nullptr || blockHashes_; }
+
+    // The inline session reads block content from history_, so a nested
+    // session appends the chunk up front; hashing alone reads the chunk in
+    // place and keeps only the unresolved tail.
+    void pushTracked(const char16_t* chars, int len, std::vector<Segment>& out) {
+        const int chunkStart = pipeline_->pushedLength();
+        if (inline_ != nullptr) {
+            history_.append(chars, static_cast<size_t>(len));
+        }
+
+        blockScratch_.clear();
+        pipeline_->push(chars, len, blockScratch_);
+
+        for (const Segment& seg : blockScratch_) {
+            if (inline_ != nullptr) {
+                nestSegment(seg, out);
+            } else {
+                out.push_back(seg);
+            }
+            if (blockHashes_) {
+                hashSegment(seg, chars, chunkStart, out);
+            }
+        }
+
+        // Block segments of later pushes never reach back before this point.
+        const int keepFrom = pipeline_->firstUnresolvedIndex();
+        if (inline_ == nullptr) {
+            if (keepFrom >= chunkStart) {
+                history_.assign(chars + (keepFrom - chunkStart), static_cast<size_t>(chunkStart + len - keepFrom));
+            } else {
+                history_.erase(0, static_cast<size_t>(keepFrom - historyBase_));
+                history_.append(chars, static_cast<size_t>(len));
+            }
+            historyBase_ = keepFrom;
+        } else if (keepFrom > historyBase_) {
+            history_.erase(0, static_cast<size_t>(keepFrom - historyBase_));
+            historyBase_ = keepFrom;
+        }
+    }
+
+    void nestSegment(const Segment& seg, std::vector<Segment>& out) {
+        if (seg.type == SEG_BREAK) {
+            closeNestedBlock(seg.start, out);
+            return;
+        }
+        if (seg.type != nestedBlockType_) {
+            closeNestedBlock(seg.start, out);
+            nestedBlockType_ = seg.type;
+            out.push_back({NEST_BLOCK_OPEN, seg.type, seg.start});
+        }
+        if (isInlineContainer(seg.type)) {
+            feedInline(seg.start, seg.end, out);
+        } else {
+            out.push_back(seg);
+        }
+    }
+
+    // Adds a block segment to the open group's hash; a break closes the
+    // group and emits its hash. Plain runs (a WAITFOR's rejected pending
+    // char included) are not part of any group.
+    void hashSegment(const Segment& seg, const char16_t* chars, int chunkStart, std::vector<Segment>& out) {
+        if (seg.type == SEG_BREAK) {
+            if (hashedType_ != NO_BLOCK) {
+                const uint64_t hash = hasher_.digest();
+                out.push_back({SEG_BLOCK_HASH, static_cast<int32_t>(static_cast<uint32_t>(hash)),
+                               static_cast<int32_t>(static_cast<uint32_t>(hash >> 32))});
+                hashedType_ = NO_BLOCK;
+            }
+            return;
+        }
+        if (seg.type == MD_PLAIN_TEXT) {
+            return;
+        }
+        if (seg.type != hashedType_) {
+            hasher_.reset();
+            hashedType_ = seg.type;
+        }
+        // Whatever history_ does not hold yet is in the chunk being pushed.
+        const int historyEnd = historyBase_ + static_cast<int>(history_.size());
+        const int split = std::min(seg.end, std::max(seg.start, historyEnd));
+        hasher_.update(history_.data() + (seg.start - historyBase_), split - seg.start);
+        hasher_.update(chars + (split - chunkStart), seg.end - split);
+    }
+
+    void closeNestedBlock(int pos, std::vector<Segment>& out) {
+        if (nestedBlockType_ == NO_BLOCK) {
+            return;
+        }
+        out.push_back({NEST_BLOCK_CLOSE, nestedBlockType_, pos});
+        if (isInlineContainer(nestedBlockType_)) {
+            // Like a per-block Kotlin inline session: state and buffered chars go away.
+            inline_->reset();
+            inlinePieces_.clear();
+            inlineFed_ = 0;
+        }
+        nestedBlockType_ = NO_BLOCK;
+    }
+
+    // Feeds block content [start, end) to the inline session and appends its
+    // segments translated back to global offsets.
+    void feedInline(int start, int end, std::vector<Segment>& out) {
+        inlinePieces_.push_back({inlineFed_, start, end - start});
+        inlineFed_ += end - start;
+
+        inlineScratch_.clear();
+        inline_->push(history_.data() + (start - historyBase_), end - start, inlineScratch_);
+
+        for (const Segment& seg : inlineScratch_) {
+            if (seg.type == SEG_BREAK) {
+                const int pos = toGlobal(seg.start);
+                out.push_back({SEG_BREAK, pos, pos});
+                continue;
+            }
+            // A local run can straddle content pieces (e.g. across a stripped "> ").
+            size_t k = pieceIndexOf(seg.start);
+            int local = seg.start;
+            while (local < seg.end && k < inlinePieces_.size()) {
+                const InlinePiece& piece = inlinePieces_[k];
+                const int pieceEnd = piece.localStart + piece.length;
+                const int take = std::min(seg.end, pieceEnd) - local;
+                const int globalStart = piece.globalStart + (local - piece.localStart);
+                if (!out.empty() && out.back().type == seg.type && out.back().end == globalStart) {
+                    out.back().end = globalStart + take;
+                } else {
+                    out.push_back({seg.type, globalStart, globalStart + take});
+                }
+                local += take;
+                k++;
+            }
+        }
+    }
+
+    size_t pieceIndexOf(int local) const {
+        size_t lo = 0;
+        size_t hi = inlinePieces_.size();
+        while (hi - lo > 1) {
+            const size_t mid = (lo + hi) / 2;
+            if (inlinePieces_[mid].localStart <= local) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    int toGlobal(int local) const {
+        if (inlinePieces_.empty()) {
+            return 0;
+        }
+        const InlinePiece& piece = inlinePieces_[pieceIndexOf(local)];
+        return piece.globalStart + (local - piece.localStart);
+    }
+
+    // Block content handed to the inline session: local offsets
+    // [localStart, localStart + length) map to globalStart onwards.
+    struct InlinePiece {
+        int localStart;
+        int globalStart;
+        int length;
+    };
+
+    static constexpr int NO_BLOCK = -100;
+
+    std::unique_ptr<SegmentPipeline> pipeline_;
+
+    // Block hashes: the type of the group being hashed (NO_BLOCK if none is open).
+    bool blockHashes_ = false;
+    int hashedType_ = NO_BLOCK;
+    ContentHasher hasher_;
+
+    // Automatic checkpoints, in input order, one per `checkpointInterval_`
+    // pushed characters (at push boundaries).
+    int checkpointInterval_ = 0;
+    int nextCheckpoint_ = 0;
+    std::vector<Checkpoint> checkpoints_;
+
+    // Shared output ring (optional) and the segments still waiting for room.
+    int32_t* ring_ = nullptr;
+    uint32_t ringMask_ = 0;
+    std::vector<Segment> ringBacklog_;
+    size_t ringBacklogHead_ = 0;
+
+    // Compact output: the implied start of the next run and the last push's bytes.
+    int wireCursor_ = 0;
+    std::vector<Segment> wireScratch_;
+    std::vector<uint8_t> wireBytes_;
+
+    // UTF-8 input: the last chunk's UTF-16 units and the bytes of a sequence
+    // it cut off.
+    std::vector<char16_t> decoded_;
+    int decodedLen_ = 0;
+    uint8_t utf8Carry_[8] = {};
+    int utf8CarryLen_ = 0;
+
+    // Nested mode: the pooled inline pipeline, the text block segments may
+    // still refer to (block hashes keep it too), and the open block group.
+    std::unique_ptr<SegmentPipeline> inline_;
+    std::u16string history_;
+    int historyBase_ = 0;
+    std::vector<Segment> blockScratch_;
+    std::vector<Segment> inlineScratch_;
+    int nestedBlockType_ = NO_BLOCK;
+    std::vector<InlinePiece> inlinePieces_;
+    int inlineFed_ = 0;
+
+#if STREAMNATIVE_STATS
+    uint64_t pushes_ = 0;
+    uint64_t pushNanos_ = 0;
+#endif
 };
 
 MarkdownSession* createMarkdownBlockSession() {
-    std::vector<PluginEntry> plugins;
-    plugins.reserve(16);
-    // Order must match NestedMarkdownProcessor.getBlockPlugins()
-    plugins.push_back({std::make_unique<StreamPlanExecutionPlugin>(true), MD_PLAN_EXECUTION});
-    plugins.push_back({std::make_unique<StreamMarkdownHeaderPlugin>(true), MD_HEADER});
-    plugins.push_back({std::make_unique<StreamMarkdownFencedCodeBlockPlugin>(true), MD_CODE_BLOCK});
-    plugins.push_back({std::make_unique<StreamMarkdownBlockQuotePlugin>(false), MD_BLOCK_QUOTE});
-    plugins.push_back({std::make_unique<StreamMarkdownOrderedListPlugin>(true), MD_ORDERED_LIST});
-    plugins.push_back({std::make_unique<StreamMarkdownUnorderedListPlugin>(false), MD_UNORDERED_LIST});
-    plugins.push_back({std::make_unique<StreamMarkdownHorizontalRulePlugin>(true), MD_HORIZONTAL_RULE});
-    plugins.push_back({std::make_unique<StreamMarkdownBlockLaTeXPlugin>(false), MD_BLOCK_LATEX});
-    plugins.push_back({std::make_unique<StreamMarkdownBlockBracketLaTeXPlugin>(false), MD_BLOCK_LATEX});
-    plugins.push_back({std::make_unique<StreamMarkdownTablePlugin>(true), MD_TABLE});
-    plugins.push_back({std::make_unique<StreamMarkdownImagePlugin>(true), MD_IMAGE});
-    plugins.push_back({std::make_unique<StreamXmlPlugin>(true), MD_XML_BLOCK});
-    return new MarkdownSession(std::move(plugins));
+    return new MarkdownSession(makeBlockPipeline());
 }
 
 MarkdownSession* createMarkdownInlineSession() {
-    std::vector<PluginEntry> plugins;
-    plugins.reserve(16);
-    // Order must match NestedMarkdownProcessor.getInlinePlugins()
-    plugins.push_back({std::make_unique<StreamMarkdownBoldPlugin>(false), MD_BOLD});
-    plugins.push_back({std::make_unique<StreamMarkdownItalicPlugin>(false), MD_ITALIC});
-    plugins.push_back({std::make_unique<StreamMarkdownInlineCodePlugin>(false), MD_INLINE_CODE});
-    plugins.push_back({std::make_unique<StreamMarkdownLinkPlugin>(), MD_LINK});
-    plugins.push_back({std::make_unique<StreamMarkdownStrikethroughPlugin>(false), MD_STRIKETHROUGH});
-    plugins.push_back({std::make_unique<StreamMarkdownUnderlinePlugin>(true), MD_UNDERLINE});
-    plugins.push_back({std::make_unique<StreamMarkdownInlineLaTeXPlugin>(false), MD_INLINE_LATEX});
-    plugins.push_back({std::make_unique<StreamMarkdownInlineParenLaTeXPlugin>(false), MD_INLINE_LATEX});
-    return new MarkdownSession(std::move(plugins));
+    return new MarkdownSession(makeInlinePipeline());
+}
+
+MarkdownSession* createMarkdownNestedSession() {
+    auto* session = new MarkdownSession(makeBlockPipeline());
+    session->nestInline(makeInlinePipeline());
+    return session;
+}
+
+MarkdownSession* createJsonSession() {
+    return new MarkdownSession(std::make_unique<JsonPipeline>());
+}
+
+#if STREAMNATIVE_VIRTUAL_BASELINE
+MarkdownSession* createMarkdownBlockSessionVirtual() {
+    return new MarkdownSession(makeVirtualBlockPipeline());
 }
 
+MarkdownSession* createMarkdownInlineSessionVirtual() {
+    return new MarkdownSession(makeVirtualInlinePipeline());
+}
+#endif
+
 void destroyMarkdownSession(MarkdownSession* session) {
     delete session;
 }
 
-std::vector<Segment> markdownSessionPush(MarkdownSession* session, const jchar* chars, int len) {
+std::vector<Segment> markdownSessionPush(MarkdownSession* session, const char16_t* chars, int len) {
     if (session == nullptr || chars == nullptr || len <= 0) {
         return {};
     }
     return session->push(chars, len);
 }
 
-std::vector<Segment> splitByXml(const jchar* chars, int len) {
-    std::vector<Segment> segments;
-    segments.reserve(32);
+void encodeSegmentsCompact(const Segment* segments, size_t count, int& cursor, std::vector<uint8_t>& out) {
+    SnapshotWriter writer(out);
+    for (size_t k = 0; k < count; k++) {
+        const Segment& s = segments[k];
+        if (s.type == SEG_BREAK && s.start == cursor && s.end == cursor) {
+            writer.writeByte(WIRE_BREAK);
+        } else if (s.type >= 0 && s.type < WIRE_GAP && s.end >= s.start) {
+            if (s.start == cursor) {
+                writer.writeByte(static_cast<uint8_t>(s.type));
+            } else {
+                writer.writeByte(static_cast<uint8_t>(WIRE_GAP | s.type));
+                writer.writeInt(s.start - cursor);
+            }
+            writer.writeUInt(static_cast<uint32_t>(s.end - s.start));
+            cursor = s.end;
+        } else {
+            writer.writeByte(WIRE_ESCAPE);
+            writer.writeInt(s.type);
+            writer.writeInt(s.start);
+            // Wrapping: the fields of a SEG_BLOCK_HASH are arbitrary bits.
+            writer.writeInt(static_cast<int32_t>(static_cast<uint32_t>(s.end) - static_cast<uint32_t>(cursor)));
+        }
+    }
+}
 
-    StreamXmlPlugin xmlPlugin(true);
-    xmlPlugin.initPlugin();
+bool decodeSegmentsCompact(const uint8_t* data, size_t len, int& cursor, std::vector<Segment>& out) {
+    SnapshotReader in(data, len);
+    while (in.ok() && !in.atEnd()) {
+        const int tag = in.readByte();
+        if (tag == WIRE_BREAK) {
+            out.push_back({SEG_BREAK, cursor, cursor});
+        } else if (tag == WIRE_ESCAPE) {
+            const int type = in.readInt();
+            const int start = in.readInt();
+            const int end = static_cast<int32_t>(static_cast<uint32_t>(cursor) + static_cast<uint32_t>(in.readInt()));
+            out.push_back({type, start, end});
+        } else if (tag < WIRE_BREAK) {
+            const int start = (tag & WIRE_GAP) != 0 ? cursor + in.readInt() : cursor;
+            const int end = start + static_cast<int>(in.readUInt());
+            out.push_back({tag & (WIRE_GAP - 1), start, end});
+            cursor = end;
+        } else {
+            in.fail();
+        }
+    }
+    return in.ok();
+}
 
-    StreamPlugin* activePlugin = nullptr;
-    int activeStart = -1;
-    int defaultStart = 0;
+const std::vector<uint8_t>& markdownSessionPushCompact(MarkdownSession* session, const char16_t* chars, int len) {
+    static const std::vector<uint8_t> kEmpty;
+    if (session == nullptr) {
+        return kEmpty;
+    }
+    return session->pushCompact(chars, chars == nullptr || len < 0 ? 0 : len);
+}
 
-    int evalStart = -1;
-    bool atStartOfLine = true;
+const std::vector<uint8_t>& markdownSessionCompactBytes(MarkdownSession* session) {
+    static const std::vector<uint8_t> kEmpty;
+    if (session == nullptr) {
+        return kEmpty;
+    }
+    return session->compactBytes();
+}
 
-    auto flushDefaultIfNeeded = [&](int endExclusive) {
-        if (defaultStart < endExclusive) {
-            segments.push_back({0, defaultStart, endExclusive});
-        }
-        defaultStart = endExclusive;
-    };
+std::vector<Segment> markdownSessionPush(MarkdownSession* session, const uint8_t* bytes, int len) {
+    if (session == nullptr || bytes == nullptr || len <= 0) {
+        return {};
+    }
+    const int units = session->decodeUtf8(bytes, len);
+    if (units == 0) {
+        return {};
+    }
+    return session->push(session->decodedText(), units);
+}
 
-    auto openActive = [&](int start) {
-        activePlugin = &xmlPlugin;
-        activeStart = start;
-    };
+void markdownSessionPushInto(MarkdownSession* session, const uint8_t* bytes, int len, std::vector<Segment>& out) {
+    if (session == nullptr || bytes == nullptr || len <= 0) {
+        return;
+    }
+    session->pushUtf8Into(bytes, len, out);
+}
 
-    auto closeActive = [&](int endExclusive) {
-        if (activePlugin != nullptr && activeStart >= 0 && activeStart < endExclusive) {
-            segments.push_back({1, activeStart, endExclusive});
-        }
-        activePlugin = nullptr;
-        activeStart = -1;
-    };
+std::vector<Segment> markdownSessionFlushUtf8(MarkdownSession* session) {
+    std::vector<Segment> out;
+    markdownSessionFlushUtf8Into(session, out);
+    return out;
+}
 
-    for (int i = 0; i < len; i++) {
-        const jchar c = chars[i];
-        const bool isAtStartForCurrent = atStartOfLine;
-        atStartOfLine = (c == '\n');
+void markdownSessionFlushUtf8Into(MarkdownSession* session, std::vector<Segment>& out) {
+    if (session == nullptr) {
+        return;
+    }
+    session->flushUtf8Into(out);
+}
+
+const char16_t* markdownSessionDecodedText(MarkdownSession* session, int& len) {
+    if (session == nullptr) {
+        len = 0;
+        return nullptr;
+    }
+    len = session->decodedLength();
+    return session->decodedText();
+}
+
+bool attachMarkdownSessionRing(MarkdownSession* session, int32_t* ring, int capacity) {
+    if (session == nullptr || ring == nullptr || capacity <= 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+    session->attachRing(ring, capacity);
+    return true;
+}
 
-        if (activePlugin != nullptr) {
-            (void)activePlugin->processChar(static_cast<char16_t>(c), isAtStartForCurrent);
-            if (activePlugin->state() != PluginState::PROCESSING) {
-                closeActive(i + 1);
-                defaultStart = i + 1;
+int markdownSessionPushToRing(MarkdownSession* session, const char16_t* chars, int len) {
+    if (session == nullptr) {
+        return 0;
+    }
+    if (chars == nullptr || len <= 0) {
+        return session->drainRing();
+    }
+    return session->pushToRing(chars, len);
+}
+
+int markdownSessionPushToRing(MarkdownSession* session, const uint8_t* bytes, int len) {
+    if (session == nullptr) {
+        return 0;
+    }
+    const int units = bytes == nullptr || len <= 0 ? 0 : session->decodeUtf8(bytes, len);
+    if (units == 0) {
+        return session->drainRing();
+    }
+    return session->pushToRing(session->decodedText(), units);
+}
+
+int markdownSessionDrainRing(MarkdownSession* session) {
+    if (session == nullptr) {
+        return 0;
+    }
+    return session->drainRing();
+}
+
+bool markdownSessionSaveState(MarkdownSession* session, std::vector<uint8_t>& out) {
+    if (session == nullptr) {
+        return false;
+    }
+    out.clear();
+    session->saveState(out);
+    return true;
+}
+
+bool markdownSessionRestoreState(MarkdownSession* session, const uint8_t* data, int len) {
+    if (session == nullptr || data == nullptr || len <= 0) {
+        return false;
+    }
+    return session->restoreState(data, static_cast<size_t>(len));
+}
+
+int markdownSessionPendingLength(MarkdownSession* session) {
+    return session != nullptr ? session->pendingLength() : 0;
+}
+
+int markdownSnapshotOffset(const uint8_t* data, int len) {
+    if (data == nullptr || len <= 0) {
+        return -1;
+    }
+    SnapshotReader in(data, static_cast<size_t>(len));
+    int offset = 0;
+    return MarkdownSession::readHeader(in, offset) ? offset : -1;
+}
+
+bool markdownSessionGetStats(MarkdownSession* session, SessionStats& out) {
+#if STREAMNATIVE_STATS
+    if (session == nullptr) {
+        return false;
+    }
+    session->stats(out);
+    return true;
+#else
+    (void)session;
+    (void)out;
+    return false;
+#endif
+}
+
+bool markdownSessionSetBlockHashes(MarkdownSession* session, bool enabled) {
+    return session != nullptr && session->setBlockHashes(enabled);
+}
+
+bool markdownSessionSetAttemptLimit(MarkdownSession* session, int chars) {
+    return session != nullptr && session->setAttemptLimit(chars);
+}
+
+void markdownSessionSetCheckpointInterval(MarkdownSession* session, int intervalChars) {
+    if (session != nullptr) {
+        session->setCheckpointInterval(intervalChars);
+    }
+}
+
+const std::vector<uint8_t>* markdownSessionCheckpointAt(MarkdownSession* session, int offset) {
+    if (session == nullptr) {
+        return nullptr;
+    }
+    return session->checkpointAt(offset);
+}
+
+// splitByXml's pass, resumable: the plugin, the open tag and the pending
+// '<' candidate carry over from one push to the next, so each character is
+// looked at once however the message is chunked.
+class XmlSplitSession {
+public:
+    explicit XmlSplitSession(bool indexTags) : indexTags_(indexTags), xmlPlugin_(true, true, indexTags) {
+        xmlPlugin_.initPlugin();
+    }
+
+    void push(const char16_t* chars, int len, std::vector<Segment>& out, std::vector<Segment>* index) {
+        const int base = offset_;
+        for (int i = 0; i < len; i++) {
+            if (active_) {
+                bool shouldEmit = true;
+                const int consumed = xmlPlugin_.consumeUntilCandidate(chars + i, len - i, atStartOfLine_, shouldEmit);
+                if (consumed > 0) {
+                    i += consumed;
+                    atStartOfLine_ = (chars[i - 1] == u'\n');
+                    if (i == len) {
+                        break;
+                    }
+                }
+            } else if (evalStart_ == -1 && !atStartOfLine_) {
+                // Idle text only matters up to the next '<' or line break.
+                const int runLimit = indexOfAnyChar(chars, i, len, u'<', u'\n');
+                if (runLimit > i) {
+                    xmlPlugin_.skipInertRun(chars + i, runLimit - i);
+                    i = runLimit;
+                    if (i == len) {
+                        break;
+                    }
+                }
+            }
+
+            const char16_t c = chars[i];
+            const bool isAtStartForCurrent = atStartOfLine_;
+            atStartOfLine_ = (c == '\n');
+
+            if (active_) {
+                (void)xmlPlugin_.processChar(c, isAtStartForCurrent);
+                if (xmlPlugin_.state() != PluginState::PROCESSING) {
+                    out.push_back({1, activeStart_, base + i + 1});
+                    if (index != nullptr) {
+                        xmlPlugin_.takeIndex(*index);
+                    }
+                    active_ = false;
+                    defaultStart_ = base + i + 1;
+                }
+                continue;
+            }
+
+            if (evalStart_ == -1) {
+                evalStart_ = base + i;
+            }
+
+            (void)xmlPlugin_.processChar(c, isAtStartForCurrent);
+
+            if (xmlPlugin_.state() == PluginState::PROCESSING) {
+                flushText(evalStart_, out);
+                active_ = true;
+                activeStart_ = evalStart_;
+                evalStart_ = -1;
+            } else if (xmlPlugin_.state() != PluginState::TRYING) {
+                evalStart_ = -1;
             }
-            continue;
         }
+        offset_ = base + len;
+    }
+
+    // Text up to a possible tag start can no longer change.
+    void flushSettledText(std::vector<Segment>& out) {
+        if (!active_) {
+            flushText(evalStart_ == -1 ? offset_ : evalStart_, out);
+        }
+    }
 
-        if (evalStart == -1) {
-            evalStart = i;
+    // Ends the message: an unclosed tag runs to the end, a '<' candidate
+    // that never became a tag is text. The next push starts a new message.
+    void finish(std::vector<Segment>& out, std::vector<Segment>* index) {
+        if (active_) {
+            if (activeStart_ < offset_) {
+                out.push_back({1, activeStart_, offset_});
+                if (index != nullptr) {
+                    xmlPlugin_.takeIndex(*index);
+                }
+            }
+            active_ = false;
+            defaultStart_ = offset_;
         }
+        flushText(offset_, out);
+        // initPlugin keeps the start allowances, which belong to this message.
+        xmlPlugin_ = StreamXmlPlugin(true, true, indexTags_);
+        xmlPlugin_.initPlugin();
+        offset_ = 0;
+        defaultStart_ = 0;
+        evalStart_ = -1;
+        atStartOfLine_ = true;
+    }
 
-        (void)xmlPlugin.processChar(static_cast<char16_t>(c), isAtStartForCurrent);
+private:
+    bool indexTags_;
+    StreamXmlPlugin xmlPlugin_;
+    int offset_ = 0;
+    int defaultStart_ = 0;
+    int activeStart_ = -1;
+    int evalStart_ = -1;
+    bool active_ = false;
+    bool atStartOfLine_ = true;
 
-        if (xmlPlugin.state() == PluginState::PROCESSING) {
-            flushDefaultIfNeeded(evalStart);
-            openActive(evalStart);
-            evalStart = -1;
-        } else if (xmlPlugin.state() != PluginState::TRYING) {
-            evalStart = -1;
+    void flushText(int endExclusive, std::vector<Segment>& out) {
+        if (defaultStart_ < endExclusive) {
+            out.push_back({0, defaultStart_, endExclusive});
         }
+        defaultStart_ = endExclusive;
     }
+};
 
-    if (activePlugin != nullptr) {
-        closeActive(len);
-        defaultStart = len;
+static_assert(XML_INDEX_TAG == StreamXmlPlugin::kIndexTag && XML_INDEX_ATTR_NAME == StreamXmlPlugin::kIndexAttrName &&
+                      XML_INDEX_ATTR_VALUE == StreamXmlPlugin::kIndexAttrValue &&
+                      XML_INDEX_CHILD == StreamXmlPlugin::kIndexChild &&
+                      XML_INDEX_CHILD_CONTENT == StreamXmlPlugin::kIndexChildContent &&
+                      XML_INDEX_CONTENT == StreamXmlPlugin::kIndexContent,
+              "XML_INDEX_* mirror StreamXmlPlugin's index kinds");
+
+std::vector<Segment> splitByXml(const char16_t* chars, int len) {
+    std::vector<Segment> segments;
+    segments.reserve(32);
+    XmlSplitSession session(false);
+    session.push(chars, len, segments, nullptr);
+    session.finish(segments, nullptr);
+    return segments;
+}
+
+std::vector<Segment> splitByXml(const char16_t* chars, int len, std::vector<Segment>& index) {
+    std::vector<Segment> segments;
+    segments.reserve(32);
+    XmlSplitSession session(true);
+    session.push(chars, len, segments, &index);
+    session.finish(segments, &index);
+    return segments;
+}
+
+XmlSplitSession* createXmlSplitSession() {
+    return new XmlSplitSession(false);
+}
+
+XmlSplitSession* createIndexedXmlSplitSession() {
+    return new XmlSplitSession(true);
+}
+
+void destroyXmlSplitSession(XmlSplitSession* session) {
+    delete session;
+}
+
+std::vector<Segment> xmlSplitSessionPush(XmlSplitSession* session, const char16_t* chars, int len) {
+    std::vector<Segment> index;
+    return xmlSplitSessionPush(session, chars, len, index);
+}
+
+std::vector<Segment> xmlSplitSessionPush(XmlSplitSession* session, const char16_t* chars, int len,
+                                         std::vector<Segment>& index) {
+    std::vector<Segment> segments;
+    if (session == nullptr || chars == nullptr || len <= 0) {
+        return segments;
     }
+    session->push(chars, len, segments, &index);
+    session->flushSettledText(segments);
+    return segments;
+}
 
-    flushDefaultIfNeeded(len);
+std::vector<Segment> xmlSplitSessionFinish(XmlSplitSession* session) {
+    std::vector<Segment> index;
+    return xmlSplitSessionFinish(session, index);
+}
+
+std::vector<Segment> xmlSplitSessionFinish(XmlSplitSession* session, std::vector<Segment>& index) {
+    std::vector<Segment> segments;
+    if (session != nullptr) {
+        session->finish(segments, &index);
+    }
     return segments;
 }
 
@@ -1,20 +1,247 @@
 #pragma once
 
-#include <jni.h>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "StreamGroup.h"
 
+// Per-plugin counters and push timing in MarkdownSession; 0 compiles them
+// out entirely (see STREAMNATIVE_ENABLE_STATS in CMakeLists.txt).
+#ifndef STREAMNATIVE_STATS
+#define STREAMNATIVE_STATS 0
+#endif
+
+// Builds the virtually dispatched sessions the benchmarks compare against;
+// set only for host builds with STREAMNATIVE_BUILD_BENCHMARKS.
+#ifndef STREAMNATIVE_VIRTUAL_BASELINE
+#define STREAMNATIVE_VIRTUAL_BASELINE 0
+#endif
+
 namespace streamnative {
 
-std::vector<Segment> splitByXml(const jchar* chars, int len);
+// Segment type used only as a boundary marker between groups.
+// Kotlin side must treat this as "close current group" and not map it to MarkdownProcessorType.
+constexpr int SEG_BREAK = -1;
+constexpr int NEST_BLOCK_OPEN = -2;
+constexpr int NEST_BLOCK_CLOSE = -3;
+constexpr int SEG_BLOCK_HASH = -4;
+
+// Segment types of the JSON session.
+constexpr int JSON_TEXT = 0;
+constexpr int JSON_OBJECT_START = 1;
+constexpr int JSON_OBJECT_END = 2;
+constexpr int JSON_ARRAY_START = 3;
+constexpr int JSON_ARRAY_END = 4;
+constexpr int JSON_KEY = 5;
+constexpr int JSON_VALUE = 6;
+
+// Entry types of the XML tag index, {type, start, end} like segments.
+constexpr int XML_INDEX_TAG = 0;           // tag name; starts the entries of a block
+constexpr int XML_INDEX_ATTR_NAME = 1;     // attribute of the tag or of the child before it
+constexpr int XML_INDEX_ATTR_VALUE = 2;    // value of the attribute before it, quotes stripped
+constexpr int XML_INDEX_CHILD = 3;         // name of a direct child element
+constexpr int XML_INDEX_CHILD_CONTENT = 4; // between that child's start and end tags
+constexpr int XML_INDEX_CONTENT = 5;       // between the block's start and end tags
+
+// Splits a message into text ({0, start, end}) and XML tag blocks
+// ({1, start, end}, tags included). A tag nested in one of the same name
+// does not end it: `<a><a></a></a>` is one block.
+std::vector<Segment> splitByXml(const char16_t* chars, int len);
+
+// Same segments; also appends to `index`, per block in order, the offsets
+// of its tag name, attributes and direct children, read in the same pass.
+// A child or block whose end tag is missing has no content entry.
+//   <tool name="x"><param name="p">v</param></tool>
+//   -> TAG tool, ATTR_NAME name, ATTR_VALUE x, CHILD param, ATTR_NAME name,
+//      ATTR_VALUE p, CHILD_CONTENT v, CONTENT <param...</param>
+std::vector<Segment> splitByXml(const char16_t* chars, int len, std::vector<Segment>& index);
+
+class XmlSplitSession;
+
+// splitByXml over a message that arrives in chunks. Each push returns only
+// the segments it finalized: tag blocks once their end tag arrives, and text
+// up to where a tag may still begin (text runs are flushed at every push).
+// xmlSplitSessionFinish returns what is left open at the end of the message
+// and readies the session for the next one. With adjacent text segments
+// merged, the segments of all pushes and the finish equal splitByXml on the
+// whole message.
+XmlSplitSession* createXmlSplitSession();
+void destroyXmlSplitSession(XmlSplitSession* session);
+std::vector<Segment> xmlSplitSessionPush(XmlSplitSession* session, const char16_t* chars, int len);
+std::vector<Segment> xmlSplitSessionFinish(XmlSplitSession* session);
+
+// Session that also builds the tag index; the index overloads append the
+// entries of the blocks they return (nothing for other sessions).
+XmlSplitSession* createIndexedXmlSplitSession();
+std::vector<Segment> xmlSplitSessionPush(XmlSplitSession* session, const char16_t* chars, int len,
+                                         std::vector<Segment>& index);
+std::vector<Segment> xmlSplitSessionFinish(XmlSplitSession* session, std::vector<Segment>& index);
 
 class MarkdownSession;
 
 MarkdownSession* createMarkdownBlockSession();
 MarkdownSession* createMarkdownInlineSession();
+
+// Block session that also splits inline-container blocks (everything but
+// code, XML, plan and rule blocks) with a pooled inline session, so a single
+// push yields the whole hierarchy:
+//   {NEST_BLOCK_OPEN, blockType, position}   a block group starts
+//   {type, start, end}                       inline run, or raw content of a non-container block
+//   {SEG_BREAK, position, position}          inline group boundary
+//   {NEST_BLOCK_CLOSE, blockType, position}  the block group ends
+MarkdownSession* createMarkdownNestedSession();
+
+// Finds JSON objects and arrays in the stream and reports their structure:
+//   {JSON_TEXT, start, end}                 text outside of them
+//   {JSON_OBJECT_START / _END, pos, pos+1}  a brace; same for arrays
+//   {JSON_KEY / JSON_VALUE, start, end}     a finished key or scalar value,
+//                                           strings without their quotes
+// Keys and values are reported once their closing character arrives, so the
+// segments do not depend on how the text was chunked (text runs aside).
+MarkdownSession* createJsonSession();
+
+// The block and inline sets run with a virtual call per plugin and character,
+// as sessions did before the plugin sets were fixed at compile time. Only
+// kept as the benchmark baseline.
+#if STREAMNATIVE_VIRTUAL_BASELINE
+MarkdownSession* createMarkdownBlockSessionVirtual();
+MarkdownSession* createMarkdownInlineSessionVirtual();
+#endif
+
 void destroyMarkdownSession(MarkdownSession* session);
 
-std::vector<Segment> markdownSessionPush(MarkdownSession* session, const jchar* chars, int len);
+std::vector<Segment> markdownSessionPush(MarkdownSession* session, const char16_t* chars, int len);
+
+// UTF-8 input for native producers. The bytes are decoded (a multi-byte
+// sequence may be split across pushes) and pushed as UTF-16, so segment
+// offsets stay in UTF-16 units of the decoded stream.
+std::vector<Segment> markdownSessionPush(MarkdownSession* session, const uint8_t* bytes, int len);
+
+// Same, appending to `out` so a caller reusing it does not allocate per push.
+void markdownSessionPushInto(MarkdownSession* session, const uint8_t* bytes, int len, std::vector<Segment>& out);
+
+// Ends UTF-8 input. Each byte of a sequence the last push cut off (held
+// back until then) decodes to U+FFFD and is pushed; nothing happens if no
+// sequence is pending. markdownSessionDecodedText gives the units.
+std::vector<Segment> markdownSessionFlushUtf8(MarkdownSession* session);
+void markdownSessionFlushUtf8Into(MarkdownSession* session, std::vector<Segment>& out);
+
+// UTF-16 units the last UTF-8 push (or flush) decoded to (what segment offsets index),
+// valid until the next push.
+const char16_t* markdownSessionDecodedText(MarkdownSession* session, int& len);
+
+// Segment ring shared with the caller, as int32 slots: a header of
+// RING_HEADER_INTS followed by `capacity` packed (type, start, end) triples.
+// Indices only grow (wrapping); segment i lives in triple i & (capacity - 1).
+// The session publishes RING_WRITE_INDEX after storing the triples, the reader
+// publishes RING_READ_INDEX once it has consumed them.
+constexpr int RING_CAPACITY = 0;
+constexpr int RING_WRITE_INDEX = 1;
+constexpr int RING_READ_INDEX = 2;
+constexpr int RING_HEADER_INTS = 4;
+
+// Binds `ring` (RING_HEADER_INTS + 3 * capacity slots, capacity a power of two)
+// to the session and resets its header. The memory must outlive the session.
+bool attachMarkdownSessionRing(MarkdownSession* session, int32_t* ring, int capacity);
+
+// Pushes a chunk and publishes as many of its segments as the ring has room
+// for. Returns the number published; the rest wait for markdownSessionDrainRing.
+int markdownSessionPushToRing(MarkdownSession* session, const char16_t* chars, int len);
+int markdownSessionPushToRing(MarkdownSession* session, const uint8_t* bytes, int len);
+
+// Publishes segments left over from earlier pushes. Returns the number published.
+int markdownSessionDrainRing(MarkdownSession* session);
+
+// Compact wire format: segments as a tag byte plus varints (LEB128, zigzag
+// where signed), with each run's start implied by the end of the previous
+// one. `cursor` carries that end across calls and starts at 0.
+//   tag < WIRE_GAP             run of type `tag`; length
+//   WIRE_GAP | type            run after a gap; signed skip from cursor, length
+//   WIRE_BREAK                 SEG_BREAK at cursor
+//   WIRE_ESCAPE                anything else; signed type, signed start,
+//                              signed end - cursor (cursor is kept)
+constexpr int WIRE_GAP = 0x40;
+constexpr int WIRE_BREAK = 0x80;
+constexpr int WIRE_ESCAPE = 0xff;
+
+void encodeSegmentsCompact(const Segment* segments, size_t count, int& cursor, std::vector<uint8_t>& out);
+
+// Appends the decoded segments to `out`; false on malformed bytes.
+bool decodeSegmentsCompact(const uint8_t* data, size_t len, int& cursor, std::vector<Segment>& out);
+
+// Pushes a chunk and returns its segments in the compact format, encoded
+// against a cursor the session keeps (back to 0 on restoreState). The bytes
+// stay valid until the next push.
+const std::vector<uint8_t>& markdownSessionPushCompact(MarkdownSession* session, const char16_t* chars, int len);
+
+// Bytes of the last markdownSessionPushCompact.
+const std::vector<uint8_t>& markdownSessionCompactBytes(MarkdownSession* session);
+
+// Checkpoints: a snapshot holds the parse state after everything pushed so
+// far, so a session from the same factory can restore it and continue with
+// the rest of the text. Segments already returned are not part of it.
+bool markdownSessionSaveState(MarkdownSession* session, std::vector<uint8_t>& out);
+
+// Fails, leaving the session as if freshly created, on malformed bytes or a
+// snapshot of another kind of session (block hashes set differently
+// included). The ring stays attached.
+bool markdownSessionRestoreState(MarkdownSession* session, const uint8_t* data, int len);
+
+// Number of characters pushed before the snapshot was taken, -1 if malformed.
+int markdownSnapshotOffset(const uint8_t* data, int len);
+
+// Pushed characters still held back while plugins decide what they are. At
+// most twice the attempt limit, or twice the longest maxLookahead() if that
+// is shorter.
+int markdownSessionPendingLength(MarkdownSession* session);
+
+// With hashes on, each group that a SEG_BREAK closes is followed by
+//   {SEG_BLOCK_HASH, low, high}   32-bit halves of hashContent() of the group
+// where the group's content is the text of its runs (plain runs aside) in
+// order; a nested session hashes block groups and puts the segment after the
+// NEST_BLOCK_CLOSE. The hash does not depend on how the text was chunked,
+// so a renderer can cache highlighted or LaTeX-rendered output by it. Off by
+// default; fails once text has been pushed.
+bool markdownSessionSetBlockHashes(MarkdownSession* session, bool enabled);
+
+// Longest attempt, in characters, of plugins whose constructs run to the end
+// of a line (links, images, fence info strings, XML start tags, ...); one
+// still undecided after that many is abandoned and its text emitted as plain.
+// Plugins declaring a shorter maxLookahead() keep that. 0 lifts the limit.
+// Fails once text has been pushed.
+constexpr int DEFAULT_ATTEMPT_LIMIT = 16 * 1024;
+bool markdownSessionSetAttemptLimit(MarkdownSession* session, int chars);
+
+// Records a snapshot at the end of the first push after every further
+// `intervalChars` characters; 0 stops recording and drops the recorded ones.
+void markdownSessionSetCheckpointInterval(MarkdownSession* session, int intervalChars);
+
+// Latest recorded snapshot taken at or before `offset`, or nullptr. Valid
+// until the next push or interval change.
+const std::vector<uint8_t>* markdownSessionCheckpointAt(MarkdownSession* session, int offset);
+
+struct PluginStats {
+    int tag = 0;                       // segment type the plugin emits
+    uint64_t charsEvaluated = 0;       // characters passed to processChar
+    uint64_t charsConsumedInBulk = 0;  // characters taken by consumeUntilCandidate
+    uint64_t tryingEntries = 0;        // IDLE -> TRYING
+    uint64_t tryingRejections = 0;     // TRYING -> IDLE on the plugin's own char
+    uint64_t longestEvaluation = 0;    // longest evaluation buffer of an attempt it ended
+    uint64_t waitforConfirmed = 0;
+    uint64_t waitforRejected = 0;
+    uint64_t pendingReplays = 0;       // chars replayed as idle after its WAITFOR was rejected
+    uint64_t lookaheadAbandons = 0;    // attempts dropped at maxLookahead()
+};
+
+struct SessionStats {
+    uint64_t pushes = 0;
+    uint64_t pushNanos = 0;            // wall time spent in push, all output paths
+    std::vector<PluginStats> plugins;  // evaluation order; a nested session's inline plugins follow
+};
+
+// Counters since the session was created. False (and `out` untouched) when
+// built without STREAMNATIVE_STATS. The JSON session reports no plugins.
+bool markdownSessionGetStats(MarkdownSession* session, SessionStats& out);
 
 } // namespace streamnative
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace streamnative {
+
+// Byte encoding of session checkpoints: unsigned LEB128 varints, zigzag for
+// signed values, strings as a length followed by their UTF-16 units.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    void writeUInt(uint32_t v) {
+        while (v >= 0x80) {
+            out_.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out_.push_back(static_cast<uint8_t>(v));
+    }
+
+    void writeInt(int32_t v) {
+        writeUInt((static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31));
+    }
+
+    void writeBool(bool v) { out_.push_back(v ? 1 : 0); }
+
+    void writeByte(uint8_t v) { out_.push_back(v); }
+
+    void writeChar(char16_t c) { writeUInt(c); }
+
+    void writeChars(const char16_t* chars, size_t len) {
+        writeUInt(static_cast<uint32_t>(len));
+        for (size_t i = 0; i < len; i++) {
+            writeUInt(chars[i]);
+        }
+    }
+
+    void writeString(const std::u16string& s) { writeChars(s.data(), s.size()); }
+
+private:
+    std::vector<uint8_t>& out_;
+};
+
+// Reads what SnapshotWriter wrote. Malformed input never reads out of bounds:
+// the first bad value clears ok() and every later read returns zero.
+class SnapshotReader {
+public:
+    SnapshotReader(const uint8_t* data, size_t len) : data_(data), end_(data + len) {}
+
+    bool ok() const { return ok_; }
+    bool atEnd() const { return data_ == end_; }
+    void fail() { ok_ = false; }
+
+    uint32_t readUInt() {
+        uint32_t v = 0;
+        for (int shift = 0; ok_ && shift < 35; shift += 7) {
+            if (data_ == end_) {
+                break;
+            }
+            const uint8_t b = *data_++;
+            v |= static_cast<uint32_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return v;
+            }
+        }
+        ok_ = false;
+        return 0;
+    }
+
+    int32_t readInt() {
+        const uint32_t v = readUInt();
+        return static_cast<int32_t>((v >> 1) ^ (0u - (v & 1)));
+    }
+
+    // Signed value that must lie in [lo, hi].
+    int32_t readInt(int32_t lo, int32_t hi) {
+        const int32_t v = readInt();
+        if (v < lo || v > hi) {
+            ok_ = false;
+            return lo;
+        }
+        return ok_ ? v : lo;
+    }
+
+    uint8_t readByte() {
+        if (!ok_ || data_ == end_) {
+            ok_ = false;
+            return 0;
+        }
+        return *data_++;
+    }
+
+    bool readBool() {
+        const uint32_t v = readUInt();
+        if (v > 1) {
+            ok_ = false;
+        }
+        return ok_ && v == 1;
+    }
+
+    char16_t readChar() {
+        const uint32_t v = readUInt();
+        if (v > 0xffff) {
+            ok_ = false;
+        }
+        return ok_ ? static_cast<char16_t>(v) : u'\0';
+    }
+
+    bool readString(std::u16string& out) {
+        const uint32_t len = readUInt();
+        // Every unit takes at least one byte.
+        if (!ok_ || len > static_cast<size_t>(end_ - data_)) {
+            ok_ = false;
+            return false;
+        }
+        out.resize(len);
+        for (uint32_t i = 0; i < len; i++) {
+            out[i] = readChar();
+        }
+        return ok_;
+    }
+
+private:
+    const uint8_t* data_;
+    const uint8_t* end_;
+    bool ok_ = true;
+};
+
+} // namespace streamnative
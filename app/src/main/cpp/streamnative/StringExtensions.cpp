@@ -1 +1,273 @@
 #include "StringExtensions.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace streamnative {
+
+namespace {
+
+// Tail (and fallback) loop for inputs shorter than one vector block.
+template <typename Pred>
+inline int scanScalar(const char16_t* chars, int from, int len, Pred pred) {
+    int i = from;
+    while (i < len && !pred(chars[i])) {
+        i++;
+    }
+    return i;
+}
+
+#if defined(__SSE2__)
+
+// _mm_movemask_epi8 yields two bits per UTF-16 unit.
+inline int firstMatchIndex(unsigned mask) {
+    return __builtin_ctz(mask) >> 1;
+}
+
+#elif defined(__ARM_NEON)
+
+// Narrows a 16-bit lane mask to one byte per lane and returns the lane index
+// of the first set lane, or 8 if none.
+inline int firstMatchLane(uint16x8_t eq) {
+    const uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(eq)), 0);
+    if (bits == 0) {
+        return 8;
+    }
+    return __builtin_ctzll(bits) >> 3;
+}
+
+#endif
+
+} // namespace
+
+int indexOfChar(const char16_t* chars, int from, int len, char16_t a) {
+    int i = from;
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi16(static_cast<short>(a));
+    for (; i + 8 <= len; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + i));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, va)));
+        if (mask != 0) {
+            return i + firstMatchIndex(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint16x8_t va = vdupq_n_u16(static_cast<uint16_t>(a));
+    for (; i + 8 <= len; i += 8) {
+        const uint16x8_t v = vld1q_u16(reinterpret_cast<const uint16_t*>(chars + i));
+        const int lane = firstMatchLane(vceqq_u16(v, va));
+        if (lane < 8) {
+            return i + lane;
+        }
+    }
+#endif
+    return scanScalar(chars, i, len, [a](char16_t c) { return c == a; });
+}
+
+int indexOfAnyChar(const char16_t* chars, int from, int len, char16_t a, char16_t b) {
+    int i = from;
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi16(static_cast<short>(a));
+    const __m128i vb = _mm_set1_epi16(static_cast<short>(b));
+    for (; i + 8 <= len; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + i));
+        const __m128i eq = _mm_or_si128(_mm_cmpeq_epi16(v, va), _mm_cmpeq_epi16(v, vb));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if (mask != 0) {
+            return i + firstMatchIndex(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint16x8_t va = vdupq_n_u16(static_cast<uint16_t>(a));
+    const uint16x8_t vb = vdupq_n_u16(static_cast<uint16_t>(b));
+    for (; i + 8 <= len; i += 8) {
+        const uint16x8_t v = vld1q_u16(reinterpret_cast<const uint16_t*>(chars + i));
+        const int lane = firstMatchLane(vorrq_u16(vceqq_u16(v, va), vceqq_u16(v, vb)));
+        if (lane < 8) {
+            return i + lane;
+        }
+    }
+#endif
+    return scanScalar(chars, i, len, [a, b](char16_t c) { return c == a || c == b; });
+}
+
+namespace {
+
+// Length of the sequence a lead byte starts, 0 for bytes that cannot lead.
+inline int utf8SequenceLength(uint8_t b) {
+    if (b < 0x80) {
+        return 1;
+    }
+    if ((b & 0xE0) == 0xC0) {
+        return 2;
+    }
+    if ((b & 0xF0) == 0xE0) {
+        return 3;
+    }
+    if ((b & 0xF8) == 0xF0) {
+        return 4;
+    }
+    return 0;
+}
+
+inline bool isContinuation(uint8_t b) {
+    return (b & 0xC0) == 0x80;
+}
+
+// Copies the leading ASCII bytes of bytes[i, len) to out[o...], a vector
+// block at a time; returns the new i.
+inline int copyAsciiRun(const uint8_t* bytes, int i, int len, char16_t* out, int& o) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16, o += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        if (_mm_movemask_epi8(v) != 0) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= len; i += 16, o += 16) {
+        const uint8x16_t v = vld1q_u8(bytes + i);
+        const uint8x8_t either = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+        if ((vget_lane_u64(vreinterpret_u64_u8(either), 0) & 0x8080808080808080ULL) != 0) {
+            break;
+        }
+        vst1q_u16(reinterpret_cast<uint16_t*>(out + o), vmovl_u8(vget_low_u8(v)));
+        vst1q_u16(reinterpret_cast<uint16_t*>(out + o + 8), vmovl_u8(vget_high_u8(v)));
+    }
+#endif
+    while (i < len && bytes[i] < 0x80) {
+        out[o++] = bytes[i++];
+    }
+    return i;
+}
+
+} // namespace
+
+int utf8ToUtf16(const uint8_t* bytes, int len, char16_t* out, int& written) {
+    int i = 0;
+    int o = 0;
+    while (i < len) {
+        i = copyAsciiRun(bytes, i, len, out, o);
+        if (i == len) {
+            break;
+        }
+
+        const uint8_t b0 = bytes[i];
+        const int n = utf8SequenceLength(b0);
+        if (n == 0) {
+            out[o++] = 0xFFFD;
+            i++;
+            continue;
+        }
+        int k = 1;
+        while (k < n && i + k < len && isContinuation(bytes[i + k])) {
+            k++;
+        }
+        if (k < n) {
+            if (i + k == len) {
+                break; // the rest arrives with the next chunk
+            }
+            out[o++] = 0xFFFD;
+            i++;
+            continue;
+        }
+
+        uint32_t cp = b0 & (0x7F >> n);
+        for (k = 1; k < n; k++) {
+            cp = (cp << 6) | (bytes[i + k] & 0x3F);
+        }
+        static const uint32_t kMinForLength[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (cp < kMinForLength[n] || cp > 0x10FFFF) {
+            cp = 0xFFFD;
+        }
+        if (cp <= 0xFFFF) {
+            out[o++] = static_cast<char16_t>(cp);
+        } else {
+            cp -= 0x10000;
+            out[o++] = static_cast<char16_t>(0xD800 + (cp >> 10));
+            out[o++] = static_cast<char16_t>(0xDC00 + (cp & 0x3FF));
+        }
+        i += n;
+    }
+    written = o;
+    return i;
+}
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+inline uint64_t rotl64(uint64_t v, int r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+inline uint64_t hashRound(uint64_t acc, const char16_t* word) {
+    uint64_t input;
+    std::memcpy(&input, word, sizeof(input));
+    acc += input * kPrime2;
+    return rotl64(acc, 31) * kPrime1;
+}
+
+} // namespace
+
+void ContentHasher::reset() {
+    acc = kPrime5;
+    length = 0;
+    tailUnits = 0;
+}
+
+void ContentHasher::update(const char16_t* chars, int len) {
+    length += static_cast<uint64_t>(len);
+    int i = 0;
+    if (tailUnits > 0) {
+        while (tailUnits < 4 && i < len) {
+            tail[tailUnits++] = chars[i++];
+        }
+        if (tailUnits < 4) {
+            return;
+        }
+        acc = hashRound(acc, tail);
+        tailUnits = 0;
+    }
+    for (; i + 4 <= len; i += 4) {
+        acc = hashRound(acc, chars + i);
+    }
+    while (i < len) {
+        tail[tailUnits++] = chars[i++];
+    }
+}
+
+uint64_t ContentHasher::digest() const {
+    uint64_t h = acc + length * 2;
+    for (int k = 0; k < tailUnits; k++) {
+        h ^= static_cast<uint64_t>(tail[k]) * kPrime5;
+        h = rotl64(h, 11) * kPrime1 + kPrime4;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t hashContent(const char16_t* chars, int len) {
+    ContentHasher hasher;
+    hasher.update(chars, len);
+    return hasher.digest();
+}
+
+} // namespace streamnative
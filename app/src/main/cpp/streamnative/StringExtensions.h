@@ -1,5 +1,39 @@
 #pragma once
 
+#include <cstdint>
+
 namespace streamnative {
 
+// Index of the first `a` in chars[from, len), or len if there is none.
+int indexOfChar(const char16_t* chars, int from, int len, char16_t a);
+
+// Index of the first `a` or `b` in chars[from, len), or len if there is none.
+int indexOfAnyChar(const char16_t* chars, int from, int len, char16_t a, char16_t b);
+
+// Decodes UTF-8 into `out` (room for `len` units) the way the JNI layers'
+// bytesUtf8ToJstring does: a malformed byte becomes U+FFFD, overlong and
+// out-of-range sequences become one U+FFFD each. A sequence cut off by the
+// end of `bytes` is left undecoded. Returns the bytes consumed and sets
+// `written` to the units stored.
+int utf8ToUtf16(const uint8_t* bytes, int len, char16_t* out, int& written);
+
+// Streaming 64-bit hash of UTF-16 text (one xxHash64 lane over four units at
+// a time). The digest depends only on the units hashed, not on how they were
+// split across update() calls, so a block hashed as it streams in matches
+// hashContent() of the whole block.
+struct ContentHasher {
+    uint64_t acc;
+    uint64_t length;
+    char16_t tail[4]; // units waiting for a full word
+    int tailUnits;
+
+    ContentHasher() { reset(); }
+
+    void reset();
+    void update(const char16_t* chars, int len);
+    uint64_t digest() const;
+};
+
+uint64_t hashContent(const char16_t* chars, int len);
+
 } // namespace streamnative
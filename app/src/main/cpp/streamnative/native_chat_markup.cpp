@@ -0,0 +1,58 @@
+#include <jni.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "streamnative/ChatMarkupScanner.h"
+
+namespace {
+
+inline jintArray matchesToJIntArray(JNIEnv* env, const std::vector<streamnative::Segment>& matches) {
+    jintArray out = env->NewIntArray(static_cast<jsize>(matches.size() * 3));
+    if (out == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<jint> flat;
+    flat.reserve(matches.size() * 3);
+    for (const auto& m : matches) {
+        flat.push_back(static_cast<jint>(m.type));
+        flat.push_back(static_cast<jint>(m.start));
+        flat.push_back(static_cast<jint>(m.end));
+    }
+
+    env->SetIntArrayRegion(out, 0, static_cast<jsize>(flat.size()), flat.data());
+    return out;
+}
+
+} // namespace
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeChatMarkup_nativeScan(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jstring content,
+        jint mask
+) {
+    if (content == nullptr) {
+        return env->NewIntArray(0);
+    }
+
+    // The scan makes no JNI calls, so the content is read in place.
+    const jsize len = env->GetStringLength(content);
+    const jchar* chars = env->GetStringCritical(content, nullptr);
+    if (chars == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<streamnative::Segment> matches;
+    streamnative::scanChatMarkup(
+            reinterpret_cast<const char16_t*>(chars),
+            static_cast<int>(len),
+            static_cast<uint32_t>(mask),
+            matches
+    );
+
+    env->ReleaseStringCritical(content, chars);
+    return matchesToJIntArray(env, matches);
+}
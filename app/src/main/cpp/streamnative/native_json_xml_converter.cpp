@@ -0,0 +1,82 @@
+#include <jni.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "streamnative/JsonXmlConverter.h"
+
+namespace {
+
+inline jintArray eventsToJIntArray(JNIEnv* env, const std::vector<int32_t>& events) {
+    jintArray out = env->NewIntArray(static_cast<jsize>(events.size()));
+    if (out == nullptr) {
+        return nullptr;
+    }
+    env->SetIntArrayRegion(out, 0, static_cast<jsize>(events.size()), events.data());
+    return out;
+}
+
+// The converter lives in the caller's state array between calls; a bad
+// length or a state array never written by us starts over.
+bool loadConverter(JNIEnv* env, jintArray state, streamnative::JsonXmlConverter& converter) {
+    if (state == nullptr || env->GetArrayLength(state) != streamnative::JsonXmlConverter::kStateInts) {
+        return false;
+    }
+    int32_t slots[streamnative::JsonXmlConverter::kStateInts];
+    env->GetIntArrayRegion(state, 0, streamnative::JsonXmlConverter::kStateInts, slots);
+    converter.restoreState(slots);
+    return true;
+}
+
+void storeConverter(JNIEnv* env, jintArray state, const streamnative::JsonXmlConverter& converter) {
+    int32_t slots[streamnative::JsonXmlConverter::kStateInts];
+    converter.saveState(slots);
+    env->SetIntArrayRegion(state, 0, streamnative::JsonXmlConverter::kStateInts, slots);
+}
+
+} // namespace
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeJsonXmlConverter_nativeFeed(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jintArray state,
+        jstring chunk
+) {
+    streamnative::JsonXmlConverter converter;
+    if (chunk == nullptr || !loadConverter(env, state, converter)) {
+        return env->NewIntArray(0);
+    }
+
+    // The state machine makes no JNI calls, so the chunk is read in place.
+    const jsize len = env->GetStringLength(chunk);
+    const jchar* chars = env->GetStringCritical(chunk, nullptr);
+    if (chars == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<int32_t> events;
+    events.reserve(16);
+    converter.push(reinterpret_cast<const char16_t*>(chars), static_cast<int>(len), events);
+
+    env->ReleaseStringCritical(chunk, chars);
+
+    storeConverter(env, state, converter);
+    return eventsToJIntArray(env, events);
+}
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeJsonXmlConverter_nativeFlush(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jintArray state
+) {
+    streamnative::JsonXmlConverter converter;
+    if (!loadConverter(env, state, converter)) {
+        return env->NewIntArray(0);
+    }
+    std::vector<int32_t> events;
+    converter.flush(events);
+    storeConverter(env, state, converter);
+    return eventsToJIntArray(env, events);
+}
@@ -1,5 +1,7 @@
 #include <jni.h>
 
+#include <cstdint>
+#include <cstring>
 #include <vector>
 
 #include "streamnative/StreamOperators.h"
@@ -24,6 +26,47 @@ inline jintArray segmentsToJIntArray(JNIEnv* env, const std::vector<streamnative
     return out;
 }
 
+inline jbyteArray bytesToJByteArray(JNIEnv* env, const std::vector<uint8_t>& bytes) {
+    jbyteArray out = env->NewByteArray(static_cast<jsize>(bytes.size()));
+    if (out == nullptr) {
+        return nullptr;
+    }
+    env->SetByteArrayRegion(out, 0, static_cast<jsize>(bytes.size()), reinterpret_cast<const jbyte*>(bytes.data()));
+    return out;
+}
+
+// Copies `bytes` into the direct buffer `out` if they fit. Returns their
+// size, or minus their size if the buffer is too small.
+inline jint copyToDirectBuffer(JNIEnv* env, const std::vector<uint8_t>& bytes, jobject out) {
+    auto* data = static_cast<uint8_t*>(env->GetDirectBufferAddress(out));
+    const jlong capacity = env->GetDirectBufferCapacity(out);
+    const jint size = static_cast<jint>(bytes.size());
+    if (data == nullptr || capacity < size) {
+        return -size;
+    }
+    if (size > 0) {
+        std::memcpy(data, bytes.data(), bytes.size());
+    }
+    return size;
+}
+
+// Copies `chunk` into a buffer reused by the calling thread. A push can run
+// nested inline parsing and content hashing, work that must not run inside
+// a GetStringCritical section, where it would hold off the GC. Returns
+// nullptr if the copy failed (an exception is pending).
+const char16_t* copyChunk(JNIEnv* env, jstring chunk, jsize& len) {
+    thread_local std::vector<jchar> scratch;
+    len = env->GetStringLength(chunk);
+    if (scratch.size() < static_cast<size_t>(len) + 1) {
+        scratch.resize(static_cast<size_t>(len) + 1);
+    }
+    env->GetStringRegion(chunk, 0, len, scratch.data());
+    if (env->ExceptionCheck()) {
+        return nullptr;
+    }
+    return reinterpret_cast<const char16_t*>(scratch.data());
+}
+
 } // namespace
 
 extern "C" JNIEXPORT jlong JNICALL
@@ -44,6 +87,24 @@ Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeCre
     return reinterpret_cast<jlong>(s);
 }
 
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeCreateNestedSession(
+        JNIEnv* /*env*/,
+        jobject /*thiz*/
+) {
+    auto* s = streamnative::createMarkdownNestedSession();
+    return reinterpret_cast<jlong>(s);
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeCreateJsonSession(
+        JNIEnv* /*env*/,
+        jobject /*thiz*/
+) {
+    auto* s = streamnative::createJsonSession();
+    return reinterpret_cast<jlong>(s);
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeDestroySession(
         JNIEnv* /*env*/,
@@ -67,12 +128,276 @@ Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativePus
 
     auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
 
-    const jsize len = env->GetStringLength(chunk);
-    const jchar* chars = env->GetStringChars(chunk, nullptr);
+    jsize len = 0;
+    const char16_t* chars = copyChunk(env, chunk, len);
+    if (chars == nullptr) {
+        env->ExceptionClear();
+        return env->NewIntArray(0);
+    }
 
     std::vector<streamnative::Segment> segments = streamnative::markdownSessionPush(s, chars, static_cast<int>(len));
 
-    env->ReleaseStringChars(chunk, chars);
-
     return segmentsToJIntArray(env, segments);
 }
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeAttachRing(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle,
+        jobject ring,
+        jint capacity
+) {
+    if (handle == 0 || ring == nullptr || capacity <= 0) {
+        return JNI_FALSE;
+    }
+
+    auto* data = static_cast<int32_t*>(env->GetDirectBufferAddress(ring));
+    const jlong bytes = env->GetDirectBufferCapacity(ring);
+    const jlong needed = static_cast<jlong>(streamnative::RING_HEADER_INTS + capacity * 3) * 4;
+    if (data == nullptr || bytes < needed) {
+        return JNI_FALSE;
+    }
+
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    return streamnative::attachMarkdownSessionRing(s, data, static_cast<int>(capacity)) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativePushToRing(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle,
+        jstring chunk
+) {
+    if (handle == 0 || chunk == nullptr) {
+        return 0;
+    }
+
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+
+    jsize len = 0;
+    const char16_t* chars = copyChunk(env, chunk, len);
+    if (chars == nullptr) {
+        env->ExceptionClear();
+        return 0;
+    }
+
+    const int published = streamnative::markdownSessionPushToRing(s, chars, static_cast<int>(len));
+
+    return static_cast<jint>(published);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeDrainRing(
+        JNIEnv* /*env*/,
+        jobject /*thiz*/,
+        jlong handle
+) {
+    if (handle == 0) {
+        return 0;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    return static_cast<jint>(streamnative::markdownSessionDrainRing(s));
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativePushCompact(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle,
+        jstring chunk,
+        jobject out
+) {
+    if (handle == 0 || chunk == nullptr || out == nullptr) {
+        return 0;
+    }
+
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+
+    jsize len = 0;
+    const char16_t* chars = copyChunk(env, chunk, len);
+    if (chars == nullptr) {
+        env->ExceptionClear();
+        return 0;
+    }
+
+    const std::vector<uint8_t>& bytes = streamnative::markdownSessionPushCompact(s, chars, static_cast<int>(len));
+
+    return copyToDirectBuffer(env, bytes, out);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeCopyCompact(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle,
+        jobject out
+) {
+    if (handle == 0 || out == nullptr) {
+        return 0;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    return copyToDirectBuffer(env, streamnative::markdownSessionCompactBytes(s), out);
+}
+
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeSaveState(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle
+) {
+    if (handle == 0) {
+        return nullptr;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    std::vector<uint8_t> state;
+    streamnative::markdownSessionSaveState(s, state);
+    return bytesToJByteArray(env, state);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeRestoreState(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle,
+        jbyteArray state
+) {
+    if (handle == 0 || state == nullptr) {
+        return JNI_FALSE;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+
+    const jsize len = env->GetArrayLength(state);
+    jbyte* bytes = env->GetByteArrayElements(state, nullptr);
+    if (bytes == nullptr) {
+        return JNI_FALSE;
+    }
+    const bool restored = streamnative::markdownSessionRestoreState(
+            s,
+            reinterpret_cast<const uint8_t*>(bytes),
+            static_cast<int>(len)
+    );
+    env->ReleaseByteArrayElements(state, bytes, JNI_ABORT);
+    return restored ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeSnapshotOffset(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jbyteArray state
+) {
+    if (state == nullptr) {
+        return -1;
+    }
+    const jsize len = env->GetArrayLength(state);
+    jbyte* bytes = env->GetByteArrayElements(state, nullptr);
+    if (bytes == nullptr) {
+        return -1;
+    }
+    const int offset = streamnative::markdownSnapshotOffset(reinterpret_cast<const uint8_t*>(bytes), static_cast<int>(len));
+    env->ReleaseByteArrayElements(state, bytes, JNI_ABORT);
+    return static_cast<jint>(offset);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeSetBlockHashes(
+        JNIEnv* /*env*/,
+        jobject /*thiz*/,
+        jlong handle,
+        jboolean enabled
+) {
+    if (handle == 0) {
+        return JNI_FALSE;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    return streamnative::markdownSessionSetBlockHashes(s, enabled == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeSetAttemptLimit(
+        JNIEnv* /*env*/,
+        jobject /*thiz*/,
+        jlong handle,
+        jint chars
+) {
+    if (handle == 0) {
+        return JNI_FALSE;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    return streamnative::markdownSessionSetAttemptLimit(s, static_cast<int>(chars)) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeSetCheckpointInterval(
+        JNIEnv* /*env*/,
+        jobject /*thiz*/,
+        jlong handle,
+        jint intervalChars
+) {
+    if (handle == 0) {
+        return;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    streamnative::markdownSessionSetCheckpointInterval(s, static_cast<int>(intervalChars));
+}
+
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeCheckpointAt(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle,
+        jint offset
+) {
+    if (handle == 0) {
+        return nullptr;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    const std::vector<uint8_t>* state = streamnative::markdownSessionCheckpointAt(s, static_cast<int>(offset));
+    return state != nullptr ? bytesToJByteArray(env, *state) : nullptr;
+}
+
+// [pushes, pushNanos, then per plugin: tag, charsEvaluated,
+// charsConsumedInBulk, tryingEntries, tryingRejections, longestEvaluation,
+// waitforConfirmed, waitforRejected, pendingReplays, lookaheadAbandons], or null when the
+// library was built without STREAMNATIVE_STATS.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeMarkdownSplitter_nativeGetStats(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle
+) {
+    if (handle == 0) {
+        return nullptr;
+    }
+    auto* s = reinterpret_cast<streamnative::MarkdownSession*>(handle);
+    streamnative::SessionStats stats;
+    if (!streamnative::markdownSessionGetStats(s, stats)) {
+        return nullptr;
+    }
+
+    std::vector<jlong> flat;
+    flat.reserve(2 + stats.plugins.size() * 10);
+    flat.push_back(static_cast<jlong>(stats.pushes));
+    flat.push_back(static_cast<jlong>(stats.pushNanos));
+    for (const auto& p : stats.plugins) {
+        flat.push_back(static_cast<jlong>(p.tag));
+        flat.push_back(static_cast<jlong>(p.charsEvaluated));
+        flat.push_back(static_cast<jlong>(p.charsConsumedInBulk));
+        flat.push_back(static_cast<jlong>(p.tryingEntries));
+        flat.push_back(static_cast<jlong>(p.tryingRejections));
+        flat.push_back(static_cast<jlong>(p.longestEvaluation));
+        flat.push_back(static_cast<jlong>(p.waitforConfirmed));
+        flat.push_back(static_cast<jlong>(p.waitforRejected));
+        flat.push_back(static_cast<jlong>(p.pendingReplays));
+        flat.push_back(static_cast<jlong>(p.lookaheadAbandons));
+    }
+
+    jlongArray out = env->NewLongArray(static_cast<jsize>(flat.size()));
+    if (out == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(out, 0, static_cast<jsize>(flat.size()), flat.data());
+    return out;
+}
@@ -23,6 +23,30 @@ inline jintArray segmentsToJIntArray(JNIEnv* env, const std::vector<streamnative
     return out;
 }
 
+// [segment count, segment triples..., index triples...]
+inline jintArray segmentsAndIndexToJIntArray(JNIEnv* env, const std::vector<streamnative::Segment>& segments,
+                                             const std::vector<streamnative::Segment>& index) {
+    const size_t total = 1 + (segments.size() + index.size()) * 3;
+    jintArray out = env->NewIntArray(static_cast<jsize>(total));
+    if (out == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<jint> flat;
+    flat.reserve(total);
+    flat.push_back(static_cast<jint>(segments.size()));
+    for (const auto* list : {&segments, &index}) {
+        for (const auto& s : *list) {
+            flat.push_back(static_cast<jint>(s.type));
+            flat.push_back(static_cast<jint>(s.start));
+            flat.push_back(static_cast<jint>(s.end));
+        }
+    }
+
+    env->SetIntArrayRegion(out, 0, static_cast<jsize>(flat.size()), flat.data());
+    return out;
+}
+
 } // namespace
 
 extern "C" JNIEXPORT jintArray JNICALL
@@ -35,12 +59,131 @@ Java_com_ai_assistance_operit_util_streamnative_NativeXmlSplitter_nativeSplitXml
         return env->NewIntArray(0);
     }
 
+    // splitByXml is a single bounded pass with no JNI calls, so it can run
+    // inside the critical region instead of copying the whole message.
     const jsize len = env->GetStringLength(content);
-    const jchar* chars = env->GetStringChars(content, nullptr);
+    const jchar* chars = env->GetStringCritical(content, nullptr);
+    if (chars == nullptr) {
+        return nullptr;
+    }
 
-    std::vector<streamnative::Segment> segments = streamnative::splitByXml(chars, static_cast<int>(len));
+    std::vector<streamnative::Segment> segments = streamnative::splitByXml(
+            reinterpret_cast<const char16_t*>(chars),
+            static_cast<int>(len)
+    );
 
-    env->ReleaseStringChars(content, chars);
+    env->ReleaseStringCritical(content, chars);
 
     return segmentsToJIntArray(env, segments);
 }
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeXmlSplitter_nativeSplitXmlIndexed(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jstring content
+) {
+    if (content == nullptr) {
+        return env->NewIntArray(1);
+    }
+
+    const jsize len = env->GetStringLength(content);
+    const jchar* chars = env->GetStringCritical(content, nullptr);
+    if (chars == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<streamnative::Segment> index;
+    std::vector<streamnative::Segment> segments = streamnative::splitByXml(
+            reinterpret_cast<const char16_t*>(chars),
+            static_cast<int>(len),
+            index
+    );
+
+    env->ReleaseStringCritical(content, chars);
+
+    return segmentsAndIndexToJIntArray(env, segments, index);
+}
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeXmlSplitter_nativeSplitXmlSegmentsDirect(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jobject buffer,
+        jint offset,
+        jint length
+) {
+    if (buffer == nullptr || offset < 0 || length <= 0) {
+        return env->NewIntArray(0);
+    }
+
+    // Direct CharBuffer in native byte order; capacity is in chars.
+    auto* chars = static_cast<const char16_t*>(env->GetDirectBufferAddress(buffer));
+    const jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (chars == nullptr || static_cast<jlong>(offset) + length > capacity) {
+        return env->NewIntArray(0);
+    }
+
+    std::vector<streamnative::Segment> segments = streamnative::splitByXml(chars + offset, static_cast<int>(length));
+    return segmentsToJIntArray(env, segments);
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeXmlSplitter_nativeCreateSession(
+        JNIEnv* /*env*/,
+        jobject /*thiz*/
+) {
+    return reinterpret_cast<jlong>(streamnative::createXmlSplitSession());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeXmlSplitter_nativeDestroySession(
+        JNIEnv* /*env*/,
+        jobject /*thiz*/,
+        jlong handle
+) {
+    streamnative::destroyXmlSplitSession(reinterpret_cast<streamnative::XmlSplitSession*>(handle));
+}
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeXmlSplitter_nativePush(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle,
+        jstring chunk
+) {
+    if (handle == 0 || chunk == nullptr) {
+        return env->NewIntArray(0);
+    }
+
+    auto* s = reinterpret_cast<streamnative::XmlSplitSession*>(handle);
+
+    const jsize len = env->GetStringLength(chunk);
+    const jchar* chars = env->GetStringCritical(chunk, nullptr);
+    if (chars == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<streamnative::Segment> segments = streamnative::xmlSplitSessionPush(
+            s,
+            reinterpret_cast<const char16_t*>(chars),
+            static_cast<int>(len)
+    );
+
+    env->ReleaseStringCritical(chunk, chars);
+
+    return segmentsToJIntArray(env, segments);
+}
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_ai_assistance_operit_util_streamnative_NativeXmlSplitter_nativeFinish(
+        JNIEnv* env,
+        jobject /*thiz*/,
+        jlong handle
+) {
+    if (handle == 0) {
+        return env->NewIntArray(0);
+    }
+    auto* s = reinterpret_cast<streamnative::XmlSplitSession*>(handle);
+    return segmentsToJIntArray(env, streamnative::xmlSplitSessionFinish(s));
+}
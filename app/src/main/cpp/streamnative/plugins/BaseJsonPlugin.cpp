@@ -1 +1,219 @@
 #include "BaseJsonPlugin.h"
+
+#include "../StringExtensions.h"
+
+namespace streamnative {
+
+namespace {
+
+inline bool isJsonWhitespace(char16_t c) {
+    return c == u' ' || c == u'\t' || c == u'\n' || c == u'\r';
+}
+
+inline bool isJsonStructural(char16_t c) {
+    return c == u'{' || c == u'}' || c == u'[' || c == u']' || c == u',' || c == u':' || c == u'"' ||
+           isJsonWhitespace(c);
+}
+
+} // namespace
+
+BaseJsonPlugin::BaseJsonPlugin(bool contentOnly)
+        : contentOnly_(contentOnly),
+          state_(PluginState::IDLE),
+          inString_(false),
+          escaped_(false),
+          stringIsKey_(false),
+          inScalar_(false),
+          expectKey_(false),
+          pos_(0),
+          openStart_(0),
+          tokenStart_(0),
+          tokenEnd_(0),
+          events_(0) {
+    reset();
+}
+
+bool BaseJsonPlugin::initPlugin() {
+    reset();
+    return true;
+}
+
+// Leaves the report of the last character alone, so the session can still
+// read the closer that finished the value.
+void BaseJsonPlugin::resetInternal() {
+    state_ = PluginState::IDLE;
+    containers_.clear();
+    inString_ = false;
+    escaped_ = false;
+    stringIsKey_ = false;
+    inScalar_ = false;
+    expectKey_ = false;
+    openStart_ = 0;
+}
+
+void BaseJsonPlugin::reset() {
+    resetInternal();
+    pos_ = 0;
+    tokenStart_ = 0;
+    tokenEnd_ = 0;
+    events_ = 0;
+}
+
+void BaseJsonPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(pos_);
+    out.writeUInt(static_cast<uint32_t>(containers_.size()));
+    for (uint8_t kind : containers_) {
+        out.writeBool(kind == kArray);
+    }
+    out.writeBool(inString_);
+    out.writeBool(escaped_);
+    out.writeBool(stringIsKey_);
+    out.writeBool(inScalar_);
+    out.writeBool(expectKey_);
+    out.writeInt(openStart_);
+}
+
+bool BaseJsonPlugin::restoreState(SnapshotReader& in) {
+    reset();
+    state_ = readPluginState(in);
+    pos_ = in.readInt(0, INT32_MAX);
+    // Every open container took one character.
+    const uint32_t depth = in.readUInt();
+    if (depth > static_cast<uint32_t>(pos_) || (depth == 0) != (state_ == PluginState::IDLE) ||
+        (state_ != PluginState::IDLE && state_ != PluginState::PROCESSING)) {
+        in.fail();
+    }
+    for (uint32_t k = 0; k < depth && in.ok(); k++) {
+        containers_.push_back(in.readBool() ? kArray : kObject);
+    }
+    inString_ = in.readBool();
+    escaped_ = in.readBool();
+    stringIsKey_ = in.readBool();
+    inScalar_ = in.readBool();
+    expectKey_ = in.readBool();
+    openStart_ = in.readInt(0, pos_);
+    if ((escaped_ && !inString_) || (inString_ && inScalar_) ||
+        (state_ == PluginState::IDLE && (inString_ || inScalar_))) {
+        in.fail();
+    }
+    return in.ok();
+}
+
+bool BaseJsonPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"{");
+    out.emplace_back(u"[");
+    return true;
+}
+
+int BaseJsonPlugin::consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+    (void)atStartOfLine;
+    if (state_ != PluginState::PROCESSING || !inString_ || escaped_) {
+        return 0;
+    }
+    // String bodies only end at a quote and only change state at a backslash.
+    const int n = indexOfAnyChar(chars, 0, len, u'"', u'\\');
+    if (n > 0) {
+        pos_ += n;
+        events_ = 0;
+        shouldEmit = true;
+    }
+    return n;
+}
+
+void BaseJsonPlugin::openContainer(uint8_t kind) {
+    containers_.push_back(kind);
+    expectKey_ = kind == kObject;
+    events_ |= kind == kObject ? kObjectStart : kArrayStart;
+}
+
+bool BaseJsonPlugin::processChar(char16_t c, bool atStartOfLine) {
+    (void)atStartOfLine;
+    events_ = 0;
+
+    if (state_ == PluginState::IDLE) {
+        // The Kotlin plugin drops idle characters; here they stay with the
+        // text so the plugin can be skipped over them.
+        if (c != u'{' && c != u'[') {
+            return true;
+        }
+        state_ = PluginState::PROCESSING;
+        pos_ = 1;
+        openContainer(c == u'{' ? kObject : kArray);
+        return !contentOnly_;
+    }
+
+    const int at = pos_++;
+    if (inString_) {
+        if (escaped_) {
+            escaped_ = false;
+            return true;
+        }
+        if (c == u'\\') {
+            escaped_ = true;
+            return !contentOnly_;
+        }
+        if (c == u'"') {
+            inString_ = false;
+            events_ = stringIsKey_ ? kKey : kValue;
+            tokenStart_ = openStart_;
+            tokenEnd_ = at;
+            return !contentOnly_;
+        }
+        return true;
+    }
+
+    if (!isJsonStructural(c)) {
+        if (!inScalar_) {
+            inScalar_ = true;
+            openStart_ = at;
+        }
+        return true;
+    }
+
+    if (inScalar_) {
+        inScalar_ = false;
+        events_ = expectKey_ ? kKey : kValue;
+        tokenStart_ = openStart_;
+        tokenEnd_ = at;
+    }
+
+    switch (c) {
+        case u'"':
+            inString_ = true;
+            stringIsKey_ = expectKey_;
+            openStart_ = at + 1;
+            break;
+        case u'{':
+            openContainer(kObject);
+            break;
+        case u'[':
+            openContainer(kArray);
+            break;
+        case u'}':
+        case u']': {
+            const uint8_t kind = c == u'}' ? kObject : kArray;
+            if (containers_.back() != kind) {
+                break;
+            }
+            containers_.pop_back();
+            events_ |= kind == kObject ? kObjectEnd : kArrayEnd;
+            expectKey_ = false;
+            if (containers_.empty()) {
+                resetInternal();
+            }
+            break;
+        }
+        case u':':
+            expectKey_ = false;
+            break;
+        case u',':
+            expectKey_ = containers_.back() == kObject;
+            break;
+        default:
+            break;
+    }
+    return !contentOnly_;
+}
+
+} // namespace streamnative
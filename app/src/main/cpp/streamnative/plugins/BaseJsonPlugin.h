@@ -1,15 +1,79 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "StreamPlugin.h"
 
 namespace streamnative {
 
+// Recognizes one top-level JSON object or array: '{' or '[' starts it and the
+// matching closer ends it. Nesting, strings and escapes are tracked per
+// character; closers of the other container type are ignored, as in the
+// Kotlin plugin. Besides the plugin contract it reports the structure it
+// saw, which the JSON session turns into segments.
 class BaseJsonPlugin : public StreamPlugin {
 public:
-    PluginState state() const override { return PluginState::IDLE; }
-    bool processChar(char16_t, bool) override { return true; }
-    bool initPlugin() override { return true; }
-    void reset() override {}
+    // Structure finished by the last processChar, in the order the session
+    // emits it: a key or value token, then a container boundary.
+    static constexpr int kKey = 1;
+    static constexpr int kValue = 2;
+    static constexpr int kObjectStart = 4;
+    static constexpr int kObjectEnd = 8;
+    static constexpr int kArrayStart = 16;
+    static constexpr int kArrayEnd = 32;
+
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 1; }
+    bool processChar(char16_t c, bool atStartOfLine) override;
+    bool initPlugin() override;
+    void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) override;
+
+    int lastEvents() const { return events_; }
+
+    // Positions below are relative to the opening '{' or '[' (position 0).
+    // [tokenStart, tokenEnd) is the key or value finished by the last
+    // character: string contents without the quotes, or a bare scalar.
+    int tokenStart() const { return tokenStart_; }
+    int tokenEnd() const { return tokenEnd_; }
+
+    // Characters consumed since the opening one, inclusive.
+    int position() const { return pos_; }
+
+    // Start of the key or value still being read, or -1.
+    int pendingTokenStart() const { return (inString_ || inScalar_) ? openStart_ : -1; }
+
+protected:
+    // `contentOnly` keeps only string contents and scalars on the emitted
+    // side; quotes, escapes, punctuation and whitespace are dropped.
+    explicit BaseJsonPlugin(bool contentOnly);
+
+private:
+    static constexpr uint8_t kObject = 0;
+    static constexpr uint8_t kArray = 1;
+
+    bool contentOnly_;
+    PluginState state_;
+    std::vector<uint8_t> containers_;
+    bool inString_;
+    bool escaped_;
+    bool stringIsKey_;
+    bool inScalar_;
+    bool expectKey_;
+    int pos_;
+    int openStart_;
+    int tokenStart_;
+    int tokenEnd_;
+    int events_;
+
+    void resetInternal();
+    void openContainer(uint8_t kind);
+    bool processStructure(char16_t c);
 };
 
 } // namespace streamnative
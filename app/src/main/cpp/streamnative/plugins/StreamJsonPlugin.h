@@ -4,6 +4,10 @@
 
 namespace streamnative {
 
-class StreamJsonPlugin : public BaseJsonPlugin {};
+// Emits the whole JSON value, punctuation included.
+class StreamJsonPlugin final : public BaseJsonPlugin {
+public:
+    StreamJsonPlugin() : BaseJsonPlugin(false) {}
+};
 
 } // namespace streamnative
@@ -2,6 +2,8 @@
 
 #include <algorithm>
 
+#include "../StringExtensions.h"
+
 namespace streamnative {
 
 namespace {
@@ -40,6 +42,16 @@ struct PrefixMatcher {
 };
 
 inline bool isDigit(char16_t c) { return c >= u'0' && c <= u'9'; }
+
+// Shared bulk path for line-scoped blocks: mid-line body characters are
+// emitted unchanged and only '\n' can end (or continue) the block.
+inline int consumeLineBody(const char16_t* chars, int len, bool& shouldEmit) {
+    const int n = indexOfChar(chars, 0, len, u'\n');
+    if (n > 0) {
+        shouldEmit = true;
+    }
+    return n;
+}
 }
 
 // --- Fenced code block ---
@@ -52,8 +64,6 @@ StreamMarkdownFencedCodeBlockPlugin::StreamMarkdownFencedCodeBlockPlugin(bool in
     reset();
 }
 
-PluginState StreamMarkdownFencedCodeBlockPlugin::state() const { return state_; }
-
 bool StreamMarkdownFencedCodeBlockPlugin::initPlugin() {
     reset();
     return true;
@@ -66,6 +76,34 @@ void StreamMarkdownFencedCodeBlockPlugin::reset() {
     hasStartedMatchingFence_ = false;
 }
 
+void StreamMarkdownFencedCodeBlockPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(fenceLen_);
+    out.writeBool(isMatchingEndFence_);
+    out.writeBool(hasStartedMatchingFence_);
+}
+
+bool StreamMarkdownFencedCodeBlockPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    fenceLen_ = in.readInt();
+    isMatchingEndFence_ = in.readBool();
+    hasStartedMatchingFence_ = in.readBool();
+    return in.ok();
+}
+
+bool StreamMarkdownFencedCodeBlockPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"```");
+    return true;
+}
+
+int StreamMarkdownFencedCodeBlockPlugin::consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+    // Code lines are opaque until the next line start may open the end fence.
+    if (state_ != PluginState::PROCESSING || atStartOfLine || isMatchingEndFence_) {
+        return 0;
+    }
+    return consumeLineBody(chars, len, shouldEmit);
+}
+
 bool StreamMarkdownFencedCodeBlockPlugin::processChar(char16_t c, bool atStartOfLine) {
     if (state_ == PluginState::PROCESSING) {
         if (atStartOfLine) {
@@ -159,8 +197,6 @@ StreamMarkdownInlineCodePlugin::StreamMarkdownInlineCodePlugin(bool includeTicks
     reset();
 }
 
-PluginState StreamMarkdownInlineCodePlugin::state() const { return state_; }
-
 bool StreamMarkdownInlineCodePlugin::initPlugin() {
     reset();
     return true;
@@ -172,6 +208,24 @@ void StreamMarkdownInlineCodePlugin::reset() {
     endMatch_ = 0;
 }
 
+void StreamMarkdownInlineCodePlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(tickLen_);
+    out.writeInt(endMatch_);
+}
+
+bool StreamMarkdownInlineCodePlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    tickLen_ = in.readInt();
+    endMatch_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownInlineCodePlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"`");
+    return true;
+}
+
 bool StreamMarkdownInlineCodePlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::PROCESSING && c == u'\n') {
         reset();
@@ -228,8 +282,6 @@ StreamMarkdownBoldPlugin::StreamMarkdownBoldPlugin(bool includeAsterisks)
     reset();
 }
 
-PluginState StreamMarkdownBoldPlugin::state() const { return state_; }
-
 bool StreamMarkdownBoldPlugin::initPlugin() {
     reset();
     return true;
@@ -241,6 +293,24 @@ void StreamMarkdownBoldPlugin::reset() {
     endMatch_ = 0;
 }
 
+void StreamMarkdownBoldPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(startMatch_);
+    out.writeInt(endMatch_);
+}
+
+bool StreamMarkdownBoldPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    startMatch_ = in.readInt();
+    endMatch_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownBoldPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"**");
+    return true;
+}
+
 bool StreamMarkdownBoldPlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::PROCESSING) {
         if (c == u'*') {
@@ -303,8 +373,6 @@ StreamMarkdownItalicPlugin::StreamMarkdownItalicPlugin(bool includeAsterisks)
     reset();
 }
 
-PluginState StreamMarkdownItalicPlugin::state() const { return state_; }
-
 bool StreamMarkdownItalicPlugin::initPlugin() {
     reset();
     return true;
@@ -318,6 +386,28 @@ void StreamMarkdownItalicPlugin::reset() {
     lastChar_ = 0;
 }
 
+void StreamMarkdownItalicPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(startMatch_);
+    out.writeInt(endMatch_);
+    out.writeChar(lastChar_);
+    out.writeBool(hasLastChar_);
+}
+
+bool StreamMarkdownItalicPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    startMatch_ = in.readInt();
+    endMatch_ = in.readInt();
+    lastChar_ = in.readChar();
+    hasLastChar_ = in.readBool();
+    return in.ok();
+}
+
+bool StreamMarkdownItalicPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"*");
+    return true;
+}
+
 bool StreamMarkdownItalicPlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (hasLastChar_ && lastChar_ == u'*' && c == u'*') {
         // Kotlin special-case to avoid treating ** as italics
@@ -366,8 +456,6 @@ StreamMarkdownHeaderPlugin::StreamMarkdownHeaderPlugin(bool includeMarker)
     reset();
 }
 
-PluginState StreamMarkdownHeaderPlugin::state() const { return state_; }
-
 bool StreamMarkdownHeaderPlugin::initPlugin() {
     reset();
     return true;
@@ -379,6 +467,31 @@ void StreamMarkdownHeaderPlugin::reset() {
     inMatch_ = false;
 }
 
+void StreamMarkdownHeaderPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(hashCount_);
+    out.writeBool(inMatch_);
+}
+
+bool StreamMarkdownHeaderPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    hashCount_ = in.readInt();
+    inMatch_ = in.readBool();
+    return in.ok();
+}
+
+bool StreamMarkdownHeaderPlugin::appendDelimiters(std::vector<std::u16string>& /*out*/) const {
+    // '#' only counts at the start of a line.
+    return true;
+}
+
+int StreamMarkdownHeaderPlugin::consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+    if (state_ != PluginState::PROCESSING || atStartOfLine) {
+        return 0;
+    }
+    return consumeLineBody(chars, len, shouldEmit);
+}
+
 bool StreamMarkdownHeaderPlugin::processChar(char16_t c, bool atStartOfLine) {
     if (state_ == PluginState::PROCESSING) {
         if (c == u'\n') {
@@ -419,8 +532,6 @@ StreamMarkdownLinkPlugin::StreamMarkdownLinkPlugin() : state_(PluginState::IDLE)
     reset();
 }
 
-PluginState StreamMarkdownLinkPlugin::state() const { return state_; }
-
 bool StreamMarkdownLinkPlugin::initPlugin() {
     reset();
     return true;
@@ -431,6 +542,22 @@ void StreamMarkdownLinkPlugin::reset() {
     phase_ = 0;
 }
 
+void StreamMarkdownLinkPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(phase_);
+}
+
+bool StreamMarkdownLinkPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    phase_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownLinkPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"[");
+    return true;
+}
+
 bool StreamMarkdownLinkPlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::IDLE) {
         if (c == u'[') {
@@ -479,8 +606,6 @@ StreamMarkdownBlockQuotePlugin::StreamMarkdownBlockQuotePlugin(bool includeMarke
     reset();
 }
 
-PluginState StreamMarkdownBlockQuotePlugin::state() const { return state_; }
-
 bool StreamMarkdownBlockQuotePlugin::initPlugin() {
     reset();
     return true;
@@ -491,6 +616,29 @@ void StreamMarkdownBlockQuotePlugin::reset() {
     matchIndex_ = 0;
 }
 
+void StreamMarkdownBlockQuotePlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(matchIndex_);
+}
+
+bool StreamMarkdownBlockQuotePlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    matchIndex_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownBlockQuotePlugin::appendDelimiters(std::vector<std::u16string>& /*out*/) const {
+    // '>' only counts at the start of a line.
+    return true;
+}
+
+int StreamMarkdownBlockQuotePlugin::consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+    if (state_ != PluginState::PROCESSING || atStartOfLine) {
+        return 0;
+    }
+    return consumeLineBody(chars, len, shouldEmit);
+}
+
 bool StreamMarkdownBlockQuotePlugin::processChar(char16_t c, bool atStartOfLine) {
     if (c == u'\n') {
         if (state_ == PluginState::PROCESSING) {
@@ -561,8 +709,6 @@ StreamMarkdownHorizontalRulePlugin::StreamMarkdownHorizontalRulePlugin(bool incl
     reset();
 }
 
-PluginState StreamMarkdownHorizontalRulePlugin::state() const { return state_; }
-
 bool StreamMarkdownHorizontalRulePlugin::initPlugin() {
     reset();
     return true;
@@ -575,6 +721,26 @@ void StreamMarkdownHorizontalRulePlugin::reset() {
     markerCount_ = 0;
 }
 
+void StreamMarkdownHorizontalRulePlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeChar(currentMarker_);
+    out.writeBool(hasMarker_);
+    out.writeInt(markerCount_);
+}
+
+bool StreamMarkdownHorizontalRulePlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    currentMarker_ = in.readChar();
+    hasMarker_ = in.readBool();
+    markerCount_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownHorizontalRulePlugin::appendDelimiters(std::vector<std::u16string>& /*out*/) const {
+    // Markers only count at the start of a line.
+    return true;
+}
+
 bool StreamMarkdownHorizontalRulePlugin::processChar(char16_t c, bool atStartOfLine) {
     if (c == u'\n') {
         const bool isMatch = (state_ == PluginState::TRYING || state_ == PluginState::PROCESSING) && markerCount_ >= 3;
@@ -620,8 +786,6 @@ StreamMarkdownOrderedListPlugin::StreamMarkdownOrderedListPlugin(bool includeMar
     reset();
 }
 
-PluginState StreamMarkdownOrderedListPlugin::state() const { return state_; }
-
 bool StreamMarkdownOrderedListPlugin::initPlugin() {
     reset();
     return true;
@@ -632,6 +796,29 @@ void StreamMarkdownOrderedListPlugin::reset() {
     matchState_ = 0;
 }
 
+void StreamMarkdownOrderedListPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(matchState_);
+}
+
+bool StreamMarkdownOrderedListPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    matchState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownOrderedListPlugin::appendDelimiters(std::vector<std::u16string>& /*out*/) const {
+    // Digits only count at the start of a line.
+    return true;
+}
+
+int StreamMarkdownOrderedListPlugin::consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+    if (state_ != PluginState::PROCESSING || atStartOfLine) {
+        return 0;
+    }
+    return consumeLineBody(chars, len, shouldEmit);
+}
+
 bool StreamMarkdownOrderedListPlugin::processChar(char16_t c, bool atStartOfLine) {
     if (state_ == PluginState::PROCESSING) {
         if (c == u'\n') {
@@ -695,8 +882,6 @@ StreamMarkdownUnorderedListPlugin::StreamMarkdownUnorderedListPlugin(bool includ
     reset();
 }
 
-PluginState StreamMarkdownUnorderedListPlugin::state() const { return state_; }
-
 bool StreamMarkdownUnorderedListPlugin::initPlugin() {
     reset();
     return true;
@@ -707,6 +892,29 @@ void StreamMarkdownUnorderedListPlugin::reset() {
     matchState_ = 0;
 }
 
+void StreamMarkdownUnorderedListPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(matchState_);
+}
+
+bool StreamMarkdownUnorderedListPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    matchState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownUnorderedListPlugin::appendDelimiters(std::vector<std::u16string>& /*out*/) const {
+    // Bullets only count at the start of a line.
+    return true;
+}
+
+int StreamMarkdownUnorderedListPlugin::consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+    if (state_ != PluginState::PROCESSING || atStartOfLine) {
+        return 0;
+    }
+    return consumeLineBody(chars, len, shouldEmit);
+}
+
 bool StreamMarkdownUnorderedListPlugin::processChar(char16_t c, bool atStartOfLine) {
     if (state_ == PluginState::PROCESSING) {
         if (c == u'\n') {
@@ -755,8 +963,6 @@ StreamMarkdownStrikethroughPlugin::StreamMarkdownStrikethroughPlugin(bool includ
     reset();
 }
 
-PluginState StreamMarkdownStrikethroughPlugin::state() const { return state_; }
-
 bool StreamMarkdownStrikethroughPlugin::initPlugin() {
     reset();
     return true;
@@ -768,6 +974,24 @@ void StreamMarkdownStrikethroughPlugin::reset() {
     endState_ = 0;
 }
 
+void StreamMarkdownStrikethroughPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(startState_);
+    out.writeInt(endState_);
+}
+
+bool StreamMarkdownStrikethroughPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    startState_ = in.readInt();
+    endState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownStrikethroughPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"~~");
+    return true;
+}
+
 bool StreamMarkdownStrikethroughPlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::PROCESSING) {
         // end matcher for "~~"
@@ -831,8 +1055,6 @@ StreamMarkdownUnderlinePlugin::StreamMarkdownUnderlinePlugin(bool includeDelimit
     reset();
 }
 
-PluginState StreamMarkdownUnderlinePlugin::state() const { return state_; }
-
 bool StreamMarkdownUnderlinePlugin::initPlugin() {
     reset();
     return true;
@@ -844,6 +1066,24 @@ void StreamMarkdownUnderlinePlugin::reset() {
     endState_ = 0;
 }
 
+void StreamMarkdownUnderlinePlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(startState_);
+    out.writeInt(endState_);
+}
+
+bool StreamMarkdownUnderlinePlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    startState_ = in.readInt();
+    endState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownUnderlinePlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"__");
+    return true;
+}
+
 bool StreamMarkdownUnderlinePlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::PROCESSING) {
         if (endState_ == 0) {
@@ -904,8 +1144,6 @@ StreamMarkdownInlineLaTeXPlugin::StreamMarkdownInlineLaTeXPlugin(bool includeDel
     reset();
 }
 
-PluginState StreamMarkdownInlineLaTeXPlugin::state() const { return state_; }
-
 bool StreamMarkdownInlineLaTeXPlugin::initPlugin() {
     reset();
     return true;
@@ -917,6 +1155,24 @@ void StreamMarkdownInlineLaTeXPlugin::reset() {
     endState_ = 0;
 }
 
+void StreamMarkdownInlineLaTeXPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(startState_);
+    out.writeInt(endState_);
+}
+
+bool StreamMarkdownInlineLaTeXPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    startState_ = in.readInt();
+    endState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownInlineLaTeXPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"$");
+    return true;
+}
+
 bool StreamMarkdownInlineLaTeXPlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::PROCESSING) {
         if (endState_ == 0) {
@@ -960,8 +1216,6 @@ StreamMarkdownInlineParenLaTeXPlugin::StreamMarkdownInlineParenLaTeXPlugin(bool
     reset();
 }
 
-PluginState StreamMarkdownInlineParenLaTeXPlugin::state() const { return state_; }
-
 bool StreamMarkdownInlineParenLaTeXPlugin::initPlugin() {
     reset();
     return true;
@@ -973,6 +1227,24 @@ void StreamMarkdownInlineParenLaTeXPlugin::reset() {
     endState_ = 0;
 }
 
+void StreamMarkdownInlineParenLaTeXPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(startState_);
+    out.writeInt(endState_);
+}
+
+bool StreamMarkdownInlineParenLaTeXPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    startState_ = in.readInt();
+    endState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownInlineParenLaTeXPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"\\(");
+    return true;
+}
+
 bool StreamMarkdownInlineParenLaTeXPlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::PROCESSING) {
         if (endState_ == 0) {
@@ -1033,8 +1305,6 @@ StreamMarkdownBlockLaTeXPlugin::StreamMarkdownBlockLaTeXPlugin(bool includeDelim
     reset();
 }
 
-PluginState StreamMarkdownBlockLaTeXPlugin::state() const { return state_; }
-
 bool StreamMarkdownBlockLaTeXPlugin::initPlugin() {
     reset();
     return true;
@@ -1046,6 +1316,24 @@ void StreamMarkdownBlockLaTeXPlugin::reset() {
     endState_ = 0;
 }
 
+void StreamMarkdownBlockLaTeXPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(startState_);
+    out.writeInt(endState_);
+}
+
+bool StreamMarkdownBlockLaTeXPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    startState_ = in.readInt();
+    endState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownBlockLaTeXPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"$$");
+    return true;
+}
+
 bool StreamMarkdownBlockLaTeXPlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::PROCESSING) {
         if (endState_ == 0) {
@@ -1096,8 +1384,6 @@ StreamMarkdownBlockBracketLaTeXPlugin::StreamMarkdownBlockBracketLaTeXPlugin(boo
     reset();
 }
 
-PluginState StreamMarkdownBlockBracketLaTeXPlugin::state() const { return state_; }
-
 bool StreamMarkdownBlockBracketLaTeXPlugin::initPlugin() {
     reset();
     return true;
@@ -1109,6 +1395,24 @@ void StreamMarkdownBlockBracketLaTeXPlugin::reset() {
     endState_ = 0;
 }
 
+void StreamMarkdownBlockBracketLaTeXPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(startState_);
+    out.writeInt(endState_);
+}
+
+bool StreamMarkdownBlockBracketLaTeXPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    startState_ = in.readInt();
+    endState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownBlockBracketLaTeXPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"\\[");
+    return true;
+}
+
 bool StreamMarkdownBlockBracketLaTeXPlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::PROCESSING) {
         if (endState_ == 0) {
@@ -1159,8 +1463,6 @@ StreamMarkdownImagePlugin::StreamMarkdownImagePlugin(bool includeDelimiters)
     reset();
 }
 
-PluginState StreamMarkdownImagePlugin::state() const { return state_; }
-
 bool StreamMarkdownImagePlugin::initPlugin() {
     reset();
     return true;
@@ -1171,6 +1473,22 @@ void StreamMarkdownImagePlugin::reset() {
     phase_ = 0;
 }
 
+void StreamMarkdownImagePlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(phase_);
+}
+
+bool StreamMarkdownImagePlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    phase_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownImagePlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"![");
+    return true;
+}
+
 bool StreamMarkdownImagePlugin::processChar(char16_t c, bool /*atStartOfLine*/) {
     if (state_ == PluginState::IDLE) {
         if (c == u'!') {
@@ -1233,8 +1551,6 @@ StreamMarkdownTablePlugin::StreamMarkdownTablePlugin(bool includeDelimiters)
     reset();
 }
 
-PluginState StreamMarkdownTablePlugin::state() const { return state_; }
-
 bool StreamMarkdownTablePlugin::initPlugin() {
     reset();
     return true;
@@ -1247,6 +1563,26 @@ void StreamMarkdownTablePlugin::reset() {
     headerSepMatchState_ = 0;
 }
 
+void StreamMarkdownTablePlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(tableRowCount_);
+    out.writeBool(foundHeaderSeparator_);
+    out.writeInt(headerSepMatchState_);
+}
+
+bool StreamMarkdownTablePlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    tableRowCount_ = in.readInt();
+    foundHeaderSeparator_ = in.readBool();
+    headerSepMatchState_ = in.readInt();
+    return in.ok();
+}
+
+bool StreamMarkdownTablePlugin::appendDelimiters(std::vector<std::u16string>& /*out*/) const {
+    // '|' only opens a table at the start of a line.
+    return true;
+}
+
 bool StreamMarkdownTablePlugin::processChar(char16_t c, bool atStartOfLine) {
     if (c == u'\n') {
         if (state_ == PluginState::PROCESSING) {
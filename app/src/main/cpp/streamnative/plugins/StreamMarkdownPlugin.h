@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "StreamPlugin.h"
 
@@ -10,10 +11,14 @@ class StreamMarkdownFencedCodeBlockPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownFencedCodeBlockPlugin(bool includeFences = true);
 
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) override;
 
 private:
     bool includeFences_;
@@ -27,10 +32,14 @@ class StreamMarkdownInlineCodePlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownInlineCodePlugin(bool includeTicks = true);
 
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 2; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeTicks_;
@@ -42,10 +51,14 @@ private:
 class StreamMarkdownBoldPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownBoldPlugin(bool includeAsterisks = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 3; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeAsterisks_;
@@ -57,10 +70,14 @@ private:
 class StreamMarkdownItalicPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownItalicPlugin(bool includeAsterisks = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 2; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeAsterisks_;
@@ -74,10 +91,14 @@ private:
 class StreamMarkdownHeaderPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownHeaderPlugin(bool includeMarker = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) override;
 
 private:
     bool includeMarker_;
@@ -89,10 +110,13 @@ private:
 class StreamMarkdownLinkPlugin final : public StreamPlugin {
 public:
     StreamMarkdownLinkPlugin();
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     PluginState state_;
@@ -102,10 +126,15 @@ private:
 class StreamMarkdownBlockQuotePlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownBlockQuotePlugin(bool includeMarker = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 2; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) override;
 
 private:
     bool includeMarker_;
@@ -116,10 +145,13 @@ private:
 class StreamMarkdownHorizontalRulePlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownHorizontalRulePlugin(bool includeMarker = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeMarker_;
@@ -132,10 +164,14 @@ private:
 class StreamMarkdownOrderedListPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownOrderedListPlugin(bool includeMarker = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) override;
 
 private:
     bool includeMarker_;
@@ -146,10 +182,15 @@ private:
 class StreamMarkdownUnorderedListPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownUnorderedListPlugin(bool includeMarker = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 2; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) override;
 
 private:
     bool includeMarker_;
@@ -160,10 +201,14 @@ private:
 class StreamMarkdownStrikethroughPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownStrikethroughPlugin(bool includeDelimiters = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 3; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeDelimiters_;
@@ -175,10 +220,14 @@ private:
 class StreamMarkdownUnderlinePlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownUnderlinePlugin(bool includeDelimiters = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 3; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeDelimiters_;
@@ -190,10 +239,14 @@ private:
 class StreamMarkdownInlineLaTeXPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownInlineLaTeXPlugin(bool includeDelimiters = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 2; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeDelimiters_;
@@ -205,10 +258,14 @@ private:
 class StreamMarkdownInlineParenLaTeXPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownInlineParenLaTeXPlugin(bool includeDelimiters = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 3; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeDelimiters_;
@@ -220,10 +277,14 @@ private:
 class StreamMarkdownBlockLaTeXPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownBlockLaTeXPlugin(bool includeDelimiters = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 2; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeDelimiters_;
@@ -235,10 +296,14 @@ private:
 class StreamMarkdownBlockBracketLaTeXPlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownBlockBracketLaTeXPlugin(bool includeDelimiters = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
+    int maxLookahead() const override { return 2; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeDelimiters_;
@@ -250,10 +315,13 @@ private:
 class StreamMarkdownImagePlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownImagePlugin(bool includeDelimiters = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeDelimiters_;
@@ -264,10 +332,13 @@ private:
 class StreamMarkdownTablePlugin final : public StreamPlugin {
 public:
     explicit StreamMarkdownTablePlugin(bool includeDelimiters = true);
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
 
 private:
     bool includeDelimiters_;
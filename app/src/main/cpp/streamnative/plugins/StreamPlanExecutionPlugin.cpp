@@ -1,5 +1,7 @@
 #include "StreamPlanExecutionPlugin.h"
 
+#include "../StringExtensions.h"
+
 namespace streamnative {
 
 StreamPlanExecutionPlugin::StreamPlanExecutionPlugin(bool includeTagsInOutput)
@@ -14,10 +16,6 @@ StreamPlanExecutionPlugin::StreamPlanExecutionPlugin(bool includeTagsInOutput)
     reset();
 }
 
-PluginState StreamPlanExecutionPlugin::state() const {
-    return state_;
-}
-
 bool StreamPlanExecutionPlugin::initPlugin() {
     reset();
     return true;
@@ -34,6 +32,41 @@ void StreamPlanExecutionPlugin::reset() {
     resetInternal();
 }
 
+void StreamPlanExecutionPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeBool(allowStartAfterEndTag_);
+    out.writeInt(static_cast<int>(startState_));
+    out.writeInt(startMatchIndex_);
+    endMatcher_.saveState(out);
+}
+
+bool StreamPlanExecutionPlugin::restoreState(SnapshotReader& in) {
+    state_ = readPluginState(in);
+    allowStartAfterEndTag_ = in.readBool();
+    startState_ = static_cast<StartState>(in.readInt(0, static_cast<int>(StartState::MATCHING)));
+    // Indexes the "<plan" literal while below 5.
+    startMatchIndex_ = in.readInt(0, 5);
+    endMatcher_.restoreState(in);
+    return in.ok();
+}
+
+bool StreamPlanExecutionPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"<plan");
+    return true;
+}
+
+int StreamPlanExecutionPlugin::consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+    (void)atStartOfLine;
+    if (state_ != PluginState::PROCESSING || !endInited_ || endMatcher_.inProgress()) {
+        return 0;
+    }
+    const int n = indexOfChar(chars, 0, len, u'<');
+    if (n > 0) {
+        shouldEmit = true;
+    }
+    return n;
+}
+
 bool StreamPlanExecutionPlugin::processChar(char16_t c, bool atStartOfLine) {
     (void)atStartOfLine;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "../StreamKmpGraph.h"
 #include "StreamPlugin.h"
@@ -11,10 +12,14 @@ class StreamPlanExecutionPlugin final : public StreamPlugin {
 public:
     explicit StreamPlanExecutionPlugin(bool includeTagsInOutput = true);
 
-    PluginState state() const override;
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) override;
 
 private:
     bool includeTagsInOutput_;
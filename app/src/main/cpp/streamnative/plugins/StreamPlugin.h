@@ -1,7 +1,17 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
+#include "../StreamSnapshot.h"
+
 namespace streamnative {
 
+// Lookahead declared by plugins whose start attempt may run to the end of the
+// line (fence info strings, link text, start tags, ...). Only a sizing hint:
+// sessions hold such attempts up to their attempt limit instead.
+constexpr int kLineLookahead = 256;
+
 enum class PluginState {
     IDLE,
     TRYING,
@@ -9,6 +19,14 @@ enum class PluginState {
     WAITFOR,
 };
 
+inline void writePluginState(SnapshotWriter& out, PluginState state) {
+    out.writeInt(static_cast<int32_t>(state));
+}
+
+inline PluginState readPluginState(SnapshotReader& in) {
+    return static_cast<PluginState>(in.readInt(0, static_cast<int>(PluginState::WAITFOR)));
+}
+
 class StreamPlugin {
 public:
     virtual ~StreamPlugin() = default;
@@ -16,6 +34,49 @@ public:
     virtual bool processChar(char16_t c, bool atStartOfLine) = 0;
     virtual bool initPlugin() = 0;
     virtual void reset() = 0;
+
+    // Writes what a session checkpoint needs to resume this plugin
+    // mid-stream; construction options are not included. restoreState reads
+    // it back into a plugin built with the same options and returns false on
+    // malformed input.
+    virtual void saveState(SnapshotWriter& out) const = 0;
+    virtual bool restoreState(SnapshotReader& in) = 0;
+
+    // Most characters this plugin keeps TRYING (or WAITFOR) from the first
+    // one of an attempt up to the one that commits or rejects it. Sessions
+    // size their lookahead buffers from it and abandon attempts that run
+    // longer; kLineLookahead and above are capped by the session instead.
+    virtual int maxLookahead() const { return kLineLookahead; }
+
+    // Appends the delimiters that open this plugin's constructs mid-line
+    // ("**", "<plan", ...). While IDLE the plugin only has to see characters
+    // that start one of them; '\n' and line starts always reach it. Returns
+    // false if the plugin cannot tell, in which case it sees every character.
+    virtual bool appendDelimiters(std::vector<std::u16string>& out) const {
+        (void)out;
+        return false;
+    }
+
+    // Called instead of processChar, while the plugin is IDLE, for characters
+    // that start none of its delimiters (no '\n', not at start of line).
+    // Plugins that keep history across idle characters update it here.
+    virtual void skipInertRun(const char16_t* chars, int len) {
+        (void)chars;
+        (void)len;
+    }
+
+    // Bulk path while PROCESSING: consumes the leading characters of
+    // chars[0, len) that cannot change state, exactly as processChar would
+    // have, and returns how many. `atStartOfLine` applies to chars[0];
+    // `shouldEmit` receives the emit flag shared by the consumed run. Returns
+    // 0 when the next character has to go through processChar.
+    virtual int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+        (void)chars;
+        (void)len;
+        (void)atStartOfLine;
+        (void)shouldEmit;
+        return 0;
+    }
 };
 
 } // namespace streamnative
@@ -4,6 +4,10 @@
 
 namespace streamnative {
 
-class StreamPureJsonPlugin : public BaseJsonPlugin {};
+// Emits only string contents and scalars of the JSON value.
+class StreamPureJsonPlugin final : public BaseJsonPlugin {
+public:
+    StreamPureJsonPlugin() : BaseJsonPlugin(true) {}
+};
 
 } // namespace streamnative
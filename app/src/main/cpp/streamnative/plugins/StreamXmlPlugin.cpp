@@ -1,9 +1,13 @@
 #include "StreamXmlPlugin.h"
 
+#include "../StringExtensions.h"
+
 namespace streamnative {
 
-StreamXmlPlugin::StreamXmlPlugin(bool includeTagsInOutput)
+StreamXmlPlugin::StreamXmlPlugin(bool includeTagsInOutput, bool trackNesting, bool indexTags)
         : includeTagsInOutput_(includeTagsInOutput),
+          trackNesting_(trackNesting),
+          indexTags_(indexTags),
           state_(PluginState::IDLE),
           startState_(StartState::WAIT_LT),
           allowStartAfterEndTag_(false),
@@ -12,10 +16,6 @@ StreamXmlPlugin::StreamXmlPlugin(bool includeTagsInOutput)
     reset();
 }
 
-PluginState StreamXmlPlugin::state() const {
-    return state_;
-}
-
 bool StreamXmlPlugin::initPlugin() {
     reset();
     return true;
@@ -26,9 +26,98 @@ void StreamXmlPlugin::reset() {
     startState_ = StartState::WAIT_LT;
     tagName_.clear();
     endMatcher_.reset();
+    openMatcher_.reset();
     endPattern_.clear();
     haveEndPattern_ = false;
+    nestState_ = NestState::NONE;
+    depth_ = 0;
     lastChar_ = 0;
+    // index_ stays until the next start tag, for takeIndex after the end tag.
+    attrState_ = AttrState::BETWEEN;
+    childState_ = ChildState::BODY;
+    childEndMatcher_.reset();
+}
+
+void StreamXmlPlugin::saveState(SnapshotWriter& out) const {
+    writePluginState(out, state_);
+    out.writeInt(static_cast<int>(startState_));
+    out.writeBool(allowStartAfterEndTag_);
+    out.writeBool(allowStartAfterPunctuation_);
+    out.writeString(tagName_);
+    out.writeBool(haveEndPattern_);
+    endMatcher_.saveState(out);
+    openMatcher_.saveState(out);
+    out.writeInt(static_cast<int>(nestState_));
+    out.writeInt(depth_);
+    out.writeChar(lastChar_);
+}
+
+bool StreamXmlPlugin::restoreState(SnapshotReader& in) {
+    reset();
+    state_ = readPluginState(in);
+    startState_ = static_cast<StartState>(in.readInt(0, static_cast<int>(StartState::IN_ATTRS)));
+    allowStartAfterEndTag_ = in.readBool();
+    allowStartAfterPunctuation_ = in.readBool();
+    in.readString(tagName_);
+    if (in.readBool()) {
+        buildEndPattern();
+    }
+    endMatcher_.restoreState(in);
+    openMatcher_.restoreState(in);
+    nestState_ = static_cast<NestState>(in.readInt(0, static_cast<int>(NestState::IN_ATTRS)));
+    depth_ = in.readInt(0, INT32_MAX);
+    lastChar_ = in.readChar();
+    return in.ok();
+}
+
+bool StreamXmlPlugin::appendDelimiters(std::vector<std::u16string>& out) const {
+    out.emplace_back(u"<");
+    return true;
+}
+
+void StreamXmlPlugin::skipInertRun(const char16_t* chars, int len) {
+    // Idle characters only steer the start allowances: blanks keep them, any
+    // other character clears them unless it is a punctuation trigger.
+    for (int i = len - 1; i >= 0; i--) {
+        const char16_t c = chars[i];
+        if (c == u' ' || c == u'\t') {
+            continue;
+        }
+        allowStartAfterEndTag_ = false;
+        allowStartAfterPunctuation_ = isPunctuationTrigger(c);
+        break;
+    }
+    if (len > 0) {
+        lastChar_ = chars[len - 1];
+    }
+    pos_ += len;
+}
+
+int StreamXmlPlugin::consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) {
+    (void)atStartOfLine;
+    // Body characters only matter once they can start or extend "</tag>"
+    // (or, when nesting is tracked, "<tag" and its attributes).
+    if (state_ != PluginState::PROCESSING || !haveEndPattern_ || endMatcher_.inProgress() ||
+        openMatcher_.inProgress() || nestState_ != NestState::NONE) {
+        return 0;
+    }
+    // The indexer reads child start tags and child end tags whole.
+    if (childEndMatcher_.inProgress() ||
+        (childState_ != ChildState::BODY && childState_ != ChildState::CONTENT)) {
+        return 0;
+    }
+    const int n = indexOfChar(chars, 0, len, endMatcher_.firstChar());
+    if (n > 0) {
+        lastChar_ = chars[n - 1];
+        shouldEmit = includeTagsInOutput_;
+        pos_ += n;
+    }
+    return n;
+}
+
+void StreamXmlPlugin::takeIndex(std::vector<Segment>& out) {
+    out.insert(out.end(), index_.begin(), index_.end());
+    index_.clear();
 }
 
 bool StreamXmlPlugin::isAsciiLetter(char16_t c) {
@@ -73,6 +162,7 @@ bool StreamXmlPlugin::processStartMatcher(char16_t c) {
         case StartState::WAIT_LT: {
             if (c == u'<') {
                 tagName_.clear();
+                index_.clear();
                 startState_ = StartState::WAIT_FIRST_LETTER;
                 state_ = PluginState::TRYING;
             }
@@ -81,6 +171,7 @@ bool StreamXmlPlugin::processStartMatcher(char16_t c) {
         case StartState::WAIT_FIRST_LETTER: {
             if (isAsciiLetter(c)) {
                 tagName_.push_back(c);
+                nameStart_ = pos_;
                 startState_ = StartState::IN_TAG_NAME;
                 state_ = PluginState::TRYING;
                 return false;
@@ -90,6 +181,10 @@ bool StreamXmlPlugin::processStartMatcher(char16_t c) {
             return false;
         }
         case StartState::IN_TAG_NAME: {
+            if (indexTags_ && (c == u' ' || c == u'>')) {
+                index_.push_back({kIndexTag, nameStart_, pos_});
+                attrState_ = AttrState::BETWEEN;
+            }
             if (c == u' ') {
                 startState_ = StartState::IN_ATTRS;
                 state_ = PluginState::TRYING;
@@ -105,6 +200,9 @@ bool StreamXmlPlugin::processStartMatcher(char16_t c) {
             return false;
         }
         case StartState::IN_ATTRS: {
+            if (indexTags_) {
+                scanAttribute(c);
+            }
             if (c == u'>') {
                 startState_ = StartState::WAIT_LT;
                 state_ = PluginState::TRYING;
@@ -121,6 +219,11 @@ void StreamXmlPlugin::buildEndPattern() {
     endPattern_.clear();
     endPattern_.reserve(tagName_.size() + 3);
     endPattern_.push_back(u'<');
+    if (trackNesting_) {
+        endPattern_.append(tagName_);
+        openMatcher_.setPattern(endPattern_);
+        endPattern_.resize(1);
+    }
     endPattern_.push_back(u'/');
     endPattern_.append(tagName_);
     endPattern_.push_back(u'>');
@@ -128,16 +231,167 @@ void StreamXmlPlugin::buildEndPattern() {
     haveEndPattern_ = true;
 }
 
+// Counts `<tag>` and `<tag ...>` inside the body, not `<tag/>` or `<tagx>`,
+// the same openings processStartMatcher accepts.
+void StreamXmlPlugin::trackNestedOpen(char16_t c, char16_t prevChar) {
+    switch (nestState_) {
+        case NestState::NAME_MATCHED:
+            if (c == u'>') {
+                depth_++;
+            }
+            nestState_ = c == u' ' ? NestState::IN_ATTRS : NestState::NONE;
+            break;
+        case NestState::IN_ATTRS:
+            if (c == u'>') {
+                if (prevChar != u'/') {
+                    depth_++;
+                }
+                nestState_ = NestState::NONE;
+            }
+            break;
+        case NestState::NONE:
+            break;
+    }
+    if (openMatcher_.process(c)) {
+        nestState_ = NestState::NAME_MATCHED;
+    }
+}
+
+// Attribute names and values of a start tag, one character at a time; the
+// caller ends the tag at '>'.
+void StreamXmlPlugin::scanAttribute(char16_t c) {
+    const bool blank = c == u' ' || c == u'\t' || c == u'\n' || c == u'\r';
+    switch (attrState_) {
+        case AttrState::BETWEEN:
+        case AttrState::AFTER_NAME:
+            if (c == u'=' && attrState_ == AttrState::AFTER_NAME) {
+                attrState_ = AttrState::BEFORE_VALUE;
+            } else if (!blank && c != u'/' && c != u'>') {
+                attrStart_ = pos_;
+                attrState_ = AttrState::NAME;
+            } else if (!blank) {
+                attrState_ = AttrState::BETWEEN;
+            }
+            break;
+        case AttrState::NAME:
+            if (c == u'=' || blank || c == u'/' || c == u'>') {
+                index_.push_back({kIndexAttrName, attrStart_, pos_});
+                attrState_ = c == u'=' ? AttrState::BEFORE_VALUE : blank ? AttrState::AFTER_NAME : AttrState::BETWEEN;
+            }
+            break;
+        case AttrState::BEFORE_VALUE:
+            if (c == u'"' || c == u'\'') {
+                quote_ = c;
+                attrStart_ = pos_ + 1;
+                attrState_ = AttrState::QUOTED_VALUE;
+            } else if (c == u'>') {
+                attrState_ = AttrState::BETWEEN;
+            } else if (!blank) {
+                attrStart_ = pos_;
+                attrState_ = AttrState::BARE_VALUE;
+            }
+            break;
+        case AttrState::QUOTED_VALUE:
+            if (c == quote_) {
+                index_.push_back({kIndexAttrValue, attrStart_, pos_});
+                attrState_ = AttrState::BETWEEN;
+            }
+            break;
+        case AttrState::BARE_VALUE:
+            if (blank || c == u'>') {
+                index_.push_back({kIndexAttrValue, attrStart_, pos_});
+                attrState_ = AttrState::BETWEEN;
+            }
+            break;
+    }
+}
+
+// Direct children of the tag: `<name attrs>content</name>` or `<name/>`.
+// Tags inside a child's content are part of that content.
+void StreamXmlPlugin::indexChild(char16_t c, char16_t prevChar) {
+    auto openContent = [&]() {
+        childEndPattern_.insert(0, u"</");
+        childEndPattern_.push_back(u'>');
+        childEndMatcher_.setPattern(childEndPattern_);
+        childStart_ = pos_ + 1;
+        childState_ = ChildState::CONTENT;
+    };
+    switch (childState_) {
+        case ChildState::BODY:
+            if (c == u'<') {
+                childState_ = ChildState::LT;
+            }
+            break;
+        case ChildState::LT:
+            if (isAsciiLetter(c)) {
+                childStart_ = pos_;
+                childEndPattern_.assign(1, c);
+                childState_ = ChildState::NAME;
+            } else if (c != u'<') {
+                childState_ = ChildState::BODY;
+            }
+            break;
+        case ChildState::NAME:
+            if (c == u'>' || c == u' ' || c == u'\t' || c == u'\n' || c == u'/') {
+                index_.push_back({kIndexChild, childStart_, pos_});
+                if (c == u'>') {
+                    openContent();
+                } else {
+                    attrState_ = AttrState::BETWEEN;
+                    childState_ = ChildState::ATTRS;
+                }
+            } else if (isAsciiLetter(c) || (c >= u'0' && c <= u'9') || c == u'_' || c == u'-' || c == u':' ||
+                       c == u'.') {
+                childEndPattern_.push_back(c);
+            } else {
+                childState_ = c == u'<' ? ChildState::LT : ChildState::BODY;
+            }
+            break;
+        case ChildState::ATTRS:
+            if (c == u'>' && attrState_ != AttrState::QUOTED_VALUE) {
+                scanAttribute(c);
+                if (prevChar == u'/') {
+                    childState_ = ChildState::BODY;
+                } else {
+                    openContent();
+                }
+            } else {
+                scanAttribute(c);
+            }
+            break;
+        case ChildState::CONTENT:
+            if (childEndMatcher_.process(c)) {
+                index_.push_back({kIndexChildContent, childStart_, pos_ + 1 - static_cast<int>(childEndPattern_.size())});
+                childState_ = ChildState::BODY;
+            }
+            break;
+    }
+}
+
 bool StreamXmlPlugin::processChar(char16_t c, bool atStartOfLine) {
     const char16_t prevChar = lastChar_;
     auto finish = [&](bool result) {
         lastChar_ = c;
+        pos_++;
         return result;
     };
 
     if (state_ == PluginState::PROCESSING) {
         if (haveEndPattern_) {
+            if (trackNesting_) {
+                trackNestedOpen(c, prevChar);
+            }
+            if (indexTags_) {
+                indexChild(c, prevChar);
+            }
             if (endMatcher_.process(c)) {
+                if (depth_ > 0) {
+                    depth_--;
+                    return finish(includeTagsInOutput_);
+                }
+                if (indexTags_) {
+                    index_.push_back({kIndexContent, contentStart_, pos_ + 1 - static_cast<int>(endPattern_.size())});
+                }
                 allowStartAfterEndTag_ = true;
                 allowStartAfterPunctuation_ = false;
                 reset();
@@ -169,6 +423,7 @@ bool StreamXmlPlugin::processChar(char16_t c, bool atStartOfLine) {
         state_ = PluginState::PROCESSING;
         allowStartAfterEndTag_ = false;
         allowStartAfterPunctuation_ = false;
+        contentStart_ = pos_ + 1;
         buildEndPattern();
         startState_ = StartState::WAIT_LT;
         return finish(includeTagsInOutput_);
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
+#include "../StreamGroup.h"
 #include "../StreamKmpGraph.h"
 #include "StreamPlugin.h"
 
@@ -9,12 +11,38 @@ namespace streamnative {
 
 class StreamXmlPlugin final : public StreamPlugin {
 public:
-    explicit StreamXmlPlugin(bool includeTagsInOutput = true);
+    // Kinds of index entries; XML_INDEX_* in StreamOperators.h mirror them.
+    static constexpr int kIndexTag = 0;
+    static constexpr int kIndexAttrName = 1;
+    static constexpr int kIndexAttrValue = 2;
+    static constexpr int kIndexChild = 3;
+    static constexpr int kIndexChildContent = 4;
+    static constexpr int kIndexContent = 5;
 
-    PluginState state() const override;
+    // With trackNesting, a `<tag>` opened inside the body of the same tag
+    // must be closed before `</tag>` ends the outer one; otherwise the first
+    // `</tag>` ends it. With indexTags, the plugin records offsets of the
+    // tag's name, attributes and direct children as it reads them (see
+    // takeIndex); offsets count every character handed to the plugin.
+    explicit StreamXmlPlugin(bool includeTagsInOutput = true, bool trackNesting = false, bool indexTags = false);
+
+    PluginState state() const override { return state_; }
     bool processChar(char16_t c, bool atStartOfLine) override;
     bool initPlugin() override;
     void reset() override;
+    void saveState(SnapshotWriter& out) const override;
+    bool restoreState(SnapshotReader& in) override;
+    bool appendDelimiters(std::vector<std::u16string>& out) const override;
+    void skipInertRun(const char16_t* chars, int len) override;
+    int consumeUntilCandidate(const char16_t* chars, int len, bool atStartOfLine, bool& shouldEmit) override;
+
+    // Appends the index entries of the tag read last and clears them: the
+    // tag name, then each attribute name and value (quotes stripped), then
+    // per direct child element its name, attributes and, once its end tag
+    // has been read, its content; the tag's own content comes last if its
+    // end tag has been read. Only meaningful with indexTags, when the tag
+    // has just ended or is still open. Index state is not part of saveState.
+    void takeIndex(std::vector<Segment>& out);
 
 private:
     enum class StartState {
@@ -24,7 +52,34 @@ private:
         IN_ATTRS,
     };
 
+    // Progress through a nested `<tag` while PROCESSING.
+    enum class NestState {
+        NONE,
+        NAME_MATCHED,
+        IN_ATTRS,
+    };
+
+    // Where the indexer is in the tag's body.
+    enum class ChildState {
+        BODY,
+        LT,
+        NAME,
+        ATTRS,
+        CONTENT,
+    };
+
+    enum class AttrState {
+        BETWEEN,
+        NAME,
+        AFTER_NAME,
+        BEFORE_VALUE,
+        QUOTED_VALUE,
+        BARE_VALUE,
+    };
+
     bool includeTagsInOutput_;
+    bool trackNesting_;
+    bool indexTags_;
     PluginState state_;
     StartState startState_;
 
@@ -35,12 +90,31 @@ private:
     std::u16string endPattern_;
     bool haveEndPattern_;
     KmpMatcher endMatcher_;
+    KmpMatcher openMatcher_; // "<tag", with trackNesting_
+    NestState nestState_ = NestState::NONE;
+    int depth_ = 0; // nested same-name tags still open
     char16_t lastChar_ = 0;
 
+    // Index state, with indexTags_.
+    int pos_ = 0; // offset of the character being processed
+    std::vector<Segment> index_;
+    int nameStart_ = 0;
+    int contentStart_ = 0;
+    AttrState attrState_ = AttrState::BETWEEN;
+    int attrStart_ = 0;
+    char16_t quote_ = 0;
+    ChildState childState_ = ChildState::BODY;
+    std::u16string childEndPattern_;
+    KmpMatcher childEndMatcher_;
+    int childStart_ = 0;
+
     bool handleDefaultCharacter(char16_t c);
     void updatePunctuationAllowance(char16_t c);
     bool processStartMatcher(char16_t c);
     void buildEndPattern();
+    void trackNestedOpen(char16_t c, char16_t prevChar);
+    void scanAttribute(char16_t c);
+    void indexChild(char16_t c, char16_t prevChar);
 
     static bool isAsciiLetter(char16_t c);
     static bool isPunctuationTrigger(char16_t c);
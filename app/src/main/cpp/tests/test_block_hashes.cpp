@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "streamnative/MarkdownParser.h"
+#include "streamnative/MarkdownTypes.h"
+#include "streamnative/StringExtensions.h"
+#include "tests.h"
+
+using namespace harness;
+
+namespace {
+
+// The hashes of a session's SEG_BLOCK_HASH segments, in order. Sets `ok` to
+// false if a block session's hash is not that of the non-plain runs since
+// the previous one.
+std::vector<uint64_t> pushBlockHashes(SessionFactory createSession, const std::u16string& text,
+                                      const std::vector<Chunk>& chunks, bool& ok) {
+    streamnative::MarkdownSession* session = createSession();
+    std::vector<uint64_t> hashes;
+    std::u16string group;
+    for (const auto& chunk : chunks) {
+        for (const auto& seg : streamnative::markdownSessionPush(session, text.data() + chunk.start, chunk.len)) {
+            if (seg.type == streamnative::SEG_BLOCK_HASH) {
+                const uint64_t hash = static_cast<uint32_t>(seg.start) | (static_cast<uint64_t>(static_cast<uint32_t>(seg.end)) << 32);
+                hashes.push_back(hash);
+                ok = ok && (createSession != &createHashedBlockSession ||
+                            hash == streamnative::hashContent(group.data(), static_cast<int>(group.size())));
+                group.clear();
+            } else if (seg.type >= 0 && seg.type != streamnative::MD_PLAIN_TEXT) {
+                group.append(text, static_cast<size_t>(seg.start), static_cast<size_t>(seg.end - seg.start));
+            }
+        }
+    }
+    streamnative::destroyMarkdownSession(session);
+    return hashes;
+}
+
+} // namespace
+
+// Render-cache keys: a hashed session's block hashes must be the hashes of
+// the group contents, the same for every chunking and the same in the nested
+// session; parseMarkdown's must be the hashes of the block sources and stay
+// put for the blocks IncrementalMarkdownParser keeps.
+bool testBlockHashes(const Transcripts& transcripts) {
+    bool ok = true;
+    for (const auto& t : transcripts) {
+        const std::vector<Chunk> tokens = makeChunks(t.text, ChunkMode::TOKEN);
+        bool session = true;
+        const std::vector<uint64_t> whole =
+                pushBlockHashes(&createHashedBlockSession, t.text, makeChunks(t.text, ChunkMode::MESSAGE), session);
+        session = session && pushBlockHashes(&createHashedBlockSession, t.text, tokens, session) == whole;
+        session = session && pushBlockHashes(&createHashedBlockSession, t.text, makeChunks(t.text, ChunkMode::CHAR), session) == whole;
+        session = session && pushBlockHashes(&createHashedNestedSession, t.text, tokens, session) == whole;
+        if (!session) {
+            std::printf("%s: session block hashes wrong or chunking-dependent  FAIL\n", t.name.c_str());
+            ok = false;
+        }
+
+        const int len = static_cast<int>(t.text.size());
+        const streamnative::MarkdownNodes nodes = streamnative::parseMarkdown(t.text.data(), len);
+        bool parser = true;
+        size_t block = 0;
+        for (size_t row = 0; row < nodes.size(); row++) {
+            if (nodes.parentIndex[row] >= 0) {
+                continue;
+            }
+            const int start = nodes.pieceStart[row];
+            parser = parser && block < nodes.blockHashes.size() &&
+                     nodes.blockHashes[block] == streamnative::hashContent(t.text.data() + start, nodes.pieceEnd[row] - start);
+            block++;
+        }
+        parser = parser && block == nodes.blockHashes.size();
+
+        streamnative::IncrementalMarkdownParser incremental;
+        for (const auto& chunk : tokens) {
+            std::vector<uint64_t> before = incremental.nodes().blockHashes;
+            const size_t kept = static_cast<size_t>(incremental.append(t.text.data() + chunk.start, chunk.len));
+            before.resize(std::min(before.size(), kept));
+            parser = parser && std::equal(before.begin(), before.end(), incremental.nodes().blockHashes.begin());
+        }
+        parser = parser && sameNodes(incremental.nodes(), nodes);
+        if (!parser) {
+            std::printf("%s: parser block hashes wrong or unstable  FAIL\n", t.name.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
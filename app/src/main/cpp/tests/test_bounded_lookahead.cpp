@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "tests.h"
+
+using namespace harness;
+
+// Worst-case inputs: one long line of openers that never close ('[', '<'
+// and letters, a backtick fence with an endless info string, ...) plus a
+// seeded random mix of delimiter characters, pushed in 64-char chunks. No
+// session may hold back more than twice the default attempt limit.
+bool testBoundedLookahead(const Transcripts&) {
+    struct Case {
+        const char* name;
+        std::u16string prefix;
+        std::u16string unit;
+    };
+    std::vector<Case> cases = {
+            {"brackets", u"", u"["},   {"lt-letters", u"<", u"a"}, {"fence-info", u"```", u"`"},
+            {"image", u"", u"!["},     {"link-text", u"[", u"a"},  {"plan-tag", u"<plan", u"a"},
+            {"attr", u"<tool name=\"", u"a"}, {"stars", u"", u"*"}, {"dollars", u"", u"$"},
+    };
+    {
+        // No newline anywhere, so nothing is decided by a line end.
+        const char16_t alphabet[] = u"[]()*_~`$<>!|\\/\"= ab";
+        std::u16string mix;
+        uint32_t seed = 12345;
+        while (mix.size() < 4096) {
+            seed = seed * 1103515245u + 12345u;
+            mix.push_back(alphabet[(seed >> 16) % (sizeof(alphabet) / sizeof(alphabet[0]) - 1)]);
+        }
+        cases.push_back({"random-mix", u"", mix});
+    }
+    struct SessionKind {
+        const char* name;
+        SessionFactory create;
+    };
+    const SessionKind kinds[] = {
+            {"block", &streamnative::createMarkdownBlockSession},
+            {"inline", &streamnative::createMarkdownInlineSession},
+            {"nested", &streamnative::createMarkdownNestedSession},
+    };
+    constexpr int kChunk = 64;
+    constexpr int kHeldLimit = 2 * streamnative::DEFAULT_ATTEMPT_LIMIT;
+
+    bool ok = true;
+    for (const auto& c : cases) {
+        // Long enough for several attempts to be abandoned in a row.
+        std::u16string text = c.prefix;
+        while (text.size() < 4 * static_cast<size_t>(kHeldLimit)) {
+            text += c.unit;
+        }
+        for (const auto& kind : kinds) {
+            streamnative::MarkdownSession* session = kind.create();
+            int held = 0;
+            for (int i = 0; i < static_cast<int>(text.size()); i += kChunk) {
+                const int len = std::min(kChunk, static_cast<int>(text.size()) - i);
+                streamnative::markdownSessionPush(session, text.data() + i, len);
+                held = std::max(held, streamnative::markdownSessionPendingLength(session));
+            }
+            streamnative::destroyMarkdownSession(session);
+            if (held > kHeldLimit) {
+                std::printf("%s %s: held back %d characters  FAIL\n", c.name, kind.name, held);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,42 @@
+#include <cstdio>
+
+#include "streamnative/ChatMarkupScanner.h"
+#include "tests.h"
+
+using namespace harness;
+
+// A sample must give the expected matches, and on documents built from each
+// transcript wrapped in thinking, status and emotion tags, stripping the
+// scanner's matches must leave the text the regex chain it replaces leaves.
+bool testChatMarkup(const Transcripts& transcripts) {
+    using namespace streamnative;
+    bool ok = true;
+    const std::u16string sample =
+            u"a<Status type=\"x\">s</status>b<thinking>t</THINK>c<tool_result name=\"r\"/>d<toolbox/>"
+            u"e<tool name=\"n\"><status/></tool>f<emotion>g</emotion><search x=\"/\">h<think";
+    const std::vector<Segment> expected = {
+            {CHAT_MARKUP_STATUS, 1, 28},            {CHAT_MARKUP_THINK, 29, 48},
+            {CHAT_MARKUP_TOOL_RESULT_SELF, 49, 72}, {CHAT_MARKUP_TOOL, 84, 115},
+            {CHAT_MARKUP_EMOTION, 116, 136},
+    };
+    std::vector<Segment> matches;
+    scanChatMarkup(sample.data(), static_cast<int>(sample.size()), CHAT_MARKUP_ALL, matches);
+    if (!sameSegments(matches, expected)) {
+        std::printf("sample matched wrongly  FAIL\n");
+        ok = false;
+    }
+
+    const RegexStripChain chain;
+    for (const auto& t : transcripts) {
+        const std::u16string doc = u"<status type=\"thinking\"/>\n<thinking>\n" + t.text + u"\n</thinking>\n" + t.text +
+                                   u"\n<emotion>happy</emotion>\n<status type=\"complete\"></status>\n";
+        std::vector<Segment> docMatches;
+        scanChatMarkup(doc.data(), static_cast<int>(doc.size()), CHAT_MARKUP_ALL, docMatches);
+        size_t regexMatches = 0;
+        if (stripMatches(doc, docMatches) != chain.strip(doc, regexMatches) || regexMatches != docMatches.size()) {
+            std::printf("%s: stripped text differs from the regex chain's  FAIL\n", t.name.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+
+#include "tests.h"
+
+using namespace harness;
+
+// Every checkpoint recorded while replaying a transcript token by token is
+// restored into a fresh session, which then gets the remaining tokens; its
+// segments must equal the original run's from that point on.
+bool testCheckpointResume(const Transcripts& transcripts) {
+    struct SessionKind {
+        const char* name;
+        SessionFactory create;
+    };
+    const SessionKind kinds[] = {
+            {"block", &streamnative::createMarkdownBlockSession},
+            {"inline", &streamnative::createMarkdownInlineSession},
+            {"nested", &streamnative::createMarkdownNestedSession},
+            {"hashed", &createHashedBlockSession},
+            {"hnested", &createHashedNestedSession},
+    };
+    constexpr int kInterval = 512;
+
+    bool ok = true;
+    for (const auto& t : transcripts) {
+        const std::vector<Chunk> chunks = makeChunks(t.text, ChunkMode::TOKEN);
+        for (const auto& kind : kinds) {
+            streamnative::MarkdownSession* session = kind.create();
+            streamnative::markdownSessionSetCheckpointInterval(session, kInterval);
+            std::vector<std::vector<streamnative::Segment>> pushed;
+            std::vector<std::vector<uint8_t>> checkpoints;
+            std::vector<size_t> resumeChunk;
+            for (size_t k = 0; k < chunks.size(); k++) {
+                pushed.push_back(streamnative::markdownSessionPush(session, t.text.data() + chunks[k].start, chunks[k].len));
+                const int offset = chunks[k].start + chunks[k].len;
+                const std::vector<uint8_t>* checkpoint = streamnative::markdownSessionCheckpointAt(session, offset);
+                if (checkpoint != nullptr && streamnative::markdownSnapshotOffset(checkpoint->data(), static_cast<int>(checkpoint->size())) == offset) {
+                    checkpoints.push_back(*checkpoint);
+                    resumeChunk.push_back(k + 1);
+                }
+            }
+            streamnative::destroyMarkdownSession(session);
+
+            int mismatches = 0;
+            for (size_t c = 0; c < checkpoints.size(); c++) {
+                streamnative::MarkdownSession* resumed = kind.create();
+                bool same = streamnative::markdownSessionRestoreState(resumed, checkpoints[c].data(), static_cast<int>(checkpoints[c].size()));
+                for (size_t k = resumeChunk[c]; same && k < chunks.size(); k++) {
+                    same = sameSegments(streamnative::markdownSessionPush(resumed, t.text.data() + chunks[k].start, chunks[k].len), pushed[k]);
+                }
+                streamnative::destroyMarkdownSession(resumed);
+                mismatches += same ? 0 : 1;
+            }
+            if (checkpoints.empty() || mismatches != 0) {
+                std::printf("%s %s: %d of %zu checkpoints resume differently  FAIL\n", t.name.c_str(), kind.name,
+                            mismatches, checkpoints.size());
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,48 @@
+#include <cstdio>
+
+#include "tests.h"
+
+using namespace harness;
+
+// Token-by-token pushes in the compact wire format must decode to the
+// segments the same pushes return as Segment vectors.
+bool testCompactWire(const Transcripts& transcripts) {
+    struct SessionKind {
+        const char* name;
+        SessionFactory create;
+    };
+    const SessionKind kinds[] = {
+            {"block", &streamnative::createMarkdownBlockSession},
+            {"inline", &streamnative::createMarkdownInlineSession},
+            {"nested", &streamnative::createMarkdownNestedSession},
+            {"hnested", &createHashedNestedSession},
+    };
+
+    bool ok = true;
+    for (const auto& t : transcripts) {
+        const std::vector<Chunk> chunks = makeChunks(t.text, ChunkMode::TOKEN);
+        for (const auto& kind : kinds) {
+            streamnative::MarkdownSession* plain = kind.create();
+            streamnative::MarkdownSession* compact = kind.create();
+            std::vector<streamnative::Segment> expected;
+            std::vector<streamnative::Segment> decoded;
+            int cursor = 0;
+            bool same = true;
+            for (const auto& chunk : chunks) {
+                const std::vector<streamnative::Segment> segments =
+                        streamnative::markdownSessionPush(plain, t.text.data() + chunk.start, chunk.len);
+                expected.insert(expected.end(), segments.begin(), segments.end());
+                const std::vector<uint8_t>& bytes =
+                        streamnative::markdownSessionPushCompact(compact, t.text.data() + chunk.start, chunk.len);
+                same = same && streamnative::decodeSegmentsCompact(bytes.data(), bytes.size(), cursor, decoded);
+            }
+            streamnative::destroyMarkdownSession(plain);
+            streamnative::destroyMarkdownSession(compact);
+            if (!same || !sameSegments(decoded, expected)) {
+                std::printf("%s %s: compact stream decodes differently  FAIL\n", t.name.c_str(), kind.name);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,55 @@
+#include <cstdio>
+
+#include "tests.h"
+
+using namespace harness;
+
+// A short sample must give the expected structure, and tool-call documents
+// (text, then objects with long escaped string values) the same segments
+// under every chunking.
+bool testJsonSession(const Transcripts&) {
+    using namespace streamnative;
+    bool ok = true;
+    const std::u16string sample = u"ok {\"a\": [1, \"x\\\"y\"], \"b\": {}} end";
+    const std::vector<Segment> expected = {
+            {JSON_TEXT, 0, 3},
+            {JSON_OBJECT_START, 3, 4},
+            {JSON_KEY, 5, 6},
+            {JSON_ARRAY_START, 9, 10},
+            {JSON_VALUE, 10, 11},
+            {JSON_VALUE, 14, 18},
+            {JSON_ARRAY_END, 19, 20},
+            {JSON_KEY, 23, 24},
+            {JSON_OBJECT_START, 27, 28},
+            {JSON_OBJECT_END, 28, 29},
+            {JSON_OBJECT_END, 29, 30},
+            {JSON_TEXT, 30, 34},
+    };
+    for (ChunkMode mode : {ChunkMode::CHAR, ChunkMode::MESSAGE}) {
+        if (!sameSegments(pushJson(sample, makeChunks(sample, mode)), expected)) {
+            std::printf("sample (%s chunks): unexpected segments  FAIL\n", chunkModeName(mode));
+            ok = false;
+        }
+    }
+
+    std::u16string body;
+    for (int k = 0; k < 64; k++) {
+        body += u"line of file content with \\\"quotes\\\" and \\u00e9 escapes\\n";
+    }
+    std::u16string call = u"Writing the file now.\n{\"tool\": \"write_file\", \"params\": {\"path\": \"src/a.kt\", "
+                          u"\"overwrite\": true, \"lines\": [1, 2.5, -3e2, null], \"content\": \"";
+    call += body;
+    call += u"\"}}\n\n";
+    std::u16string text;
+    while (text.size() < 64 * 1024) {
+        text += call;
+    }
+    const std::vector<Segment> whole = pushJson(text, makeChunks(text, ChunkMode::MESSAGE));
+    for (ChunkMode mode : {ChunkMode::CHAR, ChunkMode::TOKEN}) {
+        if (!sameSegments(pushJson(text, makeChunks(text, mode)), whole)) {
+            std::printf("tool calls (%s chunks): segments depend on the chunking  FAIL\n", chunkModeName(mode));
+            ok = false;
+        }
+    }
+    return ok;
+}
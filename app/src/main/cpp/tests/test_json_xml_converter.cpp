@@ -0,0 +1,41 @@
+#include <cstdio>
+
+#include "tests.h"
+
+using namespace harness;
+
+// A sample covering escapes, \u sequences and bare and nested values must
+// convert to the XML the Kotlin class produces under every chunking, and the
+// long arguments of a file write the same way under every chunking.
+bool testJsonXmlConverter(const Transcripts&) {
+    const std::u16string sample =
+            u"{\"path\": \"a<b>.kt\", \"body\": \"x\\n\\\"q\\\" \\u00e9\\u003c&\", \"n\": 42, "
+            u"\"list\": [1, {\"k\": \"]\"}], \"ok\": true}";
+    const std::u16string expected =
+            u"\n  <param name=\"path\">a&lt;b&gt;.kt</param>"
+            u"\n  <param name=\"body\">x\n&quot;q&quot; é&lt;&amp;</param>"
+            u"\n  <param name=\"n\">42</param>"
+            u"\n  <param name=\"list\">[1, {&quot;k&quot;: &quot;]&quot;}]</param>"
+            u"\n  <param name=\"ok\">true</param>";
+    bool ok = true;
+    for (ChunkMode mode : {ChunkMode::CHAR, ChunkMode::TOKEN, ChunkMode::MESSAGE}) {
+        if (convertJsonToXml(sample, makeChunks(sample, mode)) != expected) {
+            std::printf("sample (%s chunks): unexpected XML  FAIL\n", chunkModeName(mode));
+            ok = false;
+        }
+    }
+
+    std::u16string text = u"{\"path\": \"src/Main.kt\", \"content\": \"";
+    while (text.size() < 64 * 1024) {
+        text += u"    if (a < b && c > d) println(\\\"value: \\u00e9\\\")\\n";
+    }
+    text += u"\", \"overwrite\": true}";
+    const std::u16string whole = convertJsonToXml(text, makeChunks(text, ChunkMode::MESSAGE));
+    for (ChunkMode mode : {ChunkMode::CHAR, ChunkMode::TOKEN}) {
+        if (convertJsonToXml(text, makeChunks(text, mode)) != whole) {
+            std::printf("file write (%s chunks): XML depends on the chunking  FAIL\n", chunkModeName(mode));
+            ok = false;
+        }
+    }
+    return ok;
+}
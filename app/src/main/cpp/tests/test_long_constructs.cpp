@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "streamnative/MarkdownTypes.h"
+#include "tests.h"
+
+using namespace harness;
+
+namespace {
+
+std::vector<streamnative::Segment> pushInChunks(streamnative::MarkdownSession* session, const std::u16string& text,
+                                                int chunk) {
+    std::vector<streamnative::Segment> out;
+    for (int i = 0; i < static_cast<int>(text.size()); i += chunk) {
+        const int len = std::min(chunk, static_cast<int>(text.size()) - i);
+        const std::vector<streamnative::Segment> segments = streamnative::markdownSessionPush(session, text.data() + i, len);
+        out.insert(out.end(), segments.begin(), segments.end());
+    }
+    streamnative::destroyMarkdownSession(session);
+    return out;
+}
+
+} // namespace
+
+// Constructs longer than kLineLookahead (a link with long text, an XML start
+// tag with a long attribute, a fence with a long info string, ...) pushed in
+// 7-char chunks must keep their type and split exactly as in a session
+// without attempt limit.
+bool testLongConstructs(const Transcripts&) {
+    struct Case {
+        const char* name;
+        SessionFactory create;
+        int type;
+        std::u16string prefix;
+        char16_t fill;
+        std::u16string suffix;
+    };
+    const Case cases[] = {
+            {"link", &streamnative::createMarkdownInlineSession, streamnative::MD_LINK, u"see [", u'a',
+             u"](http://x.y/z) done\n"},
+            {"image", &streamnative::createMarkdownBlockSession, streamnative::MD_IMAGE, u"![", u'a',
+             u"](http://x.y/z.png)\nafter\n"},
+            {"xml-tag", &streamnative::createMarkdownBlockSession, streamnative::MD_XML_BLOCK, u"<tool name=\"", u'b',
+             u"\">\n<param name=\"p\">v</param>\n</tool>\nafter\n"},
+            {"fence-info", &streamnative::createMarkdownBlockSession, streamnative::MD_CODE_BLOCK, u"```", u'c',
+             u"\ncode\n```\nafter\n"},
+            {"table", &streamnative::createMarkdownBlockSession, streamnative::MD_TABLE, u"| ", u'a',
+             u" | b |\n|---|---|\n| 1 | 2 |\n\nafter\n"},
+            {"nested-link", &streamnative::createMarkdownNestedSession, streamnative::MD_LINK, u"see [", u'a',
+             u"](http://x.y/z) done\n"},
+    };
+    bool ok = true;
+    for (const auto& c : cases) {
+        for (int n : {300, 2000}) {
+            const std::u16string text = c.prefix + std::u16string(static_cast<size_t>(n), c.fill) + c.suffix;
+            const std::vector<streamnative::Segment> limited = pushInChunks(c.create(), text, 7);
+            streamnative::MarkdownSession* unlimited = c.create();
+            streamnative::markdownSessionSetAttemptLimit(unlimited, 0);
+            const std::vector<streamnative::Segment> expected = pushInChunks(unlimited, text, 7);
+            int typed = 0;
+            for (const auto& seg : limited) {
+                typed += seg.type == c.type ? seg.end - seg.start : 0;
+            }
+            if (typed <= n || !sameSegments(limited, expected)) {
+                std::printf("%s of %d characters: lost its type or split differently  FAIL\n", c.name, n);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,70 @@
+// Host tests for the streamnative core.
+//
+// Usage: streamnative_tests NAME
+// Runs the named test over the transcripts under benchmarks/transcripts and
+// exits with status 1 if it fails.
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "tests.h"
+
+namespace {
+
+struct Test {
+    const char* name;
+    bool (*run)(const Transcripts&);
+};
+
+const Test kTests[] = {
+        {"block_hashes", &testBlockHashes},
+        {"bounded_lookahead", &testBoundedLookahead},
+        {"chat_markup", &testChatMarkup},
+        {"checkpoint_resume", &testCheckpointResume},
+        {"compact_wire", &testCompactWire},
+        {"json_session", &testJsonSession},
+        {"json_xml_converter", &testJsonXmlConverter},
+        {"long_constructs", &testLongConstructs},
+        {"nested_session", &testNestedSession},
+        {"parse_parallel", &testParseParallel},
+        {"plugin_stats", &testPluginStats},
+        {"ring", &testRing},
+        {"steady_state_allocs", &testSteadyStateAllocs},
+        {"utf8_input", &testUtf8Input},
+        {"xml_split", &testXmlSplit},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Test* test = nullptr;
+    for (const Test& candidate : kTests) {
+        if (argc == 2 && std::strcmp(argv[1], candidate.name) == 0) {
+            test = &candidate;
+        }
+    }
+    if (test == nullptr) {
+        std::fprintf(stderr, "usage: %s NAME\ntests:", argv[0]);
+        for (const Test& candidate : kTests) {
+            std::fprintf(stderr, " %s", candidate.name);
+        }
+        std::fprintf(stderr, "\n");
+        return 2;
+    }
+
+    Transcripts transcripts;
+    for (const auto& path : harness::listTranscripts(STREAMNATIVE_TRANSCRIPTS)) {
+        harness::Transcript t;
+        if (!harness::loadTranscript(path, t)) {
+            std::fprintf(stderr, "cannot read %s\n", path.c_str());
+            return 1;
+        }
+        transcripts.push_back(std::move(t));
+    }
+    if (transcripts.empty()) {
+        std::fprintf(stderr, "no transcripts found\n");
+        return 1;
+    }
+    return test->run(transcripts) ? 0 : 1;
+}
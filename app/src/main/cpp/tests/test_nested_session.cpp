@@ -0,0 +1,38 @@
+#include <cstdio>
+
+#include "tests.h"
+
+using namespace harness;
+
+namespace {
+
+std::vector<streamnative::Segment> pushNested(const std::u16string& text, const std::vector<Chunk>& chunks) {
+    std::vector<streamnative::Segment> all;
+    streamnative::MarkdownSession* session = streamnative::createMarkdownNestedSession();
+    for (const auto& chunk : chunks) {
+        const std::vector<streamnative::Segment> segments =
+                streamnative::markdownSessionPush(session, text.data() + chunk.start, chunk.len);
+        all.insert(all.end(), segments.begin(), segments.end());
+    }
+    streamnative::destroyMarkdownSession(session);
+    return mergeRuns(all);
+}
+
+} // namespace
+
+// A nested session must report what a block session and a fresh inline
+// session per inline-container group report together, under every chunking.
+bool testNestedSession(const Transcripts& transcripts) {
+    bool ok = true;
+    for (const auto& t : transcripts) {
+        const std::vector<streamnative::Segment> expected = nestedReference(t.text);
+        for (ChunkMode mode : {ChunkMode::CHAR, ChunkMode::TOKEN, ChunkMode::MESSAGE}) {
+            if (!sameSegments(pushNested(t.text, makeChunks(t.text, mode)), expected)) {
+                std::printf("%s (%s chunks): differs from a block session plus inline sessions  FAIL\n",
+                            t.name.c_str(), chunkModeName(mode));
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
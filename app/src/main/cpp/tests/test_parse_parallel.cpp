@@ -0,0 +1,35 @@
+#include <cstdio>
+#include <string>
+
+#include "streamnative/MarkdownParser.h"
+#include "tests.h"
+
+using namespace harness;
+
+// parseMarkdownParallel at 1 to 8 threads on 256KB and 1MB documents built
+// from the transcripts must give parseMarkdown's nodes.
+bool testParseParallel(const Transcripts& transcripts) {
+    std::u16string corpus;
+    for (const auto& t : transcripts) {
+        corpus += t.text;
+        corpus += u"\n\n";
+    }
+
+    bool ok = true;
+    for (size_t chars : {256 * 1024, 1024 * 1024}) {
+        std::u16string text;
+        while (text.size() < chars) {
+            text += corpus;
+        }
+        text.resize(chars);
+        const int len = static_cast<int>(text.size());
+        const streamnative::MarkdownNodes serial = streamnative::parseMarkdown(text.data(), len);
+        for (int threads : {1, 2, 4, 8}) {
+            if (!sameNodes(streamnative::parseMarkdownParallel(text.data(), len, threads), serial)) {
+                std::printf("%zuKB at %d threads differs from parseMarkdown  FAIL\n", chars / 1024, threads);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,33 @@
+#include <cstdio>
+
+#include "tests.h"
+
+using namespace harness;
+
+// Per-plugin counters (STREAMNATIVE_ENABLE_STATS builds only) of a nested
+// session fed token by token must not contradict each other: no more
+// rejected than entered attempts, and no rejected WAITFOR without its
+// replayed character.
+bool testPluginStats(const Transcripts& transcripts) {
+    bool ok = true;
+    for (const auto& t : transcripts) {
+        streamnative::MarkdownSession* session = streamnative::createMarkdownNestedSession();
+        for (const auto& chunk : makeChunks(t.text, ChunkMode::TOKEN)) {
+            streamnative::markdownSessionPush(session, t.text.data() + chunk.start, chunk.len);
+        }
+        streamnative::SessionStats stats;
+        const bool enabled = streamnative::markdownSessionGetStats(session, stats);
+        streamnative::destroyMarkdownSession(session);
+        if (!enabled) {
+            std::printf("built without STREAMNATIVE_ENABLE_STATS  FAIL\n");
+            return false;
+        }
+        for (const auto& p : stats.plugins) {
+            if (p.tryingRejections > p.tryingEntries || p.waitforRejected != p.pendingReplays) {
+                std::printf("%s: counters of plugin %d contradict each other  FAIL\n", t.name.c_str(), p.tag);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,95 @@
+#include <cstdio>
+
+#include "tests.h"
+
+using namespace harness;
+
+namespace {
+
+// Consumes up to `limit` published triples from `ring` into `out`.
+void readRing(int32_t* ring, int capacity, size_t limit, std::vector<streamnative::Segment>& out) {
+    const uint32_t write = static_cast<uint32_t>(__atomic_load_n(&ring[streamnative::RING_WRITE_INDEX], __ATOMIC_ACQUIRE));
+    uint32_t read = static_cast<uint32_t>(ring[streamnative::RING_READ_INDEX]);
+    for (size_t k = 0; k < limit && read != write; k++, read++) {
+        const int32_t* slot = ring + streamnative::RING_HEADER_INTS + 3 * (read & static_cast<uint32_t>(capacity - 1));
+        out.push_back({slot[0], slot[1], slot[2]});
+    }
+    __atomic_store_n(&ring[streamnative::RING_READ_INDEX], static_cast<int32_t>(read), __ATOMIC_RELEASE);
+}
+
+// Segments read back through a ring of `capacity` by a reader that takes one
+// triple per push, then catches up once the input is done. `published`
+// totals what the pushes and drains reported.
+std::vector<streamnative::Segment> pushThroughRing(SessionFactory create, const std::u16string& text,
+                                                   const std::vector<Chunk>& chunks, int capacity, size_t& published) {
+    std::vector<int32_t> ring(static_cast<size_t>(streamnative::RING_HEADER_INTS + 3 * capacity));
+    std::vector<streamnative::Segment> read;
+    streamnative::MarkdownSession* session = create();
+    streamnative::attachMarkdownSessionRing(session, ring.data(), capacity);
+    published = 0;
+    for (const auto& chunk : chunks) {
+        published += static_cast<size_t>(
+                streamnative::markdownSessionPushToRing(session, text.data() + chunk.start, chunk.len));
+        readRing(ring.data(), capacity, 1, read);
+    }
+    for (;;) {
+        readRing(ring.data(), capacity, static_cast<size_t>(capacity), read);
+        const int drained = streamnative::markdownSessionDrainRing(session);
+        if (drained == 0) {
+            break;
+        }
+        published += static_cast<size_t>(drained);
+    }
+    streamnative::destroyMarkdownSession(session);
+    return read;
+}
+
+std::vector<streamnative::Segment> pushAll(SessionFactory create, const std::u16string& text,
+                                           const std::vector<Chunk>& chunks) {
+    std::vector<streamnative::Segment> all;
+    streamnative::MarkdownSession* session = create();
+    for (const auto& chunk : chunks) {
+        const std::vector<streamnative::Segment> segments =
+                streamnative::markdownSessionPush(session, text.data() + chunk.start, chunk.len);
+        all.insert(all.end(), segments.begin(), segments.end());
+    }
+    streamnative::destroyMarkdownSession(session);
+    return all;
+}
+
+} // namespace
+
+// Block and nested sessions must deliver through rings too small for a
+// single push what markdownSessionPush returns, to a reader that lags
+// behind. A nested session may extend a segment still waiting for room, so
+// both sides are compared with runs merged.
+bool testRing(const Transcripts& transcripts) {
+    struct Kind {
+        const char* name;
+        SessionFactory create;
+    };
+    const Kind kinds[] = {
+            {"block", &streamnative::createMarkdownBlockSession},
+            {"nested", &streamnative::createMarkdownNestedSession},
+    };
+    bool ok = true;
+    for (const auto& t : transcripts) {
+        for (ChunkMode mode : {ChunkMode::CHAR, ChunkMode::TOKEN}) {
+            const std::vector<Chunk> chunks = makeChunks(t.text, mode);
+            for (const Kind& kind : kinds) {
+                const std::vector<streamnative::Segment> expected = mergeRuns(pushAll(kind.create, t.text, chunks));
+                for (int capacity : {1, 2, 4}) {
+                    size_t published = 0;
+                    const std::vector<streamnative::Segment> read =
+                            pushThroughRing(kind.create, t.text, chunks, capacity, published);
+                    if (published != read.size() || !sameSegments(mergeRuns(read), expected)) {
+                        std::printf("%s %s (%s chunks, capacity %d): ring differs from push  FAIL\n", t.name.c_str(),
+                                    kind.name, chunkModeName(mode), capacity);
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,54 @@
+#include <cstdio>
+
+#include "alloc_counter.h"
+#include "tests.h"
+
+using namespace harness;
+
+// Replays a transcript three times into one ring-backed session and counts
+// heap allocations per replay. The first two warm up the buffers (the second
+// also covers blocks left open across the seam); the third must not allocate.
+bool testSteadyStateAllocs(const Transcripts& transcripts) {
+    struct SessionKind {
+        const char* name;
+        SessionFactory create;
+    };
+    const SessionKind kinds[] = {
+            {"block", &streamnative::createMarkdownBlockSession},
+            {"inline", &streamnative::createMarkdownInlineSession},
+            {"nested", &streamnative::createMarkdownNestedSession},
+    };
+    const ChunkMode modes[] = {ChunkMode::CHAR, ChunkMode::TOKEN};
+    constexpr int kCapacity = 256;
+    std::vector<int32_t> ring(streamnative::RING_HEADER_INTS + kCapacity * 3);
+
+    bool ok = true;
+    for (const auto& t : transcripts) {
+        for (const auto& kind : kinds) {
+            for (ChunkMode mode : modes) {
+                const std::vector<Chunk> chunks = makeChunks(t.text, mode);
+                streamnative::MarkdownSession* session = kind.create();
+                streamnative::attachMarkdownSessionRing(session, ring.data(), kCapacity);
+                uint64_t allocs[3] = {0, 0, 0};
+                for (uint64_t& replayAllocs : allocs) {
+                    const uint64_t before = allocationCount();
+                    for (const auto& chunk : chunks) {
+                        int published = streamnative::markdownSessionPushToRing(session, t.text.data() + chunk.start, chunk.len);
+                        while (published > 0) {
+                            ring[streamnative::RING_READ_INDEX] += published;
+                            published = streamnative::markdownSessionDrainRing(session);
+                        }
+                    }
+                    replayAllocs = allocationCount() - before;
+                }
+                streamnative::destroyMarkdownSession(session);
+                if (allocs[2] != 0) {
+                    std::printf("%s %s %s: %llu allocations in the third replay  FAIL\n", t.name.c_str(), kind.name,
+                                chunkModeName(mode), static_cast<unsigned long long>(allocs[2]));
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "streamnative/StreamNativeCApi.h"
+#include "tests.h"
+
+using namespace harness;
+
+namespace {
+
+// Pushes `bytes` as UTF-8 in `step`-byte chunks (cutting through multi-byte
+// sequences) into `utf8`, and the units each push decoded to into `utf16`.
+// Returns false unless both report the same segments; `decoded` gets the text.
+bool pushUtf8Split(streamnative::MarkdownSession* utf8, streamnative::MarkdownSession* utf16, const std::string& bytes,
+                   size_t step, std::u16string& decoded) {
+    const auto* data = reinterpret_cast<const uint8_t*>(bytes.data());
+    bool same = true;
+    for (size_t at = 0; at < bytes.size(); at += step) {
+        const int len = static_cast<int>(std::min(step, bytes.size() - at));
+        const std::vector<streamnative::Segment> fromBytes = streamnative::markdownSessionPush(utf8, data + at, len);
+        int units = 0;
+        const char16_t* text = streamnative::markdownSessionDecodedText(utf8, units);
+        const std::vector<streamnative::Segment> fromUnits =
+                units > 0 ? streamnative::markdownSessionPush(utf16, text, units) : std::vector<streamnative::Segment>();
+        decoded.append(text, static_cast<size_t>(units));
+        same = same && sameSegments(fromBytes, fromUnits);
+    }
+    return same;
+}
+
+bool splitMatches(const std::string& bytes, size_t step, const std::u16string& expected) {
+    streamnative::MarkdownSession* utf8 = streamnative::createMarkdownBlockSession();
+    streamnative::MarkdownSession* utf16 = streamnative::createMarkdownBlockSession();
+    std::u16string decoded;
+    const bool same = pushUtf8Split(utf8, utf16, bytes, step, decoded) && decoded == expected;
+    streamnative::destroyMarkdownSession(utf8);
+    streamnative::destroyMarkdownSession(utf16);
+    return same;
+}
+
+// The C ABI the llama loop uses, token by token like a generation, against
+// markdownSessionPush of the same bytes.
+bool capiMatches(const std::u16string& text) {
+    const StreamNativeCApi* api = streamnative_get_c_api(STREAMNATIVE_C_API_VERSION);
+    StreamNativeSession* handle = api != nullptr ? api->createMarkdownSession(STREAMNATIVE_SESSION_BLOCK) : nullptr;
+    if (handle == nullptr) {
+        return false;
+    }
+    streamnative::MarkdownSession* direct = streamnative::createMarkdownBlockSession();
+    bool same = true;
+    std::u16string decoded;
+    for (const auto& chunk : makeChunks(text, ChunkMode::TOKEN)) {
+        const std::string piece = encodeUtf8(text.substr(chunk.start, chunk.len));
+        const auto* data = reinterpret_cast<const uint8_t*>(piece.data());
+        const std::vector<streamnative::Segment> expected =
+                streamnative::markdownSessionPush(direct, data, static_cast<int>(piece.size()));
+        const uint16_t* units = nullptr;
+        int32_t unitCount = 0;
+        const int32_t* segments = nullptr;
+        const int32_t count = api->pushUtf8(handle, data, static_cast<int32_t>(piece.size()), &units, &unitCount, &segments);
+        decoded.append(reinterpret_cast<const char16_t*>(units), static_cast<size_t>(unitCount));
+        same = same && count == static_cast<int32_t>(expected.size()) &&
+               sameSegments(expected, std::vector<streamnative::Segment>(
+                                              reinterpret_cast<const streamnative::Segment*>(segments),
+                                              reinterpret_cast<const streamnative::Segment*>(segments) + count));
+    }
+    // Nothing is left pending once the text is complete.
+    const uint16_t* units = nullptr;
+    int32_t unitCount = 0;
+    const int32_t* segments = nullptr;
+    same = same && api->flushUtf8(handle, &units, &unitCount, &segments) == 0 && unitCount == 0;
+    api->destroySession(handle);
+    streamnative::destroyMarkdownSession(direct);
+    return same && decoded == text;
+}
+
+// `bytes` cut off inside a sequence, pushed and then flushed through the C
+// ABI, must decode to `expected` and give the segments of the same units
+// pushed as UTF-16.
+bool flushMatches(const std::string& bytes, const std::u16string& expected) {
+    const StreamNativeCApi* api = streamnative_get_c_api(STREAMNATIVE_C_API_VERSION);
+    StreamNativeSession* handle = api != nullptr ? api->createMarkdownSession(STREAMNATIVE_SESSION_BLOCK) : nullptr;
+    if (handle == nullptr) {
+        return false;
+    }
+    streamnative::MarkdownSession* utf16 = streamnative::createMarkdownBlockSession();
+    bool same = true;
+    std::u16string decoded;
+    for (bool flush : {false, true}) {
+        const uint16_t* units = nullptr;
+        int32_t unitCount = 0;
+        const int32_t* segments = nullptr;
+        const int32_t count =
+                flush ? api->flushUtf8(handle, &units, &unitCount, &segments)
+                      : api->pushUtf8(handle, reinterpret_cast<const uint8_t*>(bytes.data()),
+                                      static_cast<int32_t>(bytes.size()), &units, &unitCount, &segments);
+        const auto* text = reinterpret_cast<const char16_t*>(units);
+        decoded.append(text, static_cast<size_t>(unitCount));
+        const std::vector<streamnative::Segment> expectedSegments =
+                unitCount > 0 ? streamnative::markdownSessionPush(utf16, text, unitCount)
+                              : std::vector<streamnative::Segment>();
+        same = same && count == static_cast<int32_t>(expectedSegments.size()) &&
+               sameSegments(expectedSegments, std::vector<streamnative::Segment>(
+                                                      reinterpret_cast<const streamnative::Segment*>(segments),
+                                                      reinterpret_cast<const streamnative::Segment*>(segments) + count));
+    }
+    api->destroySession(handle);
+    streamnative::destroyMarkdownSession(utf16);
+    return same && decoded == expected;
+}
+
+} // namespace
+
+// A sample with malformed, overlong and out-of-range sequences must decode
+// like bytesUtf8ToJstring however it is split, and a stream cut off inside
+// a sequence must decode those bytes to U+FFFD once flushed; every
+// transcript pushed as UTF-8 in odd-sized chunks must decode to its text and
+// give the segments of the same units pushed as UTF-16, and pushed token by
+// token through the C ABI, the segments of markdownSessionPush.
+bool testUtf8Input(const Transcripts& transcripts) {
+    bool ok = true;
+    const std::string sample =
+            "a\xC3\xA9 \xE2\x82\xAC\xF0\x9F\x98\x80|\xC0\xAF|\xFF|\xE2\x28\xA1|\xF4\x90\x80\x80|\xED\xA0\x80|\xC3z";
+    const std::u16string expected = u"a\u00e9 \u20ac\U0001F600|\ufffd|\ufffd|\ufffd(\ufffd|\ufffd|\xd800|\ufffdz";
+    for (size_t step = 1; step <= sample.size(); step++) {
+        if (!splitMatches(sample, step, expected)) {
+            std::printf("sample in %zu-byte chunks decoded wrongly  FAIL\n", step);
+            ok = false;
+        }
+    }
+    if (!flushMatches("# a\n\n*b* \xF0\x9F\x98", u"# a\n\n*b* \ufffd\ufffd\ufffd") ||
+        !flushMatches("\xC3", u"\ufffd")) {
+        std::printf("stream cut off inside a sequence: flush decoded wrongly  FAIL\n");
+        ok = false;
+    }
+
+    for (const auto& t : transcripts) {
+        const std::string bytes = encodeUtf8(t.text);
+        for (size_t step : {1, 2, 5, 7, 64}) {
+            if (!splitMatches(bytes, step, t.text)) {
+                std::printf("%s in %zu-byte chunks: UTF-8 differs from UTF-16  FAIL\n", t.name.c_str(), step);
+                ok = false;
+            }
+        }
+        if (!capiMatches(t.text)) {
+            std::printf("%s: C ABI differs from markdownSessionPush  FAIL\n", t.name.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,66 @@
+#include <cstdio>
+
+#include "streamnative/StreamOperators.h"
+#include "tests.h"
+
+using namespace harness;
+
+namespace {
+
+std::vector<streamnative::Segment> pushAll(const std::u16string& text, const std::vector<Chunk>& chunks) {
+    std::vector<streamnative::Segment> all;
+    streamnative::XmlSplitSession* session = streamnative::createXmlSplitSession();
+    for (const auto& chunk : chunks) {
+        const std::vector<streamnative::Segment> segments =
+                streamnative::xmlSplitSessionPush(session, text.data() + chunk.start, chunk.len);
+        all.insert(all.end(), segments.begin(), segments.end());
+    }
+    const std::vector<streamnative::Segment> rest = streamnative::xmlSplitSessionFinish(session);
+    all.insert(all.end(), rest.begin(), rest.end());
+    streamnative::destroyXmlSplitSession(session);
+    return mergeTextRuns(all);
+}
+
+} // namespace
+
+// A nested sample must split as expected, a tool call must give the expected
+// tag index, and on every transcript the token-fed XmlSplitSession (text runs
+// merged) and the indexed split must give splitByXml's segments.
+bool testXmlSplit(const Transcripts& transcripts) {
+    using namespace streamnative;
+    bool ok = true;
+    const std::u16string sample = u"Hi. <a><a x=\"1\">x</a><a/></a> done. <b>open";
+    const std::vector<Segment> expected = {{0, 0, 4}, {1, 4, 29}, {0, 29, 36}, {1, 36, 43}};
+    if (!sameSegments(splitByXml(sample.data(), static_cast<int>(sample.size())), expected) ||
+        !sameSegments(pushAll(sample, makeChunks(sample, ChunkMode::CHAR)), expected)) {
+        std::printf("nested sample split wrongly  FAIL\n");
+        ok = false;
+    }
+
+    const std::u16string call = u"<tool name=\"x\"><param name=\"p\">v</param></tool>";
+    const std::vector<Segment> expectedIndex = {
+            {XML_INDEX_TAG, 1, 5},        {XML_INDEX_ATTR_NAME, 6, 10}, {XML_INDEX_ATTR_VALUE, 12, 13},
+            {XML_INDEX_CHILD, 16, 21},    {XML_INDEX_ATTR_NAME, 22, 26}, {XML_INDEX_ATTR_VALUE, 28, 29},
+            {XML_INDEX_CHILD_CONTENT, 31, 32}, {XML_INDEX_CONTENT, 15, 40},
+    };
+    std::vector<Segment> index;
+    splitByXml(call.data(), static_cast<int>(call.size()), index);
+    if (!sameSegments(index, expectedIndex)) {
+        std::printf("tool-call index wrong  FAIL\n");
+        ok = false;
+    }
+
+    for (const auto& t : transcripts) {
+        const std::vector<Segment> whole = splitByXml(t.text.data(), static_cast<int>(t.text.size()));
+        if (!sameSegments(pushAll(t.text, makeChunks(t.text, ChunkMode::TOKEN)), whole)) {
+            std::printf("%s: XmlSplitSession differs from splitByXml  FAIL\n", t.name.c_str());
+            ok = false;
+        }
+        std::vector<Segment> entries;
+        if (!sameSegments(splitByXml(t.text.data(), static_cast<int>(t.text.size()), entries), whole)) {
+            std::printf("%s: indexed split differs from splitByXml  FAIL\n", t.name.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// One function per tested feature, run by name from test_main.cpp (CTest
+// registers each as its own test). Each prints a line ending in FAIL for
+// every case that goes wrong and returns false if any did.
+
+#include <vector>
+
+#include "replay.h"
+
+using Transcripts = std::vector<harness::Transcript>;
+
+bool testBlockHashes(const Transcripts& transcripts);
+bool testBoundedLookahead(const Transcripts& transcripts);
+bool testChatMarkup(const Transcripts& transcripts);
+bool testCheckpointResume(const Transcripts& transcripts);
+bool testCompactWire(const Transcripts& transcripts);
+bool testJsonSession(const Transcripts& transcripts);
+bool testJsonXmlConverter(const Transcripts& transcripts);
+bool testLongConstructs(const Transcripts& transcripts);
+bool testNestedSession(const Transcripts& transcripts);
+bool testParseParallel(const Transcripts& transcripts);
+bool testPluginStats(const Transcripts& transcripts);
+bool testRing(const Transcripts& transcripts);
+bool testSteadyStateAllocs(const Transcripts& transcripts);
+bool testUtf8Input(const Transcripts& transcripts);
+bool testXmlSplit(const Transcripts& transcripts);
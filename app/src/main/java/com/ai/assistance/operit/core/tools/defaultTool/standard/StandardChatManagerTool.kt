@@ -8,7 +8,7 @@ import android.os.Build
 import android.os.IBinder
 import com.ai.assistance.operit.R
 import com.ai.assistance.operit.util.AppLogger
-import com.ai.assistance.operit.util.ChatMarkupRegex
+import com.ai.assistance.operit.util.streamnative.NativeChatMarkup
 import com.ai.assistance.operit.util.stream.SharedStream
 import com.ai.assistance.operit.core.tools.AgentStatusResultData
 import com.ai.assistance.operit.core.tools.ChatCreationResultData
@@ -55,13 +55,7 @@ class StandardChatManagerTool(private val context: Context) {
 
     private fun simplifyXmlBlocksForHistory(text: String): String {
         if (text.isEmpty()) return text
-        return text
-            .replace(ChatMarkupRegex.toolTag, "")
-            .replace(ChatMarkupRegex.toolSelfClosingTag, "")
-            .replace(ChatMarkupRegex.toolResultTag, "")
-            .replace(ChatMarkupRegex.toolResultSelfClosingTag, "")
-            .replace(ChatMarkupRegex.statusTag, "")
-            .replace(ChatMarkupRegex.statusSelfClosingTag, "")
+        return NativeChatMarkup.strip(text, NativeChatMarkup.TOOL_TAGS or NativeChatMarkup.STATUS_TAGS)
             .trim()
     }
 
@@ -59,9 +59,9 @@ import com.ai.assistance.operit.util.markdown.SmartString
 import com.ai.assistance.operit.util.stream.Stream
 import com.ai.assistance.operit.util.stream.StreamInterceptor
 import com.ai.assistance.operit.util.stream.splitBy as streamSplitBy
-import com.ai.assistance.operit.util.stream.stream
-import com.ai.assistance.operit.util.streamnative.nativeMarkdownSplitByBlock
-import com.ai.assistance.operit.util.streamnative.nativeMarkdownSplitByInline
+import com.ai.assistance.operit.util.streamnative.NativeMarkdownNestedHandler
+import com.ai.assistance.operit.util.streamnative.collectNativeMarkdownNested
+import com.ai.assistance.operit.util.streamnative.splitNativeMarkdownNested
 import kotlin.time.Duration.Companion.milliseconds
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
@@ -146,6 +146,124 @@ private fun String.trimAll(): String {
     return this.trim { it.isWhitespace() }
 }
 
+/**
+ * 将原生嵌套会话输出的块/内联范围构建为 MarkdownNode 树。
+ * 规则与原先"块流 -> 内联流"两级拆分一致：换行字符不单独成节点，内联 LaTeX 与块级 LaTeX 在分组结束时替换为对应节点，
+ * 块末尾的空白纯文本子节点会被移除。
+ */
+private class MarkdownNodeTreeBuilder(
+    private val nodes: MutableList<MarkdownNode>
+) : NativeMarkdownNestedHandler {
+    private var blockNode: MarkdownNode? = null
+    private var blockIndex = -1
+    private var isLatexBlock = false
+    private var isInlineContainer = false
+    private var lastCharWasNewline = false
+
+    private var inlineType: MarkdownProcessorType? = null
+    private var childNode: MarkdownNode? = null
+    private val pending = StringBuilder()
+
+    override fun openBlock(type: MarkdownProcessorType) {
+        if (type == MarkdownProcessorType.HORIZONTAL_RULE) {
+            nodes.add(MarkdownNode(type = type, initialContent = "---"))
+            blockNode = null
+            return
+        }
+
+        isLatexBlock = type == MarkdownProcessorType.BLOCK_LATEX
+        val tempBlockType = if (isLatexBlock) MarkdownProcessorType.PLAIN_TEXT else type
+        isInlineContainer =
+            tempBlockType != MarkdownProcessorType.CODE_BLOCK &&
+                tempBlockType != MarkdownProcessorType.BLOCK_LATEX &&
+                tempBlockType != MarkdownProcessorType.XML_BLOCK &&
+                tempBlockType != MarkdownProcessorType.PLAN_EXECUTION
+
+        val newNode = MarkdownNode(type = tempBlockType)
+        nodes.add(newNode)
+        blockNode = newNode
+        blockIndex = nodes.lastIndex
+        lastCharWasNewline = false
+        inlineType = null
+        childNode = null
+    }
+
+    override fun appendRun(type: MarkdownProcessorType, content: CharSequence, start: Int, end: Int) {
+        val node = blockNode ?: return
+        if (!isInlineContainer) {
+            node.content + content.substring(start, end)
+            return
+        }
+
+        if (inlineType != null && inlineType != type) {
+            finishInline()
+        }
+        inlineType = type
+
+        pending.setLength(0)
+        for (i in start until end) {
+            val c = content[i]
+            if (c == '\n' || c == '\r') {
+                lastCharWasNewline = true
+                continue
+            }
+            if (childNode == null) {
+                val childType = if (type == MarkdownProcessorType.INLINE_LATEX) MarkdownProcessorType.PLAIN_TEXT else type
+                childNode = MarkdownNode(type = childType).also { node.children.add(it) }
+            }
+            if (lastCharWasNewline && (pending.isNotEmpty() || node.content.isNotEmpty())) {
+                pending.append('\n')
+            }
+            lastCharWasNewline = false
+            pending.append(c)
+        }
+
+        if (pending.isNotEmpty()) {
+            val text = pending.toString()
+            node.content + text
+            childNode!!.content + text
+        }
+    }
+
+    override fun breakInline() {
+        finishInline()
+    }
+
+    override fun closeBlock() {
+        val node = blockNode ?: return
+        finishInline()
+        if (isLatexBlock) {
+            nodes[blockIndex] =
+                MarkdownNode(type = MarkdownProcessorType.BLOCK_LATEX, initialContent = node.content.toString())
+        }
+        blockNode = null
+    }
+
+    private fun finishInline() {
+        val node = blockNode
+        val child = childNode
+        val type = inlineType
+        childNode = null
+        inlineType = null
+        if (node == null || child == null) return
+
+        if (type == MarkdownProcessorType.INLINE_LATEX) {
+            val childIndex = node.children.lastIndexOf(child)
+            if (childIndex != -1) {
+                node.children[childIndex] =
+                    MarkdownNode(type = MarkdownProcessorType.INLINE_LATEX, initialContent = child.content.toString())
+            }
+        }
+
+        if (type == MarkdownProcessorType.PLAIN_TEXT && child.content.toString().trimAll().isEmpty()) {
+            val lastIndex = node.children.lastIndex
+            if (lastIndex >= 0 && node.children[lastIndex] == child) {
+                node.children.removeAt(lastIndex)
+            }
+        }
+    }
+}
+
 /**
  * StreamMarkdownRenderer的状态类
  * 用于在流式渲染和静态渲染之间共享状态，避免切换时重新计算
@@ -263,101 +381,10 @@ fun StreamMarkdownRenderer(
         rendererState.collectedContent.clear()
 
         try {
-            interceptedStream.nativeMarkdownSplitByBlock(flushIntervalMs = RENDER_INTERVAL_MS).collect { blockGroup ->
-                val blockType = blockGroup.tag ?: MarkdownProcessorType.PLAIN_TEXT
-
-                if (blockType == MarkdownProcessorType.HORIZONTAL_RULE) {
-                    nodes.add(MarkdownNode(type = blockType, initialContent = "---"))
-                    return@collect
-                }
-
-                val isLatexBlock = blockType == MarkdownProcessorType.BLOCK_LATEX
-                val tempBlockType =
-                    if (isLatexBlock) MarkdownProcessorType.PLAIN_TEXT else blockType
-
-                val isInlineContainer =
-                    tempBlockType != MarkdownProcessorType.CODE_BLOCK &&
-                        tempBlockType != MarkdownProcessorType.BLOCK_LATEX &&
-                        tempBlockType != MarkdownProcessorType.XML_BLOCK &&
-                        tempBlockType != MarkdownProcessorType.PLAN_EXECUTION
-
-                val newNode = MarkdownNode(type = tempBlockType)
-                nodes.add(newNode)
-                val nodeIndex = nodes.lastIndex
-
-                if (isInlineContainer) {
-                    var lastCharWasNewline = false
-
-                    blockGroup.stream.nativeMarkdownSplitByInline(flushIntervalMs = RENDER_INTERVAL_MS).collect { inlineGroup ->
-                        val originalInlineType = inlineGroup.tag ?: MarkdownProcessorType.PLAIN_TEXT
-                        val isInlineLatex = originalInlineType == MarkdownProcessorType.INLINE_LATEX
-                        val tempInlineType =
-                            if (isInlineLatex) MarkdownProcessorType.PLAIN_TEXT else originalInlineType
-
-                        var childNode: MarkdownNode? = null
-
-                        inlineGroup.stream.collect { str ->
-                            val isCurrentCharNewline = str == "\n" || str == "\r\n" || str == "\r"
-                            if (isCurrentCharNewline) {
-                                lastCharWasNewline = true
-                                return@collect
-                            }
-
-                            if (childNode == null) {
-                                childNode = MarkdownNode(type = tempInlineType)
-                                newNode.children.add(childNode!!)
-                            }
-
-                            if (lastCharWasNewline) {
-                                if (newNode.content.isNotEmpty()) {
-                                    newNode.content + ("\n" + str)
-                                    childNode!!.content + ("\n" + str)
-                                } else {
-                                    newNode.content + str
-                                    childNode!!.content + str
-                                }
-                                lastCharWasNewline = false
-                            } else {
-                                newNode.content + str
-                                childNode!!.content + str
-                            }
-
-                            lastCharWasNewline = isCurrentCharNewline
-                        }
-
-                        if (isInlineLatex && childNode != null) {
-                            val latexContent = childNode!!.content.toString()
-                            val latexChildNode =
-                                MarkdownNode(type = MarkdownProcessorType.INLINE_LATEX, initialContent = latexContent)
-                            val childIndex = newNode.children.lastIndexOf(childNode)
-                            if (childIndex != -1) {
-                                newNode.children[childIndex] = latexChildNode
-                            }
-                        }
-
-                        if (childNode != null &&
-                            childNode!!.content.toString().trimAll().isEmpty() &&
-                            originalInlineType == MarkdownProcessorType.PLAIN_TEXT
-                        ) {
-                            val lastIndex = newNode.children.lastIndex
-                            if (lastIndex >= 0 && newNode.children[lastIndex] == childNode) {
-                                newNode.children.removeAt(lastIndex)
-                            }
-                        }
-                    }
-                } else {
-                    blockGroup.stream.collect { contentChunk ->
-                        newNode.content + contentChunk
-                    }
-                }
-
-                if (isLatexBlock) {
-                    val latexContent = newNode.content.toString()
-                    val latexNode =
-                        MarkdownNode(type = MarkdownProcessorType.BLOCK_LATEX, initialContent = latexContent)
-                    nodes[nodeIndex] = latexNode
-                }
-            }
+            interceptedStream.collectNativeMarkdownNested(
+                MarkdownNodeTreeBuilder(nodes),
+                flushIntervalMs = RENDER_INTERVAL_MS,
+            )
         } catch (e: Exception) {
             AppLogger.e(TAG, "【流渲染】Markdown流处理异常: ${e.message}", e)
         } finally {
@@ -465,107 +492,7 @@ fun StreamMarkdownRenderer(
             try {
                 val parsedNodes = mutableListOf<MarkdownNode>()
 
-                stream { emit(content) }.nativeMarkdownSplitByBlock().collect { blockGroup ->
-                    val blockType = blockGroup.tag ?: MarkdownProcessorType.PLAIN_TEXT
-
-                    if (blockType == MarkdownProcessorType.HORIZONTAL_RULE) {
-                        parsedNodes.add(MarkdownNode(type = blockType, initialContent = "---"))
-                        return@collect
-                    }
-
-                    val isLatexBlock = blockType == MarkdownProcessorType.BLOCK_LATEX
-                    val tempBlockType =
-                        if (isLatexBlock) MarkdownProcessorType.PLAIN_TEXT else blockType
-
-                    val isInlineContainer =
-                        tempBlockType != MarkdownProcessorType.CODE_BLOCK &&
-                            tempBlockType != MarkdownProcessorType.BLOCK_LATEX &&
-                            tempBlockType != MarkdownProcessorType.XML_BLOCK &&
-                            tempBlockType != MarkdownProcessorType.PLAN_EXECUTION
-
-                    val newNode = MarkdownNode(type = tempBlockType)
-                    parsedNodes.add(newNode)
-                    val nodeIndex = parsedNodes.lastIndex
-
-                    if (isInlineContainer) {
-                        val blockTextBuilder = StringBuilder()
-                        blockGroup.stream.collect { s ->
-                            blockTextBuilder.append(s)
-                        }
-                        val blockText = blockTextBuilder.toString()
-
-                        var lastCharWasNewline = false
-
-                        stream { emit(blockText) }.nativeMarkdownSplitByInline().collect { inlineGroup ->
-                            val originalInlineType = inlineGroup.tag ?: MarkdownProcessorType.PLAIN_TEXT
-                            val isInlineLatex = originalInlineType == MarkdownProcessorType.INLINE_LATEX
-                            val tempInlineType =
-                                if (isInlineLatex) MarkdownProcessorType.PLAIN_TEXT else originalInlineType
-
-                            var childNode: MarkdownNode? = null
-
-                            inlineGroup.stream.collect { str ->
-                                val isCurrentCharNewline = str == "\n" || str == "\r\n" || str == "\r"
-                                if (isCurrentCharNewline) {
-                                    lastCharWasNewline = true
-                                    return@collect
-                                }
-
-                                if (childNode == null) {
-                                    childNode = MarkdownNode(type = tempInlineType)
-                                    newNode.children.add(childNode!!)
-                                }
-
-                                if (lastCharWasNewline) {
-                                    if (newNode.content.isNotEmpty()) {
-                                        newNode.content + ("\n" + str)
-                                        childNode!!.content + ("\n" + str)
-                                    } else {
-                                        newNode.content + str
-                                        childNode!!.content + str
-                                    }
-                                    lastCharWasNewline = false
-                                } else {
-                                    newNode.content + str
-                                    childNode!!.content + str
-                                }
-
-                                lastCharWasNewline = isCurrentCharNewline
-                            }
-
-                            if (isInlineLatex && childNode != null) {
-                                val latexContent = childNode!!.content.toString()
-                                val latexChildNode =
-                                    MarkdownNode(type = MarkdownProcessorType.INLINE_LATEX, initialContent = latexContent)
-                                val childIndex = newNode.children.lastIndexOf(childNode)
-                                if (childIndex != -1) {
-                                    newNode.children[childIndex] = latexChildNode
-                                }
-                            }
-
-                            if (childNode != null &&
-                                childNode!!.content.toString().trimAll().isEmpty() &&
-                                originalInlineType == MarkdownProcessorType.PLAIN_TEXT
-                            ) {
-                                val lastIndex = newNode.children.lastIndex
-                                if (lastIndex >= 0 && newNode.children[lastIndex] == childNode) {
-                                    newNode.children.removeAt(lastIndex)
-                                }
-                            }
-                        }
-                    } else {
-                        blockGroup.stream.collect { contentChunk ->
-                            newNode.content + contentChunk
-                        }
-                    }
-
-                    if (isLatexBlock) {
-                        val latexContent = newNode.content.toString()
-                        val latexNode =
-                            MarkdownNode(type = MarkdownProcessorType.BLOCK_LATEX, initialContent = latexContent)
-                        parsedNodes[nodeIndex] = latexNode
-                    }
-                }
+                content.splitNativeMarkdownNested(MarkdownNodeTreeBuilder(parsedNodes))
 
                 // 移除解析耗时相关日志
 
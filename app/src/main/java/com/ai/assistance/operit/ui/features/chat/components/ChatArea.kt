@@ -70,31 +70,15 @@ import androidx.compose.ui.unit.Dp
 import androidx.compose.ui.draw.alpha
 import com.ai.assistance.operit.ui.features.chat.components.style.cursor.CursorStyleChatMessage
 import com.ai.assistance.operit.ui.features.chat.components.style.bubble.BubbleStyleChatMessage
-import com.ai.assistance.operit.util.ChatMarkupRegex
 import com.ai.assistance.operit.util.WaifuMessageProcessor
+import com.ai.assistance.operit.util.streamnative.NativeChatMarkup
 
 /**
  * 清理消息中的XML标签，保留Markdown格式和纯文本内容
  */
 private fun cleanXmlTags(content: String): String {
-    return content
-        // 移除状态标签
-        .replace(ChatMarkupRegex.statusTag, "")
-        .replace(ChatMarkupRegex.statusSelfClosingTag, "")
-        // 移除思考标签（包括 <think> 和 <thinking>）
-        .replace(ChatMarkupRegex.thinkTag, "")
-        .replace(ChatMarkupRegex.thinkSelfClosingTag, "")
-        // 移除搜索来源标签
-        .replace(ChatMarkupRegex.searchTag, "")
-        .replace(ChatMarkupRegex.searchSelfClosingTag, "")
-        // 移除工具标签
-        .replace(ChatMarkupRegex.toolTag, "")
-        .replace(ChatMarkupRegex.toolSelfClosingTag, "")
-        // 移除工具结果标签
-        .replace(ChatMarkupRegex.toolResultTag, "")
-        .replace(ChatMarkupRegex.toolResultSelfClosingTag, "")
-        // 移除emotion标签
-        .replace(ChatMarkupRegex.emotionTag, "")
+    // 一次扫描移除状态、思考（<think>/<thinking>）、搜索来源、工具、工具结果和emotion标签
+    return NativeChatMarkup.strip(content)
         // 移除其他常见的XML标签
         // .replace(Regex("<[^>]*>"), "")
         .trim()
@@ -33,6 +33,7 @@ import com.ai.assistance.operit.ui.common.markdown.DefaultXmlRenderer
 import com.ai.assistance.operit.ui.common.markdown.XmlContentRenderer
 import com.ai.assistance.operit.ui.common.rememberLocal
 import com.ai.assistance.operit.util.ChatMarkupRegex
+import com.ai.assistance.operit.util.streamnative.NativeXmlSplitter
 
 /** 支持多种 XML 标签的自定义渲染器 包含高效的前缀检测，直接解析标签类型 */
 class CustomXmlRenderer(
@@ -165,22 +166,6 @@ class CustomXmlRenderer(
         }
     }
 
-    /** 从工具调用XML提取参数内容 */
-    private fun extractParamsFromTool(content: String): Map<String, String> {
-        val params = mutableMapOf<String, String>()
-
-        // 查找所有参数标签
-        val matches = ChatMarkupRegex.toolParamPattern.findAll(content)
-
-        for (match in matches) {
-            val name = match.groupValues[1]
-            val value = match.groupValues[2].trim()
-            params[name] = value
-        }
-
-        return params
-    }
-
     /** 渲染 <search> 标签内容 (Google Search Grounding 来源) */
     @Composable
     private fun renderSearchContent(content: String, modifier: Modifier, textColor: Color) {
@@ -406,13 +391,10 @@ class CustomXmlRenderer(
     /** 渲染标准工具请求标签 <tool name="..."><param name="param_name">param_value</param></tool> */
     @Composable
     private fun renderToolRequest(content: String, modifier: Modifier, textColor: Color) {
-        // 提取工具名称
-        val nameRegex = "name=\"([^\"]+)\"".toRegex()
-        val nameMatch = nameRegex.find(content)
-        val toolName = nameMatch?.groupValues?.get(1) ?: "Unknown tool"
-
-        // 提取参数
-        val params = extractParamsFromTool(content)
+        // 工具名称和参数来自原生分割器的标签索引，无需正则
+        val toolCall = NativeXmlSplitter.parseToolCalls(content).firstOrNull()
+        val toolName = toolCall?.name ?: "Unknown tool"
+        val params = toolCall?.params?.associate { (name, value) -> name to value.trim() } ?: emptyMap()
 
         // 构建参数显示文本
         val paramText = extractContentFromXml(content, "tool").trim()
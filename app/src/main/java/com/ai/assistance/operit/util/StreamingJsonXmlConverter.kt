@@ -1,5 +1,7 @@
 package com.ai.assistance.operit.util
 
+import com.ai.assistance.operit.util.streamnative.NativeJsonXmlConverter
+
 /**
  * 流式 JSON 到 XML 的转换器
  * 专门用于将 Tool Call 的 arguments JSON 流增量转换为 XML 格式
@@ -15,200 +17,65 @@ class StreamingJsonXmlConverter {
         data class Content(val text: String) : Event()
     }
 
-    private enum class State {
-        WAIT_BRACE,      // 等待起始 {
-        WAIT_KEY_QUOTE,  // 等待 Key 的起始 "
-        READ_KEY,        // 读取 Key 内容
-        WAIT_COLON,      // 等待 :
-        WAIT_VALUE,      // 等待 Value
-        READ_STRING,     // 读取 String Value
-        READ_PRIMITIVE,  // 读取 Primitive Value
-        ESCAPE,          // 转义字符处理
-        UNICODE_ESCAPE,  // Unicode 转义
-        WAIT_COMMA       // 等待 , 或 }
-    }
-
-    private var state = State.WAIT_BRACE
-    private val buffer = StringBuilder()
-    private var unicodeCount = 0
-    private var primitiveNestingDepth = 0
-    private var primitiveInString = false
-    private var primitiveEscape = false
-    private var readingComplexValue = false
-
-    private fun resetPrimitiveTracking() {
-        primitiveNestingDepth = 0
-        primitiveInString = false
-        primitiveEscape = false
-        readingComplexValue = false
-    }
-
-    private fun emitPrimitiveParam(events: MutableList<Event>) {
-        events.add(Event.Content(escapeXml(buffer.toString())))
-        events.add(Event.Tag("</param>"))
-        buffer.setLength(0)
-        resetPrimitiveTracking()
-    }
+    private val state = NativeJsonXmlConverter.newState()
+    private val key = StringBuilder()
+    private val content = StringBuilder()
 
     /**
      * 处理 JSON 块并返回 XML 事件列表
+     * 相邻的内容合并为一个 Content 事件
      */
-    fun feed(chunk: String): List<Event> {
-        val events = mutableListOf<Event>()
-
-        for (c in chunk) {
-            when (state) {
-                State.WAIT_BRACE -> if (c == '{') state = State.WAIT_KEY_QUOTE
-                State.WAIT_KEY_QUOTE -> {
-                    if (c == '"') {
-                        state = State.READ_KEY
-                        buffer.setLength(0)
-                    } else if (c == '}') {
-                        // 对象结束
-                    }
-                }
-                State.READ_KEY -> {
-                    if (c == '"') {
-                        events.add(Event.Tag("\n  <param name=\"${buffer}\">"))
-                        state = State.WAIT_COLON
-                    } else {
-                        if (c != '\\') buffer.append(c)
-                    }
-                }
-                State.WAIT_COLON -> if (c == ':') state = State.WAIT_VALUE
-                State.WAIT_VALUE -> {
-                    if (!c.isWhitespace()) {
-                        if (c == '"') {
-                            state = State.READ_STRING
-                        } else {
-                            state = State.READ_PRIMITIVE
-                            buffer.setLength(0)
-                            buffer.append(c)
-                            readingComplexValue = c == '[' || c == '{'
-                            primitiveNestingDepth = if (readingComplexValue) 1 else 0
-                            primitiveInString = false
-                            primitiveEscape = false
-                        }
-                    }
-                }
-                State.READ_STRING -> {
-                    if (c == '"') {
-                        state = State.WAIT_COMMA
-                        events.add(Event.Tag("</param>"))
-                    } else if (c == '\\') {
-                        state = State.ESCAPE
-                    } else {
-                        events.add(Event.Content(escapeXml(c.toString())))
-                    }
-                }
-                State.ESCAPE -> {
-                    if (c == 'u') {
-                        state = State.UNICODE_ESCAPE
-                        unicodeCount = 0
-                        buffer.setLength(0)
-                    } else {
-                        val unescaped = when (c) {
-                            'n' -> "\n"
-                            'r' -> "\r"
-                            't' -> "\t"
-                            'b' -> "\b"
-                            'f' -> "\u000c"
-                            '\"' -> "\""
-                            '\\' -> "\\"
-                            '/' -> "/"
-                            else -> c.toString()
-                        }
-                        events.add(Event.Content(escapeXml(unescaped)))
-                        state = State.READ_STRING
-                    }
-                }
-                State.UNICODE_ESCAPE -> {
-                    buffer.append(c)
-                    unicodeCount++
-                    if (unicodeCount == 4) {
-                        try {
-                            val code = buffer.toString().toInt(16)
-                            events.add(Event.Content(escapeXml(code.toChar().toString())))
-                        } catch (_: Exception) { }
-                        state = State.READ_STRING
-                    }
-                }
-                State.READ_PRIMITIVE -> {
-                    if (readingComplexValue) {
-                        if (primitiveInString) {
-                            buffer.append(c)
-                            if (primitiveEscape) {
-                                primitiveEscape = false
-                            } else if (c == '\\') {
-                                primitiveEscape = true
-                            } else if (c == '"') {
-                                primitiveInString = false
-                            }
-                        } else {
-                            when (c) {
-                                '"' -> {
-                                    primitiveInString = true
-                                    buffer.append(c)
-                                }
-
-                                '[', '{' -> {
-                                    primitiveNestingDepth++
-                                    buffer.append(c)
-                                }
-
-                                ']', '}' -> {
-                                    primitiveNestingDepth--
-                                    buffer.append(c)
-
-                                    if (primitiveNestingDepth == 0) {
-                                        emitPrimitiveParam(events)
-                                        state = State.WAIT_COMMA
-                                    }
-                                }
+    fun feed(chunk: String): List<Event> = toEvents(chunk, NativeJsonXmlConverter.feed(state, chunk))
 
-                                else -> buffer.append(c)
-                            }
-                        }
-                    } else {
-                        if (c == ',' || c == '}' || c.isWhitespace()) {
-                            emitPrimitiveParam(events)
+    /**
+     * 刷新缓冲区，处理剩余的原始值
+     */
+    fun flush(): List<Event> = toEvents("", NativeJsonXmlConverter.flush(state))
 
-                            if (c == ',') state = State.WAIT_KEY_QUOTE
-                            else if (c == '}') state = State.WAIT_BRACE
-                            else state = State.WAIT_COMMA
-                        } else {
-                            buffer.append(c)
-                        }
-                    }
+    private fun toEvents(chunk: String, raw: IntArray): List<Event> {
+        val events = mutableListOf<Event>()
+        var i = 0
+        while (i + 2 < raw.size) {
+            val a = raw[i + 1]
+            val b = raw[i + 2]
+            when (raw[i]) {
+                NativeJsonXmlConverter.KEY -> key.append(chunk, a, b)
+                NativeJsonXmlConverter.PARAM_OPEN -> {
+                    flushContent(events)
+                    events.add(Event.Tag("\n  <param name=\"${key}\">"))
+                    key.setLength(0)
                 }
-                State.WAIT_COMMA -> {
-                    if (c == ',') state = State.WAIT_KEY_QUOTE
-                    else if (c == '}') state = State.WAIT_BRACE
+                NativeJsonXmlConverter.TEXT -> content.append(chunk, a, b)
+                NativeJsonXmlConverter.CHAR -> appendEscaped(a.toChar())
+                NativeJsonXmlConverter.PARAM_CLOSE -> {
+                    flushContent(events)
+                    events.add(Event.Tag("</param>"))
                 }
             }
+            i += 3
         }
+        flushContent(events)
         return events
     }
 
-    /**
-     * 刷新缓冲区，处理剩余的原始值
-     */
-    fun flush(): List<Event> {
-        val events = mutableListOf<Event>()
-        if (state == State.READ_PRIMITIVE && buffer.isNotEmpty()) {
-            emitPrimitiveParam(events)
+    private fun flushContent(events: MutableList<Event>) {
+        if (content.isNotEmpty()) {
+            events.add(Event.Content(content.toString()))
+            content.setLength(0)
         }
-        return events
     }
 
     /**
      * XML 转义辅助函数
      */
-    private fun escapeXml(text: String): String {
-        return text.replace("&", "&amp;")
-                .replace("<", "&lt;")
-                .replace(">", "&gt;")
-                .replace("\"", "&quot;")
-                .replace("'", "&apos;")
+    private fun appendEscaped(c: Char) {
+        when (c) {
+            '&' -> content.append("&amp;")
+            '<' -> content.append("&lt;")
+            '>' -> content.append("&gt;")
+            '"' -> content.append("&quot;")
+            '\'' -> content.append("&apos;")
+            else -> content.append(c)
+        }
     }
 }
@@ -6,6 +6,7 @@ import com.ai.assistance.operit.util.markdown.MarkdownProcessorType
 import com.ai.assistance.operit.util.markdown.NestedMarkdownProcessor
 import com.ai.assistance.operit.util.stream.splitBy as streamSplitBy
 import com.ai.assistance.operit.util.stream.stream
+import com.ai.assistance.operit.util.streamnative.NativeChatMarkup
 import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.runBlocking
 import java.io.File
@@ -169,24 +170,8 @@ object WaifuMessageProcessor {
      * 清理内容中的状态标签和XML标签，只保留纯文本
      */
     fun cleanContentForWaifu(content: String): String {
-        return content
-            // 移除状态标签
-            .replace(ChatMarkupRegex.statusTag, "")
-            .replace(ChatMarkupRegex.statusSelfClosingTag, "")
-            // 移除思考标签（包括 <think> 和 <thinking>）
-            .replace(ChatMarkupRegex.thinkTag, "")
-            .replace(ChatMarkupRegex.thinkSelfClosingTag, "")
-            // 移除搜索来源标签
-            .replace(ChatMarkupRegex.searchTag, "")
-            .replace(ChatMarkupRegex.searchSelfClosingTag, "")
-            // 移除工具标签
-            .replace(ChatMarkupRegex.toolTag, "")
-            .replace(ChatMarkupRegex.toolSelfClosingTag, "")
-            // 移除工具结果标签
-            .replace(ChatMarkupRegex.toolResultTag, "")
-            .replace(ChatMarkupRegex.toolResultSelfClosingTag, "")
-            // 移除emotion标签（因为已经在processEmotionTags中处理过了）
-            .replace(ChatMarkupRegex.emotionTag, "")
+        // 一次扫描移除状态、思考、搜索来源、工具、工具结果和emotion标签（emotion已经在processEmotionTags中处理过了）
+        return NativeChatMarkup.strip(content)
             
             // --- 新增：移除Markdown相关标记 ---
             // 1. 移除图片和链接，保留替代文本或链接文本
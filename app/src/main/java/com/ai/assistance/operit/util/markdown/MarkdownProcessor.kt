@@ -55,6 +55,9 @@ enum class MarkdownProcessorType {
 class MarkdownNode(val type: MarkdownProcessorType, initialContent: String = "") {
     val content: SmartString = SmartString(initialContent)
     val children: SnapshotStateList<MarkdownNode> = mutableStateListOf()
+
+    /** 块源文本的64位哈希（原生解析器填写，0表示未计算），可作为高亮/LaTeX渲染缓存的键 */
+    var contentHash: Long = 0L
 }
 
 @Stable
@@ -0,0 +1,55 @@
+package com.ai.assistance.operit.util.streamnative
+
+/**
+ * Native single-pass matcher for the tag-stripping patterns of
+ * [com.ai.assistance.operit.util.ChatMarkupRegex] (statusTag, thinkTag, toolTag and friends).
+ */
+object NativeChatMarkup {
+
+    init {
+        System.loadLibrary("streamnative")
+    }
+
+    // Must match the CHAT_MARKUP_* constants in ChatMarkupScanner.h.
+    const val STATUS = 0
+    const val STATUS_SELF = 1
+    const val THINK = 2
+    const val THINK_SELF = 3
+    const val SEARCH = 4
+    const val SEARCH_SELF = 5
+    const val TOOL = 6
+    const val TOOL_SELF = 7
+    const val TOOL_RESULT = 8
+    const val TOOL_RESULT_SELF = 9
+    const val EMOTION = 10
+
+    const val ALL = (1 shl 11) - 1
+    const val STATUS_TAGS = (1 shl STATUS) or (1 shl STATUS_SELF)
+    const val TOOL_TAGS = (1 shl TOOL) or (1 shl TOOL_SELF) or (1 shl TOOL_RESULT) or (1 shl TOOL_RESULT_SELF)
+
+    private external fun nativeScan(content: String, mask: Int): IntArray
+
+    /**
+     * Matches of the patterns in [mask] (bit `1 shl id` each) as (id, start, end) triples,
+     * leftmost first and non-overlapping.
+     */
+    fun scan(content: String, mask: Int = ALL): IntArray = nativeScan(content, mask)
+
+    /**
+     * [content] without the matches of the patterns in [mask]; the same as chaining
+     * `.replace(pattern, "")` over them for all but oddly interleaved tags.
+     */
+    fun strip(content: String, mask: Int = ALL): String {
+        if (content.indexOf('<') < 0) return content
+        val matches = nativeScan(content, mask)
+        if (matches.isEmpty()) return content
+        val out = StringBuilder(content.length)
+        var copied = 0
+        for (i in matches.indices step 3) {
+            out.append(content, copied, matches[i + 1])
+            copied = matches[i + 2]
+        }
+        out.append(content, copied, content.length)
+        return out.toString()
+    }
+}
@@ -0,0 +1,36 @@
+package com.ai.assistance.operit.util.streamnative
+
+/**
+ * Native state machine behind [com.ai.assistance.operit.util.StreamingJsonXmlConverter].
+ * The converter state lives in a caller-owned [IntArray] from [newState], so there is no
+ * native handle to release.
+ */
+object NativeJsonXmlConverter {
+
+    init {
+        System.loadLibrary("streamnative")
+    }
+
+    // Must match the JSON_XML_* constants and JsonXmlConverter::kStateInts in JsonXmlConverter.h.
+    const val KEY = 0
+    const val PARAM_OPEN = 1
+    const val TEXT = 2
+    const val CHAR = 3
+    const val PARAM_CLOSE = 4
+    private const val STATE_INTS = 7
+
+    private external fun nativeFeed(state: IntArray, chunk: String): IntArray
+    private external fun nativeFlush(state: IntArray): IntArray
+
+    fun newState(): IntArray = IntArray(STATE_INTS)
+
+    /**
+     * Advances [state] over [chunk] and returns its events as (type, a, b) triples: [KEY] and
+     * [TEXT] are the ranges [a, b) of [chunk], [CHAR] is the character a, and the rest carry
+     * no data.
+     */
+    fun feed(state: IntArray, chunk: String): IntArray = nativeFeed(state, chunk)
+
+    /** Closes a bare or nested value still open in [state]. */
+    fun flush(state: IntArray): IntArray = nativeFlush(state)
+}
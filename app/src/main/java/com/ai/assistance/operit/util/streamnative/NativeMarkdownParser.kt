@@ -2,6 +2,8 @@ package com.ai.assistance.operit.util.streamnative
 
 import com.ai.assistance.operit.util.markdown.MarkdownNode
 import com.ai.assistance.operit.util.markdown.MarkdownProcessorType
+import java.nio.ByteOrder
+import java.nio.CharBuffer
 
 object NativeMarkdownParser {
 
@@ -10,76 +12,118 @@ object NativeMarkdownParser {
     }
 
     private external fun nativeParseMarkdown(content: String): IntArray
+    private external fun nativeParseMarkdownDirect(buffer: CharBuffer, offset: Int, length: Int): IntArray
+    private external fun nativeSetParseThreads(threads: Int)
+    private external fun nativeCreateIncrementalParser(): Long
+    private external fun nativeDestroyIncrementalParser(handle: Long)
+    private external fun nativeAppend(handle: Long, delta: String): IntArray
+
+    /**
+     * Threads [parseToNodes] may use for documents of 64K chars and more (capped at the core
+     * count). Defaults to 1: each parse starts its threads anew, so only raise it where
+     * measurements on the target devices show a gain.
+     */
+    fun setParseThreads(threads: Int) = nativeSetParseThreads(threads)
+
+    fun parseToNodes(content: String): List<MarkdownNode> =
+        decodeNodes(content, nativeParseMarkdown(content))
+
+    /**
+     * Same as [parseToNodes] for text held in a direct, native-order [CharBuffer]; the
+     * remaining chars are parsed in place, without an input copy.
+     */
+    fun parseToNodes(content: CharBuffer): List<MarkdownNode> {
+        require(content.isDirect && content.order() == ByteOrder.nativeOrder()) {
+            "parseToNodes needs a direct CharBuffer in native byte order"
+        }
+        return decodeNodes(content, nativeParseMarkdownDirect(content, content.position(), content.remaining()))
+    }
 
-    fun parseToNodes(content: String): List<MarkdownNode> {
-        val data = nativeParseMarkdown(content)
-        if (data.isEmpty()) return emptyList()
-
-        var idx = 0
-        val blockCount = data[idx++]
-        val nodes = ArrayList<MarkdownNode>(blockCount)
+    /**
+     * Append-only parser handle for a message that keeps growing. Each [append] reparses
+     * natively only from the first block that can still change, and only those blocks are
+     * decoded again; [nodes] always matches [parseToNodes] of the whole text.
+     */
+    class IncrementalParser internal constructor(
+        private val handle: Long,
+    ) {
+        private val content = StringBuilder()
+        private val nodes = ArrayList<MarkdownNode>()
+
+        fun append(delta: String): List<MarkdownNode> {
+            content.append(delta)
+            val data = nativeAppend(handle, delta)
+            if (data.isEmpty()) return nodes
+
+            val kept = data[0]
+            while (nodes.size > kept) {
+                nodes.removeAt(nodes.size - 1)
+            }
+            decodeNodes(content, data, from = 1, nodes = nodes)
+            return nodes
+        }
 
-        repeat(blockCount) {
-            if (idx >= data.size) return@repeat
+        fun destroy() = nativeDestroyIncrementalParser(handle)
+    }
 
-            val blockTypeOrdinal = data[idx++]
-            val blockType =
-                MarkdownProcessorType.entries.getOrNull(blockTypeOrdinal)
+    fun createIncrementalParser(): IncrementalParser = IncrementalParser(nativeCreateIncrementalParser())
+
+    /**
+     * Decodes rows in the flattenMarkdownNodes format (MarkdownParser.h) starting at [from]:
+     * a count, then the types, piece starts, piece ends and parent rows, one column each,
+     * then two ints (low, high) per block for [MarkdownNode.contentHash].
+     */
+    private fun decodeNodes(
+        content: CharSequence,
+        data: IntArray,
+        from: Int = 0,
+        nodes: MutableList<MarkdownNode> = ArrayList(),
+    ): List<MarkdownNode> {
+        if (data.size <= from) return nodes
+
+        val count = data[from]
+        val types = from + 1
+        val starts = types + count
+        val ends = starts + count
+        val parents = ends + count
+        val hashes = parents + count
+        if (count < 0 || hashes > data.size) return nodes
+
+        var block: MarkdownNode? = null
+        var blockIndex = 0
+        for (row in 0 until count) {
+            val type =
+                MarkdownProcessorType.entries.getOrNull(data[types + row])
                     ?: MarkdownProcessorType.PLAIN_TEXT
-
-            val node = MarkdownNode(blockType)
-
-            if (idx >= data.size) {
-                nodes.add(node)
-                return@repeat
-            }
-
-            val blockPieceCount = data[idx++]
-            repeat(blockPieceCount) {
-                if (idx + 1 >= data.size) return@repeat
-                val start = data[idx++]
-                val end = data[idx++]
-                if (start >= 0 && end >= start && end <= content.length) {
-                    node.content + content.substring(start, end)
+            val start = data[starts + row]
+            val end = data[ends + row]
+            val valid = start >= 0 && end >= start && end <= content.length
+
+            if (data[parents + row] < 0) {
+                val node = MarkdownNode(type)
+                val hash = hashes + blockIndex * 2
+                if (hash + 1 < data.size) {
+                    node.contentHash = (data[hash].toLong() and 0xffffffffL) or (data[hash + 1].toLong() shl 32)
                 }
-            }
-
-            if (idx >= data.size) {
+                blockIndex++
                 nodes.add(node)
-                return@repeat
-            }
-
-            val inlineCount = data[idx++]
-            repeat(inlineCount) {
-                if (idx >= data.size) return@repeat
-                val inlineTypeOrdinal = data[idx++]
-                val inlineType =
-                    MarkdownProcessorType.entries.getOrNull(inlineTypeOrdinal)
-                        ?: MarkdownProcessorType.PLAIN_TEXT
-
-                if (idx >= data.size) return@repeat
-                val inlinePieceCount = data[idx++]
-
-                val child = MarkdownNode(inlineType)
-                var hasAnyPiece = false
-                repeat(inlinePieceCount) {
-                    if (idx + 1 >= data.size) return@repeat
-                    val start = data[idx++]
-                    val end = data[idx++]
-                    if (start >= 0 && end >= start && end <= content.length) {
-                        val s = content.substring(start, end)
-                        child.content + s
-                        node.content + s
-                        hasAnyPiece = true
-                    }
-                }
-
-                if (hasAnyPiece) {
-                    node.children.add(child)
+                block = node
+                // A block with inline rows gets its content from them.
+                val hasInlines = row + 1 < count && data[parents + row + 1] == row
+                if (!hasInlines && valid) {
+                    node.content + content.subSequence(start, end).toString()
                 }
+                continue
             }
 
-            nodes.add(node)
+            val parent = block ?: continue
+            if (valid) {
+                val s = content.subSequence(start, end).toString()
+                val child = MarkdownNode(type)
+                child.content + s
+                parent.content + s
+                parent.children.add(child)
+            }
         }
 
         return nodes
@@ -1,23 +1,275 @@
 package com.ai.assistance.operit.util.streamnative
 
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
 object NativeMarkdownSplitter {
 
     init {
         System.loadLibrary("streamnative")
     }
 
+    // Must match the RING_* constants in StreamOperators.h.
+    private const val RING_READ_INDEX = 2
+    private const val RING_HEADER_INTS = 4
+    private const val DEFAULT_RING_CAPACITY = 256
+
+    // Must match the WIRE_* constants and SEG_BREAK in StreamOperators.h.
+    private const val WIRE_GAP = 0x40
+    private const val WIRE_BREAK = 0x80
+    private const val WIRE_ESCAPE = 0xff
+    private const val SEG_BREAK = -1
+    private const val DEFAULT_WIRE_CAPACITY = 1024
+
+    /**
+     * Segment type that follows each closed group when [Session.setBlockHashes] is on:
+     * (SEG_BLOCK_HASH, low, high), see [blockHash]. Must match SEG_BLOCK_HASH in
+     * StreamOperators.h.
+     */
+    const val SEG_BLOCK_HASH = -4
+
+    // Segment types of [createJsonSession]; must match the JSON_* constants in StreamOperators.h.
+    const val JSON_TEXT = 0
+    const val JSON_OBJECT_START = 1
+    const val JSON_OBJECT_END = 2
+    const val JSON_ARRAY_START = 3
+    const val JSON_ARRAY_END = 4
+    const val JSON_KEY = 5
+    const val JSON_VALUE = 6
+
     private external fun nativeCreateBlockSession(): Long
     private external fun nativeCreateInlineSession(): Long
+    private external fun nativeCreateNestedSession(): Long
+    private external fun nativeCreateJsonSession(): Long
     private external fun nativeDestroySession(handle: Long)
     private external fun nativePush(handle: Long, chunk: String): IntArray
+    private external fun nativeAttachRing(handle: Long, ring: ByteBuffer, capacity: Int): Boolean
+    private external fun nativePushToRing(handle: Long, chunk: String): Int
+    private external fun nativeDrainRing(handle: Long): Int
+    private external fun nativePushCompact(handle: Long, chunk: String, out: ByteBuffer): Int
+    private external fun nativeCopyCompact(handle: Long, out: ByteBuffer): Int
+    private external fun nativeSaveState(handle: Long): ByteArray?
+    private external fun nativeRestoreState(handle: Long, state: ByteArray): Boolean
+    private external fun nativeSnapshotOffset(state: ByteArray): Int
+    private external fun nativeSetBlockHashes(handle: Long, enabled: Boolean): Boolean
+    private external fun nativeSetAttemptLimit(handle: Long, chars: Int): Boolean
+    private external fun nativeSetCheckpointInterval(handle: Long, intervalChars: Int)
+    private external fun nativeCheckpointAt(handle: Long, offset: Int): ByteArray?
+    private external fun nativeGetStats(handle: Long): LongArray?
+
+    // Longs per plugin in nativeGetStats' result, after pushes and pushNanos.
+    private const val STATS_PLUGIN_LONGS = 10
+
+    /**
+     * Parse state of a session after its first [offset] characters. Restoring it into a
+     * session of the same kind and pushing `text.substring(offset)` continues exactly where
+     * the original left off; segments the original already returned are not replayed.
+     */
+    class Checkpoint internal constructor(
+        val offset: Int,
+        val state: ByteArray,
+    )
+
+    /** Work done by one plugin of a session; see PluginStats in StreamOperators.h. */
+    data class PluginStats(
+        val tag: Int,
+        val charsEvaluated: Long,
+        val charsConsumedInBulk: Long,
+        val tryingEntries: Long,
+        val tryingRejections: Long,
+        val longestEvaluation: Long,
+        val waitforConfirmed: Long,
+        val waitforRejected: Long,
+        val pendingReplays: Long,
+        val lookaheadAbandons: Long,
+    )
+
+    data class SessionStats(
+        val pushes: Long,
+        val pushNanos: Long,
+        val plugins: List<PluginStats>,
+    )
 
     class Session internal constructor(
         private val handle: Long,
     ) {
+        private var ring: ByteBuffer? = null
+        private var ringMask = 0
+        private var wire: ByteBuffer? = null
+        private var wireCursor = 0
+        private var wirePos = 0
+
         fun push(chunk: String): IntArray = nativePush(handle, chunk)
+
+        /**
+         * Pushes [chunk] and hands each resulting (type, start, end) triple to [onSegment]
+         * straight from a direct buffer shared with the native session, so no array is
+         * allocated per push. The ring is attached on first use.
+         */
+        fun pushSegments(chunk: String, onSegment: (type: Int, start: Int, end: Int) -> Unit) {
+            val buffer = ring ?: attachRing()
+            var published = nativePushToRing(handle, chunk)
+            while (published > 0) {
+                var read = buffer.getInt(RING_READ_INDEX * 4)
+                repeat(published) {
+                    val base = (RING_HEADER_INTS + (read and ringMask) * 3) * 4
+                    onSegment(buffer.getInt(base), buffer.getInt(base + 4), buffer.getInt(base + 8))
+                    read++
+                }
+                buffer.putInt(RING_READ_INDEX * 4, read)
+                // Segments that did not fit are published once room is freed.
+                published = nativeDrainRing(handle)
+            }
+        }
+
+        /**
+         * Same callbacks as [pushSegments], but the segments cross JNI in the compact wire
+         * format (a tag byte and varints per run, starts implied) and are decoded here from a
+         * reused direct buffer.
+         */
+        fun pushCompact(chunk: String, onSegment: (type: Int, start: Int, end: Int) -> Unit) {
+            var buffer = wire ?: ByteBuffer.allocateDirect(DEFAULT_WIRE_CAPACITY).also { wire = it }
+            var size = nativePushCompact(handle, chunk, buffer)
+            if (size < 0) {
+                buffer = ByteBuffer.allocateDirect(Integer.highestOneBit(-size) * 2)
+                wire = buffer
+                size = nativeCopyCompact(handle, buffer)
+            }
+            decodeCompact(buffer, size, onSegment)
+        }
+
+        private fun decodeCompact(buffer: ByteBuffer, size: Int, onSegment: (type: Int, start: Int, end: Int) -> Unit) {
+            wirePos = 0
+            var cursor = wireCursor
+            while (wirePos < size) {
+                val tag = buffer.get(wirePos++).toInt() and 0xff
+                when {
+                    tag == WIRE_BREAK -> onSegment(SEG_BREAK, cursor, cursor)
+                    tag == WIRE_ESCAPE -> {
+                        val type = readWireInt(buffer)
+                        val start = readWireInt(buffer)
+                        onSegment(type, start, cursor + readWireInt(buffer))
+                    }
+                    else -> {
+                        val start = if (tag and WIRE_GAP != 0) cursor + readWireInt(buffer) else cursor
+                        val end = start + readWireUInt(buffer)
+                        cursor = end
+                        onSegment(tag and (WIRE_GAP - 1), start, end)
+                    }
+                }
+            }
+            wireCursor = cursor
+        }
+
+        private fun readWireUInt(buffer: ByteBuffer): Int {
+            var value = 0
+            var shift = 0
+            while (true) {
+                val b = buffer.get(wirePos++).toInt()
+                value = value or ((b and 0x7f) shl shift)
+                if (b and 0x80 == 0) return value
+                shift += 7
+            }
+        }
+
+        private fun readWireInt(buffer: ByteBuffer): Int {
+            val v = readWireUInt(buffer)
+            return (v ushr 1) xor -(v and 1)
+        }
+
+        /** Snapshot of everything pushed so far. */
+        fun saveState(): Checkpoint? {
+            val state = nativeSaveState(handle) ?: return null
+            return Checkpoint(nativeSnapshotOffset(state), state)
+        }
+
+        /**
+         * Replaces this session's parse state with [checkpoint]'s. Returns false, leaving the
+         * session as if freshly created, if the checkpoint comes from another kind of session.
+         */
+        fun restoreState(checkpoint: Checkpoint): Boolean {
+            // The native side restarts its compact cursor at 0 as well.
+            wireCursor = 0
+            return nativeRestoreState(handle, checkpoint.state)
+        }
+
+        /**
+         * Follows every group a break closes with a [SEG_BLOCK_HASH] segment carrying the
+         * hash of the group's content, independent of chunking, to key render caches by.
+         * Only possible before the first push; returns false afterwards.
+         */
+        fun setBlockHashes(enabled: Boolean): Boolean = nativeSetBlockHashes(handle, enabled)
+
+        /**
+         * Longest link, image, fence info string or XML start tag, in characters, the session
+         * waits on before showing it as plain text (16K by default, 0 for no limit).
+         * Only possible before the first push; returns false afterwards.
+         */
+        fun setAttemptLimit(chars: Int): Boolean = nativeSetAttemptLimit(handle, chars)
+
+        /**
+         * Records a checkpoint each time another [intervalChars] characters have been pushed;
+         * 0 stops recording and drops the recorded ones.
+         */
+        fun setCheckpointInterval(intervalChars: Int) = nativeSetCheckpointInterval(handle, intervalChars)
+
+        /** Latest recorded checkpoint at or before [offset], or null if there is none. */
+        fun checkpointAt(offset: Int): Checkpoint? {
+            val state = nativeCheckpointAt(handle, offset) ?: return null
+            return Checkpoint(nativeSnapshotOffset(state), state)
+        }
+
+        /**
+         * Counters since the session was created, or null if the native library was built
+         * without STREAMNATIVE_ENABLE_STATS.
+         */
+        fun getStats(): SessionStats? {
+            val raw = nativeGetStats(handle) ?: return null
+            val plugins = (2 until raw.size step STATS_PLUGIN_LONGS).map { i ->
+                PluginStats(
+                    tag = raw[i].toInt(),
+                    charsEvaluated = raw[i + 1],
+                    charsConsumedInBulk = raw[i + 2],
+                    tryingEntries = raw[i + 3],
+                    tryingRejections = raw[i + 4],
+                    longestEvaluation = raw[i + 5],
+                    waitforConfirmed = raw[i + 6],
+                    waitforRejected = raw[i + 7],
+                    pendingReplays = raw[i + 8],
+                    lookaheadAbandons = raw[i + 9],
+                )
+            }
+            return SessionStats(raw[0], raw[1], plugins)
+        }
+
         fun destroy() = nativeDestroySession(handle)
+
+        private fun attachRing(): ByteBuffer {
+            val buffer =
+                ByteBuffer.allocateDirect((RING_HEADER_INTS + DEFAULT_RING_CAPACITY * 3) * 4)
+                    .order(ByteOrder.nativeOrder())
+            check(nativeAttachRing(handle, buffer, DEFAULT_RING_CAPACITY)) {
+                "nativeAttachRing failed"
+            }
+            ring = buffer
+            ringMask = DEFAULT_RING_CAPACITY - 1
+            return buffer
+        }
     }
 
+    /** The 64-bit hash of a [SEG_BLOCK_HASH] segment from its start and end fields. */
+    fun blockHash(start: Int, end: Int): Long = (start.toLong() and 0xffffffffL) or (end.toLong() shl 32)
+
     fun createBlockSession(): Session = Session(nativeCreateBlockSession())
     fun createInlineSession(): Session = Session(nativeCreateInlineSession())
+
+    /** Block session that also splits inline containers; see [NativeMarkdownNestedHandler]. */
+    fun createNestedSession(): Session = Session(nativeCreateNestedSession())
+
+    /**
+     * Session that finds JSON objects and arrays in the stream. Segments are the text around
+     * them ([JSON_TEXT]), their braces and brackets, and each finished key or value
+     * ([JSON_KEY], [JSON_VALUE]; strings without their quotes).
+     */
+    fun createJsonSession(): Session = Session(nativeCreateJsonSession())
 }
@@ -18,6 +18,145 @@ import kotlinx.coroutines.delay
 private fun Int.toMarkdownTypeOrNull(): MarkdownProcessorType? =
     MarkdownProcessorType.entries.getOrNull(this)
 
+// Must match NEST_BLOCK_OPEN / NEST_BLOCK_CLOSE in StreamOperators.h.
+private const val NEST_BLOCK_OPEN = -2
+private const val NEST_BLOCK_CLOSE = -3
+
+/**
+ * Receives the output of a nested native session: block groups and, inside them, inline
+ * runs as ranges of the content collected so far.
+ */
+interface NativeMarkdownNestedHandler {
+    fun openBlock(type: MarkdownProcessorType)
+
+    /** Inline run of a container block, or raw content of a code, XML, plan or rule block. */
+    fun appendRun(type: MarkdownProcessorType, content: CharSequence, start: Int, end: Int)
+
+    /** Boundary between two inline groups of the current block. */
+    fun breakInline()
+
+    fun closeBlock()
+}
+
+private class NestedSegmentDispatcher(private val handler: NativeMarkdownNestedHandler) {
+    private var blockOpen = false
+
+    fun dispatch(content: CharSequence, type: Int, start: Int, end: Int) {
+        when {
+            type == NEST_BLOCK_OPEN -> {
+                blockOpen = true
+                handler.openBlock(start.toMarkdownTypeOrNull() ?: MarkdownProcessorType.PLAIN_TEXT)
+            }
+            type == NEST_BLOCK_CLOSE -> {
+                blockOpen = false
+                handler.closeBlock()
+            }
+            type < 0 -> handler.breakInline()
+            start in 0..end && end <= content.length ->
+                handler.appendRun(type.toMarkdownTypeOrNull() ?: MarkdownProcessorType.PLAIN_TEXT, content, start, end)
+        }
+    }
+
+    /** Closes the last block group at the end of the input. */
+    fun finish() {
+        if (blockOpen) {
+            blockOpen = false
+            handler.closeBlock()
+        }
+    }
+}
+
+/**
+ * Splits a complete text into blocks and inline groups in one native pass.
+ */
+fun String.splitNativeMarkdownNested(handler: NativeMarkdownNestedHandler) {
+    val session = NativeMarkdownSplitter.createNestedSession()
+    try {
+        val dispatcher = NestedSegmentDispatcher(handler)
+        session.pushSegments(this) { type, start, end -> dispatcher.dispatch(this, type, start, end) }
+        dispatcher.finish()
+    } finally {
+        session.destroy()
+    }
+}
+
+/**
+ * Streaming counterpart of [splitNativeMarkdownNested]: characters are batched as in
+ * [nativeMarkdownSplitByBlock], and one native push yields both the block and the inline
+ * split, so only ranges (not characters) travel through Kotlin.
+ */
+suspend fun Stream<Char>.collectNativeMarkdownNested(
+    handler: NativeMarkdownNestedHandler,
+    flushIntervalMs: Long? = null,
+    maxDeltaChars: Int? = null,
+    debugTag: String = "NativeMarkdownNestedSplit",
+) {
+    val upstream = this
+    val session = NativeMarkdownSplitter.createNestedSession()
+    val dispatcher = NestedSegmentDispatcher(handler)
+    val fullContent = StringBuilder()
+    val deltaBuffer = StringBuilder()
+
+    val mutex = Mutex()
+    val flushMutex = Mutex()
+
+    suspend fun flushDelta() {
+        flushMutex.withLock {
+            mutex.withLock {
+                if (deltaBuffer.isEmpty()) return
+                val delta = deltaBuffer.toString()
+                deltaBuffer.setLength(0)
+                session.pushSegments(delta) { type, start, end ->
+                    dispatcher.dispatch(fullContent, type, start, end)
+                }
+            }
+        }
+    }
+
+    try {
+        coroutineScope {
+            val flushJob =
+                if (flushIntervalMs != null && flushIntervalMs > 0) {
+                    launch {
+                        while (true) {
+                            delay(flushIntervalMs)
+                            flushDelta()
+                        }
+                    }
+                } else {
+                    null
+                }
+
+            try {
+                upstream.collect { c ->
+                    val noBatching = flushIntervalMs == null && maxDeltaChars == null
+                    val shouldFlush =
+                        mutex.withLock {
+                            fullContent.append(c)
+                            deltaBuffer.append(c)
+
+                            c == '\n' ||
+                                (maxDeltaChars != null && maxDeltaChars > 0 && deltaBuffer.length >= maxDeltaChars)
+                        }
+
+                    if (noBatching || shouldFlush) {
+                        flushDelta()
+                    }
+                }
+                flushDelta()
+                mutex.withLock { dispatcher.finish() }
+            } finally {
+                flushJob?.cancel()
+            }
+        }
+    } catch (e: Exception) {
+        StreamLogger.e(debugTag, "collectNativeMarkdownNested failed: ${e.message}", e)
+        throw e
+    } finally {
+        session.destroy()
+    }
+}
+
 private fun Stream<Char>.nativeMarkdownSplitBySession(
     sessionFactory: () -> NativeMarkdownSplitter.Session,
     debugTag: String,
@@ -91,33 +230,25 @@ private fun Stream<Char>.nativeMarkdownSplitBySession(
                                 }
                             } ?: return
 
-                            val segments = session.push(delta)
-                            if (segments.isEmpty()) return
-
                             data class Action(val type: MarkdownProcessorType?, val text: String?)
 
-                            val actions = ArrayList<Action>(segments.size / 3)
+                            val actions = ArrayList<Action>()
                             mutex.withLock {
-                                var i = 0
-                                while (i + 2 < segments.size) {
-                                    val typeOrdinal = segments[i]
-                                    val start = segments[i + 1]
-                                    val end = segments[i + 2]
-                                    i += 3
-
+                                session.pushSegments(delta) { typeOrdinal, start, end ->
                                     if (typeOrdinal < 0) {
                                         actions.add(Action(type = null, text = null))
-                                        continue
+                                        return@pushSegments
                                     }
 
                                     val type = typeOrdinal.toMarkdownTypeOrNull() ?: MarkdownProcessorType.PLAIN_TEXT
                                     if (start < 0 || end < 0 || start > end || end > fullContent.length) {
-                                        continue
+                                        return@pushSegments
                                     }
 
                                     actions.add(Action(type = type, text = fullContent.substring(start, end)))
                                 }
                             }
+                            if (actions.isEmpty()) return
 
                             for (action in actions) {
                                 if (action.type == null) {
@@ -282,33 +413,25 @@ private fun Stream<String>.nativeMarkdownSplitBySessionString(
                                 }
                             } ?: return
 
-                            val segments = session.push(delta)
-                            if (segments.isEmpty()) return
-
                             data class Action(val type: MarkdownProcessorType?, val text: String?)
 
-                            val actions = ArrayList<Action>(segments.size / 3)
+                            val actions = ArrayList<Action>()
                             mutex.withLock {
-                                var i = 0
-                                while (i + 2 < segments.size) {
-                                    val typeOrdinal = segments[i]
-                                    val start = segments[i + 1]
-                                    val end = segments[i + 2]
-                                    i += 3
-
+                                session.pushSegments(delta) { typeOrdinal, start, end ->
                                     if (typeOrdinal < 0) {
                                         actions.add(Action(type = null, text = null))
-                                        continue
+                                        return@pushSegments
                                     }
 
                                     val type = typeOrdinal.toMarkdownTypeOrNull() ?: MarkdownProcessorType.PLAIN_TEXT
                                     if (start < 0 || end < 0 || start > end || end > fullContent.length) {
-                                        continue
+                                        return@pushSegments
                                     }
 
                                     actions.add(Action(type = type, text = fullContent.substring(start, end)))
                                 }
                             }
+                            if (actions.isEmpty()) return
 
                             for (action in actions) {
                                 if (action.type == null) {
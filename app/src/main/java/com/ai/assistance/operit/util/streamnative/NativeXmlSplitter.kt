@@ -1,5 +1,8 @@
 package com.ai.assistance.operit.util.streamnative
 
+import java.nio.ByteOrder
+import java.nio.CharBuffer
+
 object NativeXmlSplitter {
 
     init {
@@ -7,11 +10,151 @@ object NativeXmlSplitter {
     }
 
     private external fun nativeSplitXmlSegments(content: String): IntArray
+    private external fun nativeSplitXmlSegmentsDirect(buffer: CharBuffer, offset: Int, length: Int): IntArray
+    private external fun nativeSplitXmlIndexed(content: String): IntArray
+    private external fun nativeCreateSession(): Long
+    private external fun nativeDestroySession(handle: Long)
+    private external fun nativePush(handle: Long, chunk: String): IntArray
+    private external fun nativeFinish(handle: Long): IntArray
 
-    fun splitXmlTag(content: String): List<List<String>> {
-        val results = mutableListOf<List<String>>()
+    /**
+     * [splitXmlTag] for a message that arrives in chunks; each character is scanned once.
+     * [push] returns only what the chunk finalized: tags once their end tag arrives and
+     * text up to where a tag may still begin, so one text run can come back in several
+     * pieces. [finish] returns what is still open and starts a new message.
+     */
+    class Session internal constructor(
+        private val handle: Long,
+    ) {
+        private val text = StringBuilder()
+
+        fun push(chunk: String): List<List<String>> {
+            text.append(chunk)
+            return toTagList(text, nativePush(handle, chunk))
+        }
+
+        fun finish(): List<List<String>> {
+            val tags = toTagList(text, nativeFinish(handle))
+            text.setLength(0)
+            return tags
+        }
+
+        fun destroy() = nativeDestroySession(handle)
+    }
+
+    fun createSession(): Session = Session(nativeCreateSession())
+
+    // Entry types of nativeSplitXmlIndexed's index; must match XML_INDEX_* in StreamOperators.h.
+    private const val XML_INDEX_TAG = 0
+    private const val XML_INDEX_ATTR_NAME = 1
+    private const val XML_INDEX_ATTR_VALUE = 2
+    private const val XML_INDEX_CHILD = 3
+    private const val XML_INDEX_CHILD_CONTENT = 4
+    private const val XML_INDEX_CONTENT = 5
+
+    /**
+     * A `<tool name="...">` block of a message. [params] are its closed `<param name="...">`
+     * children in order, values as written (not trimmed or unescaped); [start] and [end]
+     * bound the whole block in the message. [closed] is false while `</tool>` is missing,
+     * as in a reply that is still streaming.
+     */
+    data class ToolCall(
+        val name: String,
+        val params: List<Pair<String, String>>,
+        val start: Int,
+        val end: Int,
+        val closed: Boolean,
+    )
+
+    /**
+     * The tool calls of [content], read from the offset index the native splitter builds in
+     * its single pass (tag name, attributes, child elements), so no regex runs over the text.
+     */
+    fun parseToolCalls(content: String): List<ToolCall> {
+        val flat = nativeSplitXmlIndexed(content)
+        if (flat.isEmpty()) return emptyList()
+        val calls = mutableListOf<ToolCall>()
+        var segment = 1
+        val segmentsEnd = 1 + flat[0] * 3
+        var i = segmentsEnd
+
+        // State of the block being decoded.
+        var blockStart = 0
+        var blockEnd = 0
+        var isTool = false
+        var closed = false
+        var toolName: String? = null
+        val params = mutableListOf<Pair<String, String>>()
+        var child: String? = null
+        var childName: String? = null
+        var attr: String? = null
+
+        fun flushBlock() {
+            val name = toolName
+            if (isTool && name != null) {
+                calls.add(ToolCall(name, params.toList(), blockStart, blockEnd, closed))
+            }
+        }
 
-        val segments = nativeSplitXmlSegments(content)
+        while (i + 2 < flat.size) {
+            val type = flat[i]
+            val text = content.substring(flat[i + 1], flat[i + 2])
+            i += 3
+            when (type) {
+                XML_INDEX_TAG -> {
+                    flushBlock()
+                    // Each block has exactly one TAG entry; advance to that block's segment.
+                    while (segment < segmentsEnd && flat[segment] != 1) segment += 3
+                    blockStart = flat[segment + 1]
+                    blockEnd = flat[segment + 2]
+                    segment += 3
+                    isTool = text == "tool"
+                    closed = false
+                    toolName = null
+                    params.clear()
+                    child = null
+                    attr = null
+                }
+                XML_INDEX_ATTR_NAME -> attr = text
+                XML_INDEX_ATTR_VALUE -> {
+                    if (attr == "name") {
+                        if (child == null) toolName = text else childName = text
+                    }
+                    attr = null
+                }
+                XML_INDEX_CHILD -> {
+                    child = text
+                    childName = null
+                    attr = null
+                }
+                XML_INDEX_CHILD_CONTENT -> {
+                    val paramName = childName
+                    if (child == "param" && paramName != null) params.add(paramName to text)
+                }
+                XML_INDEX_CONTENT -> closed = true
+            }
+        }
+        flushBlock()
+        return calls
+    }
+
+    fun splitXmlTag(content: String): List<List<String>> =
+        toTagList(content, nativeSplitXmlSegments(content))
+
+    /**
+     * Same as [splitXmlTag] for text held in a direct, native-order [CharBuffer] (for
+     * example a reused `ByteBuffer.allocateDirect(...).order(ByteOrder.nativeOrder()).asCharBuffer()`).
+     * The remaining chars are scanned in place, without an input copy.
+     */
+    fun splitXmlTag(content: CharBuffer): List<List<String>> {
+        require(content.isDirect && content.order() == ByteOrder.nativeOrder()) {
+            "splitXmlTag needs a direct CharBuffer in native byte order"
+        }
+        return toTagList(content, nativeSplitXmlSegmentsDirect(content, content.position(), content.remaining()))
+    }
+
+    private fun toTagList(content: CharSequence, segments: IntArray): List<List<String>> {
+        val results = mutableListOf<List<String>>()
         if (segments.isEmpty()) return results
 
         var i = 0
@@ -23,7 +166,7 @@ object NativeXmlSplitter {
 
             if (start < 0 || end < 0 || start > end || end > content.length) continue
 
-            val chunk = content.substring(start, end)
+            val chunk = content.subSequence(start, end).toString()
             if (type == 1) {
                 val tagNameMatch = Regex("<([a-zA-Z0-9_]+)[\\s>]").find(chunk)
                 val tagName = tagNameMatch?.groupValues?.getOrNull(1) ?: "unknown"
@@ -10,6 +10,8 @@
 
 #if defined(OPERIT_HAS_LLAMA_CPP) && OPERIT_HAS_LLAMA_CPP
 #include "llama.h"
+#include "StreamNativeCApi.h"
+#include <dlfcn.h>
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
@@ -235,6 +237,33 @@ Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jcla
     return JNI_FALSE;
 }
 
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_llama_LlamaNative_nativeIsStreamSplitAvailable(JNIEnv * env, jclass clazz) {
+    (void) env;
+    (void) clazz;
+    return JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStreamSplit(
+        JNIEnv * env,
+        jclass clazz,
+        jlong sessionPtr,
+        jstring prompt,
+        jint maxTokens,
+        jint sessionKind,
+        jobject callback
+) {
+    (void) env;
+    (void) clazz;
+    (void) sessionPtr;
+    (void) prompt;
+    (void) maxTokens;
+    (void) sessionKind;
+    (void) callback;
+    return JNI_FALSE;
+}
+
 #else
 
 namespace {
@@ -293,6 +322,21 @@ static int32_t tokenizeText(const llama_vocab * vocab, const std::string & text,
     return std::max<int32_t>(0, n);
 }
 
+// libstreamnative.so ships with the app; it is looked up at run time so
+// this library still loads without it.
+static const StreamNativeCApi * streamNativeApi() {
+    static const StreamNativeCApi * api = []() -> const StreamNativeCApi * {
+        void * lib = dlopen("libstreamnative.so", RTLD_NOW);
+        if (!lib) {
+            LOGI("streamnative not available: %s", dlerror());
+            return nullptr;
+        }
+        auto getApi = reinterpret_cast<StreamNativeGetCApiFn>(dlsym(lib, "streamnative_get_c_api"));
+        return getApi != nullptr ? getApi(STREAMNATIVE_C_API_VERSION) : nullptr;
+    }();
+    return api;
+}
+
 static bool tokenToPiece(const llama_vocab * vocab, llama_token token, std::string & out) {
     if (vocab == nullptr) return false;
     std::vector<char> buf;
@@ -538,14 +582,10 @@ Java_com_ai_assistance_llama_LlamaNative_nativeApplyChatTemplate(
     return bytesUtf8ToJstring(env, out);
 }
 
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jclass clazz, jlong sessionPtr, jstring prompt, jint maxTokens, jobject callback) {
-    (void) clazz;
-
-    if (sessionPtr == 0 || callback == nullptr) return JNI_FALSE;
-    auto * session = reinterpret_cast<LlamaSessionNative *>(sessionPtr);
-    if (!session->model || !session->ctx || !session->sampler) return JNI_FALSE;
-
+// Runs one generation and hands each new piece of UTF-8 text to onDelta,
+// which returns false to stop.
+template <typename OnDelta>
+static bool generate(JNIEnv * env, LlamaSessionNative * session, jstring prompt, jint maxTokens, OnDelta && onDelta) {
     session->cancel.store(false);
 
     // reset KV + sampler for a clean generation per request
@@ -562,12 +602,6 @@ Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jcla
     const std::string promptStr = jstringToString(env, prompt);
     const llama_vocab * vocab = llama_model_get_vocab(session->model);
 
-    // Resolve callback method
-    jclass cbCls = env->GetObjectClass(callback);
-    if (!cbCls) return JNI_FALSE;
-    jmethodID midOnToken = env->GetMethodID(cbCls, "onToken", "(Ljava/lang/String;)Z");
-    if (!midOnToken) return JNI_FALSE;
-
     // Tokenize prompt
     int32_t capacity = static_cast<int32_t>(promptStr.size()) + 8;
     std::vector<llama_token> promptTokens;
@@ -595,7 +629,7 @@ Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jcla
     }
     if (nPrompt <= 0) {
         LOGE("Tokenize prompt failed");
-        return JNI_FALSE;
+        return false;
     }
     promptTokens.resize(static_cast<size_t>(nPrompt));
 
@@ -605,7 +639,7 @@ Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jcla
     }
     if (promptTokens.empty()) {
         LOGE("Prompt tokenization resulted in only EOG/EOS tokens");
-        return JNI_FALSE;
+        return false;
     }
 
     int32_t n_past = 0;
@@ -621,7 +655,7 @@ Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jcla
     if (llama_model_has_encoder(session->model)) {
         if (llama_encode(session->ctx, batch) != 0) {
             LOGE("llama_encode failed");
-            return JNI_FALSE;
+            return false;
         }
 
         llama_token decoder_start_token_id = llama_model_decoder_start_token(session->model);
@@ -643,7 +677,7 @@ Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jcla
         } else {
             LOGE("llama_decode failed for prompt ret=%d", ret);
         }
-        return JNI_FALSE;
+        return false;
     }
 
     // n_past for subsequent single-token decoding
@@ -718,22 +752,8 @@ Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jcla
         }
         prevDecoded = decodedNow;
 
-        if (!delta.empty()) {
-            jstring jdelta = bytesUtf8ToJstring(env, delta);
-            if (jdelta == nullptr || env->ExceptionCheck()) {
-                env->ExceptionClear();
-            } else {
-                const jboolean keepGoing = env->CallBooleanMethod(callback, midOnToken, jdelta);
-                env->DeleteLocalRef(jdelta);
-                if (env->ExceptionCheck()) {
-                    env->ExceptionClear();
-                    LOGE("Java callback threw exception; stopping generation");
-                    break;
-                }
-                if (!keepGoing) {
-                    break;
-                }
-            }
+        if (!delta.empty() && !onDelta(delta)) {
+            break;
         }
 
         llama_token next = newToken;
@@ -751,13 +771,146 @@ Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jcla
                 break;
             }
             LOGE("llama_decode failed ret=%d", ret);
-            return JNI_FALSE;
+            return false;
         }
 
         n_past += 1;
     }
 
-    return JNI_TRUE;
+    return true;
+}
+
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStream(JNIEnv * env, jclass clazz, jlong sessionPtr, jstring prompt, jint maxTokens, jobject callback) {
+    (void) clazz;
+
+    if (sessionPtr == 0 || callback == nullptr) return JNI_FALSE;
+    auto * session = reinterpret_cast<LlamaSessionNative *>(sessionPtr);
+    if (!session->model || !session->ctx || !session->sampler) return JNI_FALSE;
+
+    // Resolve callback method
+    jclass cbCls = env->GetObjectClass(callback);
+    if (!cbCls) return JNI_FALSE;
+    jmethodID midOnToken = env->GetMethodID(cbCls, "onToken", "(Ljava/lang/String;)Z");
+    if (!midOnToken) return JNI_FALSE;
+
+    const bool ok = generate(env, session, prompt, maxTokens, [&](const std::string & delta) {
+        jstring jdelta = bytesUtf8ToJstring(env, delta);
+        if (jdelta == nullptr || env->ExceptionCheck()) {
+            env->ExceptionClear();
+            return true;
+        }
+        const jboolean keepGoing = env->CallBooleanMethod(callback, midOnToken, jdelta);
+        env->DeleteLocalRef(jdelta);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            LOGE("Java callback threw exception; stopping generation");
+            return false;
+        }
+        return keepGoing == JNI_TRUE;
+    });
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_llama_LlamaNative_nativeIsStreamSplitAvailable(JNIEnv * env, jclass clazz) {
+    (void) env;
+    (void) clazz;
+    return streamNativeApi() != nullptr ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_ai_assistance_llama_LlamaNative_nativeGenerateStreamSplit(
+        JNIEnv * env,
+        jclass clazz,
+        jlong sessionPtr,
+        jstring prompt,
+        jint maxTokens,
+        jint sessionKind,
+        jobject callback
+) {
+    (void) clazz;
+
+    if (sessionPtr == 0 || callback == nullptr) return JNI_FALSE;
+    auto * session = reinterpret_cast<LlamaSessionNative *>(sessionPtr);
+    if (!session->model || !session->ctx || !session->sampler) return JNI_FALSE;
+
+    const StreamNativeCApi * api = streamNativeApi();
+    if (api == nullptr) return JNI_FALSE;
+
+    jclass cbCls = env->GetObjectClass(callback);
+    if (!cbCls) return JNI_FALSE;
+    jmethodID midOnDelta = env->GetMethodID(cbCls, "onDelta", "(Ljava/lang/String;[II)Z");
+    if (!midOnDelta) return JNI_FALSE;
+
+    StreamNativeSession * splitter = api->createMarkdownSession(sessionKind);
+    if (splitter == nullptr) return JNI_FALSE;
+
+    // Reused across deltas; the callback must copy what it keeps.
+    jintArray segmentArray = nullptr;
+    jsize segmentCapacity = 0;
+
+    // Hands one push's (or the final flush's) text and segments to the callback.
+    auto deliver = [&](int32_t count, const uint16_t * text, int32_t textLen, const int32_t * segments) {
+        if (count < 0 || textLen == 0) {
+            // Only part of a multi-byte character so far (or nothing left to flush).
+            return true;
+        }
+        const jsize ints = static_cast<jsize>(count) * 3;
+        if (segmentArray == nullptr || ints > segmentCapacity) {
+            if (segmentArray != nullptr) env->DeleteLocalRef(segmentArray);
+            segmentCapacity = std::max<jsize>(ints, 192);
+            segmentArray = env->NewIntArray(segmentCapacity);
+            if (segmentArray == nullptr) {
+                env->ExceptionClear();
+                return false;
+            }
+        }
+        if (ints > 0) {
+            env->SetIntArrayRegion(segmentArray, 0, ints, reinterpret_cast<const jint *>(segments));
+        }
+        jstring jdelta = env->NewString(reinterpret_cast<const jchar *>(text), static_cast<jsize>(textLen));
+        if (jdelta == nullptr || env->ExceptionCheck()) {
+            env->ExceptionClear();
+            return true;
+        }
+        const jboolean keepGoing = env->CallBooleanMethod(callback, midOnDelta, jdelta, segmentArray, static_cast<jint>(count));
+        env->DeleteLocalRef(jdelta);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            LOGE("Java callback threw exception; stopping generation");
+            return false;
+        }
+        return keepGoing == JNI_TRUE;
+    };
+
+    const bool ok = generate(env, session, prompt, maxTokens, [&](const std::string & delta) {
+        const uint16_t * text = nullptr;
+        int32_t textLen = 0;
+        const int32_t * segments = nullptr;
+        const int32_t count = api->pushUtf8(
+                splitter,
+                reinterpret_cast<const uint8_t *>(delta.data()),
+                static_cast<int32_t>(delta.size()),
+                &text,
+                &textLen,
+                &segments
+        );
+        return deliver(count, text, textLen, segments);
+    });
+    if (ok) {
+        // Generation can stop inside a multi-byte character; its bytes become U+FFFD.
+        const uint16_t * text = nullptr;
+        int32_t textLen = 0;
+        const int32_t * segments = nullptr;
+        const int32_t count = api->flushUtf8(splitter, &text, &textLen, &segments);
+        deliver(count, text, textLen, segments);
+    }
+
+    if (segmentArray != nullptr) env->DeleteLocalRef(segmentArray);
+    api->destroySession(splitter);
+    return ok ? JNI_TRUE : JNI_FALSE;
 }
 
 #endif
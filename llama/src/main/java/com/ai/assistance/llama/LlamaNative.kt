@@ -46,7 +46,37 @@ object LlamaNative {
         callback: GenerationCallback
     ): Boolean
 
+    /** Whether libstreamnative can be loaded for [nativeGenerateStreamSplit]. */
+    @JvmStatic external fun nativeIsStreamSplitAvailable(): Boolean
+
+    /**
+     * Like [nativeGenerateStream], but each delta is also pushed through a
+     * streamnative markdown session of [sessionKind] (see [SplitGenerationCallback])
+     * inside the generation loop.
+     */
+    @JvmStatic
+    external fun nativeGenerateStreamSplit(
+        sessionPtr: Long,
+        prompt: String,
+        maxTokens: Int,
+        sessionKind: Int,
+        callback: SplitGenerationCallback
+    ): Boolean
+
     interface GenerationCallback {
         fun onToken(token: String): Boolean
     }
+
+    interface SplitGenerationCallback {
+        /**
+         * [segments] holds [segmentCount] (type, start, end) triples, offsets
+         * counted in chars of the whole generated text. The array is reused
+         * for the next delta.
+         */
+        fun onDelta(delta: String, segments: IntArray, segmentCount: Int): Boolean
+    }
+
+    const val SPLIT_SESSION_BLOCK = 0
+    const val SPLIT_SESSION_INLINE = 1
+    const val SPLIT_SESSION_NESTED = 2
 }
@@ -7,6 +7,9 @@ class LlamaSession private constructor(
     companion object {
         fun isAvailable(): Boolean = runCatching { LlamaNative.nativeIsAvailable() }.getOrDefault(false)
 
+        fun isStreamSplitAvailable(): Boolean =
+            isAvailable() && runCatching { LlamaNative.nativeIsStreamSplitAvailable() }.getOrDefault(false)
+
         fun getUnavailableReason(): String = runCatching { LlamaNative.nativeGetUnavailableReason() }
             .getOrDefault("llama.cpp backend unavailable")
 
@@ -57,6 +60,36 @@ class LlamaSession private constructor(
         )
     }
 
+    /**
+     * Generates with the markdown splitter running in the native loop: one
+     * callback per delta with its segments, instead of a token callback
+     * followed by a separate split call. Returns false without generating
+     * if libstreamnative is unavailable (see [isStreamSplitAvailable]).
+     */
+    fun generateStreamSplit(
+        prompt: String,
+        maxTokens: Int,
+        sessionKind: Int = LlamaNative.SPLIT_SESSION_BLOCK,
+        onDelta: (delta: String, segments: IntArray, segmentCount: Int) -> Boolean
+    ): Boolean {
+        val ptr: Long
+        synchronized(lock) {
+            checkValid()
+            ptr = sessionPtr
+        }
+
+        return LlamaNative.nativeGenerateStreamSplit(
+            ptr,
+            prompt,
+            maxTokens,
+            sessionKind,
+            object : LlamaNative.SplitGenerationCallback {
+                override fun onDelta(delta: String, segments: IntArray, segmentCount: Int): Boolean =
+                    onDelta(delta, segments, segmentCount)
+            }
+        )
+    }
+
     fun applyChatTemplate(
         roles: List<String>,
         contents: List<String>,